@@ -0,0 +1,751 @@
+/*
+ * bench.c
+ *
+ *  Host benchmark of the refresh pipeline, on top of the recording HAL.
+ *  For every workload it reports the time per operation and the HAL
+ *  traffic per refreshed frame. With -c it checks instead the driver
+ *  calls of the first frames of a few workloads against the expected ones,
+ *  exiting with 1 on a mismatch.
+ *
+ *  Usage: bench [-c] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "deasplay.h"
+#include "hal_record.h"
+#ifdef HAS_BITMAP
+#include "bitmap.h"
+#include "graphics.h"
+#endif
+
+typedef void (*t_bench_op)(uint32_t i);
+
+static const char bench_text[] = "The quick brown fox jumps over the lazy dog. ";
+
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_fill(char c)
+{
+    deasplay_coord_t line;
+    deasplay_coord_t chr;
+
+    for (line = 0; line < DEASPLAY_TEXT_LINES; line++)
+    {
+        display_set_cursor(line, 0);
+        for (chr = 0; chr < DEASPLAY_TEXT_CHARS; chr++)
+        {
+            display_write_char((uint8_t)c);
+        }
+    }
+}
+
+/* Workloads */
+
+static void bench_idle(uint32_t i)
+{
+    (void)i;
+    display_periodic();
+}
+
+static void bench_clock_digit(uint32_t i)
+{
+    display_set_cursor(0, DEASPLAY_TEXT_CHARS - 1U);
+    display_write_char((uint8_t)('0' + (i % 10U)));
+    display_periodic();
+}
+
+static void bench_full_rewrite(uint32_t i)
+{
+    bench_fill((i & 1U) ? 'A' : 'B');
+    display_periodic();
+}
+
+static void bench_stepped_rewrite(uint32_t i)
+{
+    static const t_display_budget budget = { 0U, 8U, 0U };
+
+    bench_fill((i & 1U) ? 'A' : 'B');
+    while (display_periodic_step(&budget) == false)
+    {
+    }
+}
+
+static void bench_scroll(uint32_t i)
+{
+    deasplay_coord_t chr;
+
+    display_set_cursor(0, 0);
+    for (chr = 0; chr < DEASPLAY_TEXT_CHARS; chr++)
+    {
+        display_write_char((uint8_t)bench_text[(i + chr) % (sizeof(bench_text) - 1U)]);
+    }
+    display_periodic();
+}
+
+/* the same text, scrolled in place */
+static void bench_marquee(uint32_t i)
+{
+    static t_display_marquee marquee = { 0, 0, DEASPLAY_TEXT_CHARS, bench_text, 0U, 0U, 0U };
+
+    if (i == 0U)
+    {
+        display_marquee_start(&marquee);
+    }
+    else
+    {
+        display_marquee_step(&marquee);
+    }
+    display_periodic();
+}
+
+/* the whole display shifted left, a new column coming in */
+static void bench_display_shift(uint32_t i)
+{
+    deasplay_coord_t line;
+
+    display_scroll(0, 0, DEASPLAY_TEXT_LINES, DEASPLAY_TEXT_CHARS, -1, 0);
+    for (line = 0; line < DEASPLAY_TEXT_LINES; line++)
+    {
+        display_set_cursor(line, DEASPLAY_TEXT_CHARS - 1U);
+        display_write_char((uint8_t)bench_text[(i + (line * 7U)) % (sizeof(bench_text) - 1U)]);
+    }
+    display_periodic();
+}
+
+static void bench_write_string(uint32_t i)
+{
+    static char str[DEASPLAY_TEXT_CHARS + 1U];
+
+    memset(str, (i & 1U) ? 'x' : 'y', DEASPLAY_TEXT_CHARS);
+    display_set_cursor(0, 0);
+    display_write_string(str);
+}
+
+/* the same length of text, decoded from UTF-8 */
+static void bench_write_utf8(uint32_t i)
+{
+    display_set_cursor(0, 0);
+    display_write_utf8((i & 1U) ? "Gr\xC3\xBC\xC3\x9F" "e: 21\xC2\xB0" "C \xC2\xB1\xC2\xBD \xE2\x82\xAC"
+                                : "Gr\xC3\xBC\xC3\x9F" "e: 22\xC2\xB0" "C \xC2\xB1\xC2\xBD \xE2\x82\xAC");
+}
+
+static void bench_write_number(uint32_t i)
+{
+    display_set_cursor(0, 0);
+    display_write_number((uint16_t)i, false);
+}
+
+/* four numeric readouts, changing every 16 ticks */
+#define BENCH_READOUTS  4U
+
+static uint16_t bench_values[BENCH_READOUTS];
+static t_display_field bench_fields[BENCH_READOUTS];
+
+static void bench_update_values(uint32_t i)
+{
+    uint8_t k;
+
+    for (k = 0; k < BENCH_READOUTS; k++)
+    {
+        bench_values[k] = (uint16_t)((i >> 4) + (k * 1000U));
+    }
+}
+
+static void bench_readouts(uint32_t i)
+{
+    uint8_t k;
+
+    bench_update_values(i);
+    for (k = 0; k < BENCH_READOUTS; k++)
+    {
+        display_set_cursor(k / 2U, (k % 2U) * 8U);
+        display_write_number(bench_values[k], true);
+    }
+    display_periodic();
+}
+
+static void bench_bound_fields(uint32_t i)
+{
+    bench_update_values(i);
+    display_periodic();
+}
+
+static void bench_fields_add(void)
+{
+    uint8_t k;
+
+    for (k = 0; k < BENCH_READOUTS; k++)
+    {
+        bench_fields[k].line = k / 2U;
+        bench_fields[k].chr = (k % 2U) * 8U;
+        bench_fields[k].format.width = 5U;
+        bench_fields[k].format.pad = '0';
+        bench_fields[k].kind = DISPLAY_FIELD_UNSIGNED;
+        bench_fields[k].source = &bench_values[k];
+        bench_fields[k].size = sizeof(bench_values[k]);
+        display_field_add(&bench_fields[k]);
+    }
+}
+
+static void bench_fields_remove(void)
+{
+    uint8_t k;
+
+    for (k = 0; k < BENCH_READOUTS; k++)
+    {
+        display_field_remove(&bench_fields[k]);
+    }
+}
+
+/* a pop-up opening and closing over a canvas twice the display size */
+static uint8_t bench_canvas[2U * DEASPLAY_TEXT_LINES * 2U * DEASPLAY_TEXT_CHARS];
+static uint8_t bench_popup_cells[DEASPLAY_TEXT_CHARS / 2U];
+static t_display_layer bench_base = { bench_canvas, 2U * DEASPLAY_TEXT_LINES, 2U * DEASPLAY_TEXT_CHARS, 0, 0, true };
+static t_display_layer bench_popup = { bench_popup_cells, 1U, DEASPLAY_TEXT_CHARS / 2U, 0, DEASPLAY_TEXT_CHARS / 4U, false };
+
+static void bench_popup_toggle(uint32_t i)
+{
+    /* display_clear() has wiped the canvas out */
+    if (i == 0U) display_layer_invalidate(DISPLAY_LAYER_BASE, 0, 0, bench_base.lines, bench_base.chars);
+    display_layer_show(DISPLAY_LAYER_OVERLAY, (i & 1U) != 0U);
+    display_periodic();
+}
+
+/* the viewport panning one line down and back up */
+static void bench_viewport(uint32_t i)
+{
+    if (i == 0U) display_layer_invalidate(DISPLAY_LAYER_BASE, 0, 0, bench_base.lines, bench_base.chars);
+    display_layer_move(DISPLAY_LAYER_BASE, (deasplay_coord_t)(i & 1U), 0);
+    display_periodic();
+}
+
+static void bench_layers_set(void)
+{
+    size_t k;
+
+    for (k = 0; k < sizeof(bench_canvas); k++)
+    {
+        bench_canvas[k] = (uint8_t)bench_text[k % (sizeof(bench_text) - 1U)];
+    }
+    memset(bench_popup_cells, '#', sizeof(bench_popup_cells));
+    display_layer_set(DISPLAY_LAYER_BASE, &bench_base);
+    display_layer_set(DISPLAY_LAYER_OVERLAY, &bench_popup);
+}
+
+static void bench_layers_unset(void)
+{
+    display_layer_set(DISPLAY_LAYER_OVERLAY, NULL);
+    display_layer_set(DISPLAY_LAYER_BASE, NULL);
+}
+
+#ifdef DISPLAY_HAS_CGRAM
+/* a bar graph filling up column by column: six glyphs, uploaded once */
+static void bench_bar_graph(uint32_t i)
+{
+    uint8_t rows[DEASPLAY_CGRAM_ROWS];
+    uint32_t level = i % ((DEASPLAY_TEXT_CHARS * DEASPLAY_CGRAM_COLS) + 1U);
+    uint32_t cols;
+    deasplay_coord_t chr;
+
+    display_set_cursor(1, 0);
+    for (chr = 0; chr < DEASPLAY_TEXT_CHARS; chr++)
+    {
+        cols = (level > (chr * DEASPLAY_CGRAM_COLS)) ? (level - (chr * DEASPLAY_CGRAM_COLS)) : 0U;
+        if (cols > DEASPLAY_CGRAM_COLS) cols = DEASPLAY_CGRAM_COLS;
+        memset(rows, (uint8_t)(((1U << DEASPLAY_CGRAM_COLS) - 1U) & ~((1U << (DEASPLAY_CGRAM_COLS - cols)) - 1U)), sizeof(rows));
+        (void)display_write_glyph(rows);
+    }
+    display_periodic();
+}
+
+static void bench_print_uploads(void)
+{
+    t_display_stats stats;
+
+    display_get_stats(&stats);
+    printf("custom characters: %lu uploads\n", (unsigned long)stats.glyph_uploads);
+}
+#endif
+
+#ifdef HAS_BITMAP
+static void bench_glyph(uint32_t i)
+{
+    bitmap_character((uint8_t)(' ' + (i % 95U)), &display_get_buffer()[(i % DEASPLAY_TEXT_CHARS) * 8U], 8U, FONT_5x8);
+}
+
+/* a 12x24 clock readout, seconds ticking */
+static void bench_big_digits(uint32_t i)
+{
+    char str[6];
+
+    str[0] = (char)('0' + ((i / 600U) % 6U));
+    str[1] = (char)('0' + ((i / 60U) % 10U));
+    str[2] = ':';
+    str[3] = (char)('0' + ((i / 10U) % 6U));
+    str[4] = (char)('0' + (i % 10U));
+    str[5] = '\0';
+    (void)graphics_text(display_get_context(), bitmap_font(FONT_12x24_DIGITS), 0, 4, str, BITMAP_ROP_COPY);
+    display_periodic();
+}
+
+/* the same clock with the 5x8 font magnified 3 times, off the page grid */
+static void bench_scaled_clock(uint32_t i)
+{
+    char str[6];
+
+    str[0] = (char)('0' + ((i / 600U) % 6U));
+    str[1] = (char)('0' + ((i / 60U) % 10U));
+    str[2] = ':';
+    str[3] = (char)('0' + ((i / 10U) % 6U));
+    str[4] = (char)('0' + (i % 10U));
+    str[5] = '\0';
+    (void)graphics_text_scaled(display_get_context(), bitmap_font(FONT_5x8), 0, 5, str, 3U, BITMAP_ROP_COPY);
+    display_periodic();
+}
+
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+/* a bar graph drawn straight into the buffer, found by the shadow diff */
+static void bench_direct_draw(uint32_t i)
+{
+    uint8_t *b = display_get_buffer();
+    uint32_t level = i % DEASPLAY_CHARS;
+
+    memset(&b[3U * DEASPLAY_CHARS], 0xFF, level);
+    memset(&b[(3U * DEASPLAY_CHARS) + level], 0x00, DEASPLAY_CHARS - level);
+    display_flush();
+}
+#endif
+
+static void bench_print_cache(void)
+{
+    t_bitmap_cache_stats stats;
+
+    bitmap_cache_get_stats(&stats);
+    printf("glyph cache: %lu hits, %lu misses\n", (unsigned long)stats.hits, (unsigned long)stats.misses);
+}
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+/* queues holding a few operations: a refresh spans several of them */
+#define BENCH_ASYNC_QUEUE   (4U * sizeof(t_deasplay_async_op) + 8U)
+
+static uint8_t bench_queues[2][BENCH_ASYNC_QUEUE];
+
+/**
+ * Rewrite the display and refresh it through the small queues, resuming
+ * until it is clean, then compare what the driver got with the buffer.
+ * @return true if the display shows the buffer, written within the
+ *         refresh steps
+ */
+static bool bench_check_async(void)
+{
+    deasplay_coord_t line;
+    deasplay_coord_t chr;
+    uint32_t calls = 0U;
+
+    for (line = 0; line < DEASPLAY_TEXT_LINES; line++)
+    {
+        display_set_cursor(line, 0);
+        for (chr = 0; chr < DEASPLAY_TEXT_CHARS; chr++)
+        {
+            display_write_char((uint8_t)bench_text[(line * 7U) + chr]);
+        }
+    }
+    while (display_is_dirty())
+    {
+        display_periodic();
+        calls++;
+    }
+    printf("async queues of %u bytes: frame done in %u calls\n", (unsigned)BENCH_ASYNC_QUEUE, (unsigned)calls);
+    /* the driver got its writes between the state notifications */
+    if (hal_record_stats.unframed != 0U) return false;
+
+    return memcmp(hal_record_screen(), display_get_context()->buffer, DEASPLAY_TEXT_LINES * DEASPLAY_TEXT_CHARS) == 0;
+}
+
+#ifdef HAL_RECORD_DEFERRED
+/**
+ * Rewrite the display and refresh it while the transfers complete only
+ * every third step: the queue being filled meets the other one in flight,
+ * its hand-over waits for the next step after the completion, and a
+ * customized character finds both queues taken.
+ * @return true if the display ends up showing the buffer, the character
+ *         sent once the queues were free again
+ */
+static bool bench_check_deferred(void)
+{
+    static uint8_t bar[8] = { 0x1FU, 0x1FU, 0x1FU, 0x1FU, 0x1FU, 0x1FU, 0x1FU, 0x1FU };
+    deasplay_coord_t line;
+    deasplay_coord_t chr;
+    uint32_t step = 0U;
+    uint32_t refused = 0U;
+    bool extended = false;
+
+    hal_record_reset();
+    for (line = 0; line < DEASPLAY_TEXT_LINES; line++)
+    {
+        display_set_cursor(line, 0);
+        for (chr = 0; chr < DEASPLAY_TEXT_CHARS; chr++)
+        {
+            display_write_char((uint8_t)bench_text[(line * 5U) + chr]);
+        }
+    }
+    do
+    {
+        /* the steps in between find both queues taken */
+        if ((step % 3U) == 2U) (void)hal_record_complete();
+        display_periodic();
+        /* once the first queue is in flight */
+        if ((step > 0U) && (extended == false))
+        {
+            extended = display_set_extended(0U, bar, sizeof(bar));
+            if (extended == false) refused++;
+        }
+        step++;
+    }
+    while (display_is_dirty() || (extended == false));
+    /* the last queues */
+    while (hal_record_complete())
+    {
+        display_periodic();
+    }
+    printf("deferred transfers: frame done in %u steps, customized character refused %u times\n",
+           (unsigned)step, (unsigned)refused);
+
+    return (refused != 0U) && (hal_record_stats.calls[HAL_RECORD_SET_EXTENDED] == 1U) &&
+           (hal_record_stats.unframed == 0U) &&
+           (memcmp(hal_record_screen(), display_get_context()->buffer, DEASPLAY_TEXT_LINES * DEASPLAY_TEXT_CHARS) == 0);
+}
+#endif
+#endif
+
+/* Checking mode */
+
+#if !defined(DISPLAY_HAS_ASYNC) && !defined(DISPLAY_HAS_BITMAP_SHADOW)
+/* frames checked per workload */
+#define BENCH_CHECK_FRAMES  3U
+#define BENCH_CHECK_EVENTS  64U
+
+/**< An expected driver call */
+typedef struct
+{
+    uint8_t call;       /**< e_hal_record_call */
+    uint16_t a;
+    uint16_t b;
+    const char *text;   /**< The characters sent, rendered with the 5x8 font in spans (NULL: none) */
+} t_bench_expect;
+
+#define BENCH_START             { HAL_RECORD_STATE, DEASPLAY_STATE_PERIODIC_START, 0U, NULL }
+#define BENCH_END               { HAL_RECORD_STATE, DEASPLAY_STATE_PERIODIC_END, 0U, NULL }
+#define BENCH_CURSOR(line, chr) { HAL_RECORD_SET_CURSOR, (line), (chr), NULL }
+#define BENCH_RUN(line, chr, text) { HAL_RECORD_WRITE_RUN, (line), (chr), (text) }
+#define BENCH_SPAN(page, x, text) { HAL_RECORD_WRITE_SPAN, (page), (x), (text) }
+
+#ifdef HAS_BITMAP
+static const t_bench_expect bench_expect_clock_digit[] =
+{
+    BENCH_START, BENCH_SPAN(0U, 120U, "0"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 120U, "1"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 120U, "2"), BENCH_END
+};
+
+static const t_bench_expect bench_expect_full_rewrite[] =
+{
+    BENCH_START, BENCH_SPAN(0U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_SPAN(1U, 0U, "BBBBBBBBBBBBBBBB"),
+    BENCH_SPAN(2U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_SPAN(3U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 0U, "AAAAAAAAAAAAAAAA"), BENCH_SPAN(1U, 0U, "AAAAAAAAAAAAAAAA"),
+    BENCH_SPAN(2U, 0U, "AAAAAAAAAAAAAAAA"), BENCH_SPAN(3U, 0U, "AAAAAAAAAAAAAAAA"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_SPAN(1U, 0U, "BBBBBBBBBBBBBBBB"),
+    BENCH_SPAN(2U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_SPAN(3U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_END
+};
+
+static const t_bench_expect bench_expect_scroll[] =
+{
+    /* a page goes out from the first to the last changed cell */
+    BENCH_START, BENCH_SPAN(0U, 0U, "The quick brown"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 0U, "he quick brown f"), BENCH_END,
+    BENCH_START, BENCH_SPAN(0U, 0U, "e quick brown fo"), BENCH_END
+};
+#else
+static const t_bench_expect bench_expect_clock_digit[] =
+{
+    BENCH_START, BENCH_CURSOR(0U, 15U), BENCH_RUN(0U, 15U, "0"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 15U), BENCH_RUN(0U, 15U, "1"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 15U), BENCH_RUN(0U, 15U, "2"), BENCH_END
+};
+
+static const t_bench_expect bench_expect_full_rewrite[] =
+{
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "BBBBBBBBBBBBBBBB"),
+    BENCH_CURSOR(1U, 0U), BENCH_RUN(1U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "AAAAAAAAAAAAAAAA"),
+    BENCH_CURSOR(1U, 0U), BENCH_RUN(1U, 0U, "AAAAAAAAAAAAAAAA"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "BBBBBBBBBBBBBBBB"),
+    BENCH_CURSOR(1U, 0U), BENCH_RUN(1U, 0U, "BBBBBBBBBBBBBBBB"), BENCH_END
+};
+
+static const t_bench_expect bench_expect_scroll[] =
+{
+    /* the spaces between the words are already on the screen */
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "The"), BENCH_CURSOR(0U, 4U), BENCH_RUN(0U, 4U, "quick"),
+    BENCH_CURSOR(0U, 10U), BENCH_RUN(0U, 10U, "brown"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "he quick brown f"), BENCH_END,
+    BENCH_START, BENCH_CURSOR(0U, 0U), BENCH_RUN(0U, 0U, "e quick brown fo"), BENCH_END
+};
+#endif
+
+/**
+ * The logged form of an expected call.
+ * @param expect    the expected call
+ * @param e         filled in
+ */
+static void bench_expected(const t_bench_expect *expect, t_hal_record_event *e)
+{
+#ifdef HAS_BITMAP
+    uint8_t pixels[DEASPLAY_CHARS];
+    size_t k;
+#endif
+
+    memset(e, 0, sizeof(*e));
+    e->call = expect->call;
+    e->a = expect->a;
+    e->b = expect->b;
+    if (expect->text == NULL) return;
+#ifdef HAS_BITMAP
+    if (expect->call == (uint8_t)HAL_RECORD_WRITE_SPAN)
+    {
+        /* the glyphs as the page shows them */
+        for (k = 0; (expect->text[k] != '\0') && (((k + 1U) * 8U) <= sizeof(pixels)); k++)
+        {
+            bitmap_character((uint8_t)expect->text[k], &pixels[k * 8U], 8U, FONT_5x8);
+        }
+        e->len = (uint16_t)(k * 8U);
+        e->sum = hal_record_sum(pixels, e->len);
+        return;
+    }
+#endif
+    e->len = (uint16_t)strlen(expect->text);
+    e->sum = hal_record_sum((const uint8_t*)expect->text, e->len);
+}
+
+/**
+ * Run the first frames of a workload and compare the driver calls with
+ * the expected ones.
+ * @param name      workload name
+ * @param op        the operation
+ * @param expect    the expected calls
+ * @param count     number of expected calls
+ * @return true if they match
+ */
+static bool bench_check(const char *name, t_bench_op op, const t_bench_expect *expect, size_t count)
+{
+    static t_hal_record_event logged[BENCH_CHECK_EVENTS];
+    t_hal_record_event e;
+    size_t n;
+    size_t k;
+    uint32_t i;
+
+    display_clear();
+    display_periodic();
+    hal_record_log(logged, BENCH_CHECK_EVENTS);
+    for (i = 0; i < BENCH_CHECK_FRAMES; i++)
+    {
+        op(i);
+    }
+    n = hal_record_logged();
+    hal_record_log(NULL, 0U);
+
+    for (k = 0; (k < n) && (k < count); k++)
+    {
+        bench_expected(&expect[k], &e);
+        if ((logged[k].call != e.call) || (logged[k].a != e.a) || (logged[k].b != e.b) ||
+            (logged[k].len != e.len) || (logged[k].sum != e.sum))
+        {
+            printf("%s: driver call %lu is %u (%u, %u, %u bytes, sum %04x), expected %u (%u, %u, %u bytes, sum %04x)\n",
+                   name, (unsigned long)k, logged[k].call, logged[k].a, logged[k].b, logged[k].len, logged[k].sum,
+                   e.call, e.a, e.b, e.len, e.sum);
+            return false;
+        }
+    }
+    if (n != count)
+    {
+        printf("%s: %lu driver calls, expected %lu\n", name, (unsigned long)n, (unsigned long)count);
+        return false;
+    }
+    printf("%-16s %lu driver calls as expected\n", name, (unsigned long)n);
+
+    return true;
+}
+
+/**
+ * Check the driver calls of the clock, rewrite and scroll workloads.
+ * @return the exit status
+ */
+static int bench_check_all(void)
+{
+    bool ok = true;
+
+    ok = bench_check("clock-digit", bench_clock_digit, bench_expect_clock_digit,
+                     sizeof(bench_expect_clock_digit) / sizeof(bench_expect_clock_digit[0])) && ok;
+    ok = bench_check("full-rewrite", bench_full_rewrite, bench_expect_full_rewrite,
+                     sizeof(bench_expect_full_rewrite) / sizeof(bench_expect_full_rewrite[0])) && ok;
+    ok = bench_check("scroll", bench_scroll, bench_expect_scroll,
+                     sizeof(bench_expect_scroll) / sizeof(bench_expect_scroll[0])) && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
+
+/**
+ * Run a workload and print its figures.
+ * @param name      workload name
+ * @param op        the operation to be timed
+ * @param iterations number of operations
+ */
+static void bench_run(const char *name, t_bench_op op, uint32_t iterations)
+{
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t i;
+    uint32_t calls = 0U;
+    uint32_t frames;
+    uint8_t c;
+    t_display_stats stats;
+
+    /* start from a known, refreshed, screen: with DISPLAY_HAS_ASYNC the
+     * clear takes a few calls */
+    display_clear();
+    while (display_is_dirty())
+    {
+        display_periodic();
+    }
+    hal_record_reset();
+    display_reset_stats();
+
+    start = bench_now();
+    for (i = 0; i < iterations; i++)
+    {
+        op(i);
+    }
+    elapsed = bench_now() - start;
+
+    for (c = 0; c < HAL_RECORD_CALLS; c++)
+    {
+        if (c != HAL_RECORD_STATE) calls += hal_record_stats.calls[c];
+    }
+    /* without refreshes (display_flush()) the figures are per operation */
+    frames = (hal_record_stats.frames != 0U) ? hal_record_stats.frames : iterations;
+    display_get_stats(&stats);
+
+    printf("%-16s %10.1f %12.2f %12.2f %12.2f %14.2f %14.2f\n", name,
+           (double)elapsed / (double)iterations,
+           (double)calls / (double)frames,
+           (double)hal_record_stats.commands / (double)frames,
+           (double)hal_record_stats.transactions / (double)frames,
+           (double)hal_record_stats.bus_bytes / (double)frames,
+           (double)stats.cells_scanned / (double)frames);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 100000U;
+    bool check = false;
+    int arg = 1;
+
+    if ((argc > arg) && (strcmp(argv[arg], "-c") == 0))
+    {
+        check = true;
+        arg++;
+    }
+    if (argc > arg) iterations = (uint32_t)strtoul(argv[arg], NULL, 0);
+
+    display_init();
+#ifdef DISPLAY_HAS_ASYNC
+    display_set_async(bench_queues[0], bench_queues[1], BENCH_ASYNC_QUEUE);
+#endif
+
+    if (check)
+    {
+#if !defined(DISPLAY_HAS_ASYNC) && !defined(DISPLAY_HAS_BITMAP_SHADOW)
+        return bench_check_all();
+#else
+        /* the calls are split by the queues or trimmed by the shadow */
+        printf("no expected driver calls for this build\n");
+        return EXIT_FAILURE;
+#endif
+    }
+
+#ifdef HAL_RECORD_DEFERRED
+    /* the workloads would wait forever for the transfers */
+    if (bench_check_deferred() == false)
+    {
+        printf("deferred transfers: the driver did not get the buffer within the refresh steps\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+#endif
+
+#ifdef HAS_BITMAP
+    printf("deasplay benchmark: %ux%u bitmap display, %u iterations\n", DEASPLAY_CHARS, DEASPLAY_LINES, (unsigned)iterations);
+#else
+    printf("deasplay benchmark: %ux%u character display, %u iterations\n", DEASPLAY_CHARS, DEASPLAY_LINES, (unsigned)iterations);
+#endif
+#if defined(HAL_RECORD_I2C) && defined(HAL_RECORD_NO_BATCH)
+    printf("I2C bus with control bytes, a transaction per HAL call\n");
+#elif defined(HAL_RECORD_I2C)
+    printf("I2C bus with control bytes, batched transactions\n");
+#endif
+    printf("%-16s %10s %12s %12s %12s %14s %14s\n", "workload", "ns/op", "calls/frame", "cmds/frame", "xfers/frame", "bus-bytes/frame", "scanned/frame");
+
+    bench_run("idle", bench_idle, iterations);
+    bench_run("clock-digit", bench_clock_digit, iterations);
+    bench_run("full-rewrite", bench_full_rewrite, iterations);
+    bench_run("stepped-rewrite", bench_stepped_rewrite, iterations);
+    bench_run("scroll", bench_scroll, iterations);
+    bench_run("marquee", bench_marquee, iterations);
+    bench_run("display-shift", bench_display_shift, iterations);
+    bench_run("write-string", bench_write_string, iterations);
+    bench_run("write-utf8", bench_write_utf8, iterations);
+    bench_run("write-number", bench_write_number, iterations);
+    bench_run("readouts", bench_readouts, iterations);
+    bench_fields_add();
+    bench_run("bound-fields", bench_bound_fields, iterations);
+    bench_fields_remove();
+    bench_layers_set();
+    bench_run("popup", bench_popup_toggle, iterations);
+    bench_run("viewport", bench_viewport, iterations);
+    bench_layers_unset();
+#ifdef DISPLAY_HAS_CGRAM
+    bench_run("bar-graph", bench_bar_graph, iterations);
+    bench_print_uploads();
+#endif
+#ifdef HAS_BITMAP
+    bench_run("glyph", bench_glyph, iterations);
+    bitmap_cache_clear();
+    bench_run("big-digits", bench_big_digits, iterations);
+    bench_run("scaled-clock", bench_scaled_clock, iterations);
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+    bench_run("direct-draw", bench_direct_draw, iterations);
+#endif
+    bench_print_cache();
+#endif
+#ifdef DISPLAY_HAS_ASYNC
+    if (bench_check_async() == false)
+    {
+        printf("async refresh: the driver did not get the buffer within the refresh steps\n");
+        return 1;
+    }
+#endif
+
+    return 0;
+}
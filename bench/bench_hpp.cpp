@@ -0,0 +1,177 @@
+/*
+ * bench_hpp.cpp
+ *
+ *  Host benchmark of the C++ front-end (deasplay.hpp) on top of the
+ *  recording HAL: the workloads of bench.c that apply to character
+ *  displays, on a 16x2 and on a 1x10 display living side by side.
+ *
+ *  Usage: bench_hpp [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* the recording HAL defines its optional calls before deasplay_hal.h */
+extern "C"
+{
+#include "hal_record.h"
+}
+#include "deasplay.hpp"
+
+/**< The recording HAL as a driver policy */
+struct Record : deasplay::HalDefaults<Record>
+{
+    static void init(void)
+    {
+        deasplay_hal_init();
+    }
+
+    static void set_cursor(uint8_t line, uint8_t chr)
+    {
+        deasplay_hal_set_cursor(line, chr);
+    }
+
+    static void write_char(uint8_t chr)
+    {
+        deasplay_hal_write_char(chr);
+    }
+
+    static void write_run(uint8_t line, uint8_t chr, const uint8_t *data, uint8_t len)
+    {
+        hal_record_write_run(line, chr, (uint8_t*)data, len);
+    }
+
+    static void state_callback(e_deasplay_state state)
+    {
+        hal_record_state(state);
+    }
+};
+
+typedef void (*t_bench_op)(uint32_t i);
+
+static const char bench_text[] = "The quick brown fox jumps over the lazy dog. ";
+
+static deasplay::Display<2U, 16U, deasplay::CharacterCell, Record> lcd;
+static deasplay::Display<1U, 10U, deasplay::CharacterCell, Record> vfd;
+
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+template <typename D>
+static void bench_fill(D &display, char c)
+{
+    unsigned line;
+    unsigned chr;
+
+    for (line = 0; line < D::lines; line++)
+    {
+        display.set_cursor((typename D::coord_t)line, 0U);
+        for (chr = 0; chr < D::chars; chr++)
+        {
+            display.write_char((uint8_t)c);
+        }
+    }
+}
+
+/* Workloads */
+
+static void bench_clock_digit(uint32_t i)
+{
+    lcd.set_cursor(0U, 15U);
+    lcd.write_char((uint8_t)('0' + (i % 10U)));
+    lcd.periodic();
+}
+
+static void bench_full_rewrite(uint32_t i)
+{
+    bench_fill(lcd, (i & 1U) ? 'A' : 'B');
+    lcd.periodic();
+}
+
+static void bench_scroll(uint32_t i)
+{
+    uint8_t chr;
+
+    lcd.set_cursor(0U, 0U);
+    for (chr = 0; chr < 16U; chr++)
+    {
+        lcd.write_char((uint8_t)bench_text[(i + chr) % (sizeof(bench_text) - 1U)]);
+    }
+    lcd.periodic();
+}
+
+static void bench_vfd_counter(uint32_t i)
+{
+    vfd.set_cursor(0U, 4U);
+    vfd.write_uint(i % 100000U, 6U, ' ');
+    vfd.periodic();
+}
+
+/**
+ * Run a workload and print its figures.
+ * @param name      workload name
+ * @param op        the operation to be timed
+ * @param iterations number of operations
+ */
+static void bench_run(const char *name, t_bench_op op, uint32_t iterations)
+{
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t i;
+    uint32_t calls = 0U;
+    uint32_t frames;
+    uint8_t c;
+
+    /* start from a known, refreshed, screen */
+    lcd.clear();
+    lcd.periodic();
+    vfd.clear();
+    vfd.periodic();
+    hal_record_reset();
+
+    start = bench_now();
+    for (i = 0; i < iterations; i++)
+    {
+        op(i);
+    }
+    elapsed = bench_now() - start;
+
+    for (c = 0; c < HAL_RECORD_CALLS; c++)
+    {
+        if (c != HAL_RECORD_STATE) calls += hal_record_stats.calls[c];
+    }
+    frames = (hal_record_stats.frames != 0U) ? hal_record_stats.frames : 1U;
+
+    printf("%-16s %10.1f %12.2f %12.2f %14.2f\n", name,
+           (double)elapsed / (double)iterations,
+           (double)calls / (double)frames,
+           (double)hal_record_stats.commands / (double)frames,
+           (double)hal_record_stats.bus_bytes / (double)frames);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 100000U;
+
+    if (argc > 1) iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+
+    lcd.init();
+    vfd.init();
+
+    printf("deasplay C++ benchmark: 16x2 and 10x1 character displays, %u iterations\n", (unsigned)iterations);
+    printf("%-16s %10s %12s %12s %14s\n", "workload", "ns/op", "calls/frame", "cmds/frame", "bus-bytes/frame");
+
+    bench_run("clock-digit", bench_clock_digit, iterations);
+    bench_run("full-rewrite", bench_full_rewrite, iterations);
+    bench_run("scroll", bench_scroll, iterations);
+    bench_run("vfd-counter", bench_vfd_counter, iterations);
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * deasplay_config.h
+ *
+ *  Configuration of the host benchmark build: the display is the
+ *  recording HAL, either a 16x2 character display or, with BENCH_BITMAP,
+ *  a 128x32 bitmap display.
+ */
+
+#ifndef DEASPLAY_CONFIG_H_
+#define DEASPLAY_CONFIG_H_
+
+#ifdef BENCH_BITMAP
+#define HAS_BITMAP
+#define BITMAP_HAS_FONT_12x24_DIGITS
+#define DEASPLAY_LINES      32U
+#define DEASPLAY_CHARS      128U
+#else
+#define DEASPLAY_LINES      2U
+#define DEASPLAY_CHARS      16U
+#endif
+
+/* the benchmark reports the library counters too */
+#define DISPLAY_HAS_STATS
+/* and compares bound fields with rewriting the numbers */
+#define DISPLAY_HAS_FIELDS
+/* and opens pop-ups over a larger canvas */
+#define DISPLAY_HAS_LAYERS
+/* and writes UTF-8 text */
+#define DISPLAY_HAS_UTF8
+#ifndef BENCH_BITMAP
+/* and draws a bar graph with custom characters */
+#define DISPLAY_HAS_CGRAM
+#endif
+
+#include "hal_record.h"
+
+#endif /* DEASPLAY_CONFIG_H_ */
@@ -0,0 +1,339 @@
+/*
+ * hal_record.c
+ *
+ *  Recording HAL: a stand-in display driver for host builds.
+ */
+
+#include <string.h>
+
+#include "deasplay.h"
+#include "hal_record.h"
+#ifdef HAL_RECORD_I2C
+#include "busbatch.h"
+#endif
+
+t_deasplay_delay_us hw_delay;
+
+#ifdef HAS_BITMAP
+static uint8_t hal_record_bitmap[(DEASPLAY_LINES / 8U) * DEASPLAY_CHARS];
+uint8_t *bitmap_buffer = hal_record_bitmap;
+#else
+uint8_t *bitmap_buffer = NULL;
+
+/* what the character display shows, and its address counter */
+static uint8_t hal_record_text[DEASPLAY_TEXT_LINES * DEASPLAY_TEXT_CHARS];
+static size_t hal_record_address;
+#endif
+
+t_hal_record_stats hal_record_stats;
+
+/* between START or RESUME and END or PAUSE */
+static bool hal_record_framed;
+
+static t_hal_record_event *hal_record_events;
+static size_t hal_record_size;
+static size_t hal_record_count;
+
+void hal_record_reset(void)
+{
+    memset(&hal_record_stats, 0, sizeof(hal_record_stats));
+    hal_record_count = 0U;
+}
+
+void hal_record_log(t_hal_record_event *log, size_t size)
+{
+    hal_record_events = log;
+    hal_record_size = size;
+    hal_record_count = 0U;
+}
+
+size_t hal_record_logged(void)
+{
+    return hal_record_count;
+}
+
+#ifndef HAS_BITMAP
+const uint8_t* hal_record_screen(void)
+{
+    return hal_record_text;
+}
+
+/**
+ * Put characters on the modelled display, at the address counter.
+ * @param data      the characters
+ * @param len       number of characters
+ */
+static void hal_record_show(const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (hal_record_address < sizeof(hal_record_text)) hal_record_text[hal_record_address] = data[i];
+        hal_record_address++;
+    }
+}
+#endif
+
+/**
+ * Fletcher-16 checksum of a block of data.
+ * @param data      the data (NULL: none)
+ * @param len       number of bytes
+ * @return the checksum
+ */
+uint16_t hal_record_sum(const uint8_t *data, size_t len)
+{
+    uint16_t sum1 = 0U;
+    uint16_t sum2 = 0U;
+    size_t i;
+
+    if (data == NULL) return 0U;
+    for (i = 0; i < len; i++)
+    {
+        sum1 = (uint16_t)((sum1 + data[i]) % 255U);
+        sum2 = (uint16_t)((sum2 + sum1) % 255U);
+    }
+    return (uint16_t)((sum2 << 8) | sum1);
+}
+
+static void hal_record(e_hal_record_call call, uint16_t a, uint16_t b, const uint8_t *data, uint16_t len)
+{
+    t_hal_record_event *e;
+
+    hal_record_stats.calls[call]++;
+    if ((hal_record_events != NULL) && (hal_record_count < hal_record_size))
+    {
+        e = &hal_record_events[hal_record_count++];
+        e->call = (uint8_t)call;
+        e->a = a;
+        e->b = b;
+        e->len = len;
+        e->sum = hal_record_sum(data, len);
+    }
+}
+
+#ifdef HAL_RECORD_I2C
+static uint8_t hal_record_bus_buffer[HAL_RECORD_I2C_BUFFER];
+static t_busbatch hal_record_bus;
+
+static void hal_record_transfer(e_busbatch_kind kind, const uint8_t *data, size_t len)
+{
+    (void)kind;
+    (void)data;
+    hal_record_stats.transactions++;
+    /* the address byte, start and stop conditions */
+    hal_record_stats.bus_bytes += (uint32_t)len + BUSBATCH_I2C_OVERHEAD;
+}
+#endif
+
+static void hal_record_data(const uint8_t *data, uint32_t len)
+{
+    hal_record_stats.data_bytes += len;
+#ifdef HAL_RECORD_I2C
+    busbatch_data(&hal_record_bus, data, len);
+#else
+    (void)data;
+    hal_record_stats.transactions++;
+    hal_record_stats.bus_bytes += len;
+#endif
+}
+
+static void hal_record_command(const uint8_t *cmd, uint32_t len)
+{
+    hal_record_stats.commands++;
+#ifdef HAL_RECORD_I2C
+    busbatch_command(&hal_record_bus, cmd, len);
+#else
+    (void)cmd;
+    hal_record_stats.transactions++;
+    hal_record_stats.bus_bytes += len;
+#endif
+}
+
+void deasplay_hal_init(void)
+{
+#ifdef HAL_RECORD_I2C
+    busbatch_init(&hal_record_bus, BUSBATCH_I2C_CONTROL, hal_record_bus_buffer, sizeof(hal_record_bus_buffer), hal_record_transfer);
+#endif
+    hal_record(HAL_RECORD_INIT, 0U, 0U, NULL, 0U);
+}
+
+void deasplay_hal_power(uint8_t state)
+{
+#ifdef HAS_BITMAP
+    uint8_t cmd = (state != 0U) ? 0xAFU : 0xAEU;
+#else
+    uint8_t cmd = (state != 0U) ? 0x0CU : 0x08U;
+#endif
+
+    hal_record(HAL_RECORD_POWER, (uint16_t)state, 0U, NULL, 0U);
+    hal_record_command(&cmd, 1U);
+}
+
+void deasplay_hal_set_cursor(uint16_t line, uint16_t chr)
+{
+#ifdef HAS_BITMAP
+    /* the glyphs are drawn into the bitmap: nothing goes to the panel */
+    hal_record(HAL_RECORD_SET_CURSOR, line, chr, NULL, 0U);
+#else
+    /* set DDRAM address */
+    uint8_t cmd = (uint8_t)(0x80U | ((line & 1U) << 6) | ((line >> 1) * DEASPLAY_TEXT_CHARS) | chr);
+
+    hal_record(HAL_RECORD_SET_CURSOR, line, chr, NULL, 0U);
+    hal_record_command(&cmd, 1U);
+    hal_record_address = ((size_t)line * DEASPLAY_TEXT_CHARS) + chr;
+#endif
+}
+
+void deasplay_hal_write_char(uint8_t chr)
+{
+    hal_record(HAL_RECORD_WRITE_CHAR, chr, 0U, &chr, 1U);
+    hal_record_data(&chr, 1U);
+#ifndef HAS_BITMAP
+    hal_record_show(&chr, 1U);
+#endif
+}
+
+void hal_record_write_run(uint16_t line, uint16_t chr, uint8_t *data, uint16_t len)
+{
+    hal_record(HAL_RECORD_WRITE_RUN, line, chr, data, len);
+    if (hal_record_framed == false) hal_record_stats.unframed++;
+    hal_record_data(data, len);
+#ifndef HAS_BITMAP
+    hal_record_address = ((size_t)line * DEASPLAY_TEXT_CHARS) + chr;
+    hal_record_show(data, len);
+#endif
+}
+
+void deasplay_hal_cursor_visibility(bool visible)
+{
+    uint8_t cmd = visible ? 0x0EU : 0x0CU;
+
+    hal_record(HAL_RECORD_CURSOR_VISIBILITY, visible ? 1U : 0U, 0U, NULL, 0U);
+    hal_record_command(&cmd, 1U);
+}
+
+void deasplay_hal_set_extended(uint8_t id, uint8_t *data, uint8_t len)
+{
+    /* set CGRAM address */
+    uint8_t cmd = (uint8_t)(0x40U | ((id & 7U) << 3));
+
+    hal_record(HAL_RECORD_SET_EXTENDED, id, 0U, data, len);
+    hal_record_command(&cmd, 1U);
+    hal_record_data(data, len);
+}
+
+void display_hal_write_buffer(uint16_t x_rect, uint16_t y_rect)
+{
+    /* column and page ranges covering the panel */
+    static const uint8_t cmd[6] = { 0x21U, 0U, (uint8_t)(DEASPLAY_CHARS - 1U), 0x22U, 0U, (uint8_t)(((DEASPLAY_LINES + 7U) / 8U) - 1U) };
+    uint32_t len = (bitmap_buffer != NULL) ? ((uint32_t)(DEASPLAY_LINES / 8U) * DEASPLAY_CHARS) : 0U;
+
+    hal_record(HAL_RECORD_WRITE_BUFFER, x_rect, y_rect, bitmap_buffer, (uint16_t)len);
+    hal_record_command(cmd, sizeof(cmd));
+    hal_record_data(bitmap_buffer, len);
+}
+
+void hal_record_write_span(uint16_t page, uint16_t x, uint8_t *data, uint16_t len)
+{
+    /* page, lower and higher column nibble */
+    uint8_t cmd[3];
+
+    cmd[0] = (uint8_t)(0xB0U | page);
+    cmd[1] = (uint8_t)(x & 0x0FU);
+    cmd[2] = (uint8_t)(0x10U | (x >> 4));
+    hal_record(HAL_RECORD_WRITE_SPAN, page, x, data, len);
+    if (hal_record_framed == false) hal_record_stats.unframed++;
+    hal_record_command(cmd, sizeof(cmd));
+    hal_record_data(data, len);
+}
+
+bool hal_record_scroll(uint16_t line, uint16_t chr, uint16_t lines, uint16_t chars, int8_t dx, int8_t dy)
+{
+#ifdef HAS_BITMAP
+    /* the SSD1306 scrolls continuously, it cannot move by a given amount */
+    (void)line;
+    (void)chr;
+    (void)lines;
+    (void)chars;
+    (void)dx;
+    (void)dy;
+    return false;
+#else
+    /* display shift: the whole panel moves along the lines, one position
+     * per command */
+    uint8_t cmd = (dx < 0) ? 0x18U : 0x1CU;
+    uint8_t n = (uint8_t)((dx < 0) ? -dx : dx);
+    uint8_t *row;
+    uint8_t i;
+
+    if ((line != 0U) || (chr != 0U) || (lines != DEASPLAY_TEXT_LINES) || (chars != DEASPLAY_TEXT_CHARS) || (dy != 0)) return false;
+
+    hal_record(HAL_RECORD_SCROLL, line, chr, NULL, chars);
+    for (i = 0; i < n; i++)
+    {
+        hal_record_command(&cmd, 1U);
+    }
+
+    /* the uncovered positions show characters off the screen */
+    if (n > DEASPLAY_TEXT_CHARS) n = DEASPLAY_TEXT_CHARS;
+    for (row = hal_record_text; row < &hal_record_text[sizeof(hal_record_text)]; row += DEASPLAY_TEXT_CHARS)
+    {
+        if (dx < 0)
+        {
+            memmove(row, &row[n], DEASPLAY_TEXT_CHARS - n);
+            memset(&row[DEASPLAY_TEXT_CHARS - n], 0, n);
+        }
+        else
+        {
+            memmove(&row[n], row, DEASPLAY_TEXT_CHARS - n);
+            memset(row, 0, n);
+        }
+    }
+
+    return true;
+#endif
+}
+
+#ifdef DISPLAY_HAS_ASYNC
+#ifdef HAL_RECORD_DEFERRED
+/* the transfer in flight */
+static uint8_t *hal_record_queue;
+static size_t hal_record_queue_len;
+
+void deasplay_hal_submit(uint8_t *queue, size_t len)
+{
+    /* the queue is read when the transfer completes: it must be left alone until then */
+    hal_record_queue = queue;
+    hal_record_queue_len = len;
+}
+
+bool hal_record_complete(void)
+{
+    if (hal_record_queue == NULL) return false;
+
+    display_async_replay(display_get_context()->hal, hal_record_queue, hal_record_queue_len);
+    hal_record_queue = NULL;
+    display_async_complete();
+
+    return true;
+}
+#else
+void deasplay_hal_submit(uint8_t *queue, size_t len)
+{
+    /* a transfer that completes before returning */
+    display_async_replay(display_get_context()->hal, queue, len);
+    display_async_complete();
+}
+#endif
+#endif
+
+void hal_record_state(e_deasplay_state state)
+{
+    hal_record(HAL_RECORD_STATE, (uint16_t)state, 0U, NULL, 0U);
+    if (state == DEASPLAY_STATE_PERIODIC_END) hal_record_stats.frames++;
+    hal_record_framed = (state == DEASPLAY_STATE_PERIODIC_START) || (state == DEASPLAY_STATE_PERIODIC_RESUME);
+#if defined(HAL_RECORD_I2C) && !defined(HAL_RECORD_NO_BATCH)
+    busbatch_state(&hal_record_bus, state);
+#endif
+}
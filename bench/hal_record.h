@@ -0,0 +1,114 @@
+/*
+ * hal_record.h
+ *
+ *  Recording HAL: a stand-in display driver for host builds.
+ *  It implements every deasplay_hal_* call, counts the calls and the
+ *  bytes that would go over the bus and optionally logs every call.
+ */
+
+#ifndef DEASPLAY_HAL_RECORD_H_
+#define DEASPLAY_HAL_RECORD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Optional HAL calls, defined before deasplay_hal.h provides the defaults */
+#ifndef HAL_RECORD_NO_RUN
+#define deasplay_hal_write_run(line, chr, data, len)    hal_record_write_run(line, chr, data, len)
+#endif
+#ifndef HAL_RECORD_NO_SPAN
+#define display_hal_write_span(page, x, data, len)      hal_record_write_span(page, x, data, len)
+#endif
+#ifndef HAL_RECORD_NO_SCROLL
+#define deasplay_hal_scroll(line, chr, lines, chars, dx, dy) hal_record_scroll(line, chr, lines, chars, dx, dy)
+#endif
+#define deasplay_hal_state_callback(state)              hal_record_state(state)
+
+#include "deasplay_hal.h"
+
+/**< Recorded HAL calls */
+typedef enum
+{
+    HAL_RECORD_INIT,
+    HAL_RECORD_POWER,
+    HAL_RECORD_SET_CURSOR,
+    HAL_RECORD_WRITE_CHAR,
+    HAL_RECORD_WRITE_RUN,
+    HAL_RECORD_CURSOR_VISIBILITY,
+    HAL_RECORD_SET_EXTENDED,
+    HAL_RECORD_WRITE_BUFFER,
+    HAL_RECORD_WRITE_SPAN,
+    HAL_RECORD_SCROLL,
+    HAL_RECORD_STATE,
+    HAL_RECORD_CALLS
+} e_hal_record_call;
+
+/**< A logged HAL call */
+typedef struct
+{
+    uint8_t call;       /**< e_hal_record_call */
+    uint16_t a;         /**< First argument (line, page, id...) */
+    uint16_t b;         /**< Second argument (character, column...) */
+    uint16_t len;       /**< Number of data bytes */
+    uint16_t sum;       /**< Checksum of the data bytes (see hal_record_sum()) */
+} t_hal_record_event;
+
+/**< Counters */
+typedef struct
+{
+    uint32_t calls[HAL_RECORD_CALLS];   /**< Number of calls, per type */
+    uint32_t commands;                  /**< Command (addressing) transfers */
+    uint32_t transactions;              /**< Bus transactions */
+    uint32_t data_bytes;                /**< Data bytes */
+    uint32_t bus_bytes;                 /**< Estimated bytes on the bus, commands included (HAL_RECORD_I2C: I2C framing too) */
+    uint32_t frames;                    /**< PERIODIC_END notifications */
+    uint32_t unframed;                  /**< Runs and spans written outside a refresh step */
+} t_hal_record_stats;
+
+extern t_hal_record_stats hal_record_stats;
+
+/* The commands are those of an HD44780 (character displays) or of an
+ * SSD1306 (bitmap displays). Every HAL call is a bus transaction, unless
+ * HAL_RECORD_I2C models an I2C panel with control bytes (an ST7032 or
+ * AIP31068 character display, an SSD1306): the HAL goes
+ * through a batching stage (busbatch.h), turned off by HAL_RECORD_NO_BATCH,
+ * and the bus bytes include the control bytes and the I2C framing. */
+#ifdef HAL_RECORD_I2C
+#define HAL_RECORD_I2C_BUFFER       (256U)
+#endif
+
+void hal_record_reset(void);
+void hal_record_log(t_hal_record_event *log, size_t size);
+size_t hal_record_logged(void);
+uint16_t hal_record_sum(const uint8_t *data, size_t len);
+#ifndef HAS_BITMAP
+/* What the character display shows, DEASPLAY_TEXT_LINES lines of
+ * DEASPLAY_TEXT_CHARS characters, as rebuilt from the calls */
+const uint8_t* hal_record_screen(void);
+#endif
+
+/* The HAL */
+void deasplay_hal_init(void);
+void deasplay_hal_power(uint8_t state);
+void deasplay_hal_set_cursor(uint16_t line, uint16_t chr);
+void deasplay_hal_write_char(uint8_t chr);
+void deasplay_hal_cursor_visibility(bool visible);
+void deasplay_hal_set_extended(uint8_t id, uint8_t *data, uint8_t len);
+void display_hal_write_buffer(uint16_t x_rect, uint16_t y_rect);
+#ifdef DISPLAY_HAS_ASYNC
+void deasplay_hal_submit(uint8_t *queue, size_t len);
+#ifdef HAL_RECORD_DEFERRED
+/* A submitted queue stays in flight, as with a DMA, until this replays it
+ * and completes the transfer; false if none was in flight */
+bool hal_record_complete(void);
+#endif
+#endif
+
+/* Optional HAL calls */
+void hal_record_write_run(uint16_t line, uint16_t chr, uint8_t *data, uint16_t len);
+void hal_record_write_span(uint16_t page, uint16_t x, uint8_t *data, uint16_t len);
+bool hal_record_scroll(uint16_t line, uint16_t chr, uint16_t lines, uint16_t chars, int8_t dx, int8_t dy);
+void hal_record_state(e_deasplay_state state);
+
+#endif /* DEASPLAY_HAL_RECORD_H_ */
@@ -0,0 +1,831 @@
+/*
+ * replay.c
+ *
+ *  Trace recorder and replay tool (DISPLAY_HAS_TRACE), on top of the
+ *  recording HAL. The replay maps a trace, restores its key frames, runs
+ *  every traced refresh again from the lines the refresh read, compares
+ *  the driver calls with the recorded ones and reports the cost of each
+ *  refresh: a trace taken in the field becomes a regression test.
+ *  With -a the buffer is not taken from the lines the refreshes read but
+ *  written again by replaying the recorded API calls (set_cursor, the
+ *  writes, scroll, clear), the lines being checked against it instead.
+ *
+ *  Usage: replay -r trace [frames [ram-bytes]]
+ *                  record a scripted workload into 'trace', streamed or,
+ *                  with 'ram-bytes', through a RAM log of that size
+ *         replay [-v] [-a] trace
+ *                  replay 'trace', -v printing every refresh, -a
+ *                  replaying the API calls
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "deasplay.h"
+#include "hal_record.h"
+
+/* driver calls logged during one refresh */
+#define REPLAY_EVENTS   4096U
+
+/**< A trace being replayed */
+typedef struct
+{
+    const uint8_t *data;        /**< The mapped trace */
+    size_t len;                 /**< Its size */
+    uint16_t lines;             /**< Geometry of the traced display (see DISPLAY_TRACE_HEADER) */
+    uint16_t chars;
+    uint16_t width;
+    uint16_t font_x;
+    bool bitmap;
+    bool bitmap_shadow;
+    bool header;                /**< A header has been read */
+} t_replay;
+
+/**< Figures of a replay */
+typedef struct
+{
+    uint32_t steps;             /**< Refresh and flush calls replayed */
+    uint32_t skipped;           /**< Calls cut short by the end of the trace or a restart */
+    uint32_t mismatches;        /**< Calls whose driver traffic differs from the recording */
+    uint32_t lines;             /**< Lines read by a refresh differing from the replayed buffer (-a) */
+    uint32_t api;               /**< API calls replayed (-a) */
+    uint32_t keyframes;         /**< Key frames applied */
+    uint64_t time_total;        /**< Nanoseconds spent in the library */
+    uint64_t time_max;
+    uint64_t bytes_total;       /**< Estimated bus bytes */
+    uint32_t bytes_max;
+} t_replay_stats;
+
+static const char replay_text[] = "Replaying a field trace, frame after frame. ";
+
+static t_hal_record_event replay_expected[REPLAY_EVENTS];
+static t_hal_record_event replay_logged[REPLAY_EVENTS];
+#ifdef HAS_BITMAP
+/* bitmap bytes already put in for the call being replayed */
+static bool replay_filled[(DEASPLAY_LINES / 8U) * DEASPLAY_CHARS];
+#endif
+
+static uint64_t replay_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+static uint16_t replay_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t replay_u32(const uint8_t *p)
+{
+    return replay_u16(p) | ((uint32_t)replay_u16(&p[2]) << 16);
+}
+
+/* Recording */
+
+static void replay_write(const uint8_t *data, size_t len, void *arg)
+{
+    (void)fwrite(data, 1U, len, (FILE*)arg);
+}
+
+/**
+ * A display showing a counter, a hexadecimal value, a text scrolled
+ * through the last line and the odd clear or clean, refreshed either at
+ * once or a few bytes per call. Every write goes through the API.
+ * @param frames    number of frames
+ */
+static void replay_workload(uint32_t frames)
+{
+    static const t_display_budget budget = { 0U, 6U, 0U };
+    static const t_display_format hex = { 4U, 0U, '0', DISPLAY_ALIGN_RIGHT };
+    char text[DEASPLAY_TEXT_CHARS + 1U];
+    uint32_t pos = 0U;
+    uint32_t i;
+
+    for (i = 0; i < frames; i++)
+    {
+        if ((i % 64U) == 0U)
+        {
+            display_clear();
+            pos = 0U;
+            while (pos < DEASPLAY_TEXT_CHARS)
+            {
+                text[pos] = replay_text[pos % (sizeof(replay_text) - 1U)];
+                pos++;
+            }
+            text[pos] = '\0';
+            display_set_cursor(DEASPLAY_TEXT_LINES - 1U, 0);
+            display_write_string(text);
+        }
+        else if ((i % 64U) == 32U)
+        {
+            /* only the buffer is wiped, the text comes in again */
+            display_clean();
+        }
+        else if ((i % 4U) == 0U)
+        {
+            /* everything moves one column to the left, one character comes in */
+            display_scroll(DEASPLAY_TEXT_LINES - 1U, 0, 1U, DEASPLAY_TEXT_CHARS, -1, 0);
+            display_set_cursor(DEASPLAY_TEXT_LINES - 1U, DEASPLAY_TEXT_CHARS - 1U);
+            display_write_char((uint8_t)replay_text[pos % (sizeof(replay_text) - 1U)]);
+            pos++;
+        }
+        display_set_cursor(0, 0);
+        display_write_number((uint16_t)i, true);
+        display_set_cursor(0, DEASPLAY_TEXT_CHARS - 4U);
+        display_write_hex(i * 2654435761U, &hex);
+
+        /* every third frame is left unfinished until the next one */
+        if ((i % 3U) == 1U)
+        {
+            (void)display_periodic_step(&budget);
+        }
+        else
+        {
+            display_periodic();
+        }
+    }
+}
+
+/**
+ * Record the workload into a file.
+ * @param path      the trace file
+ * @param frames    number of frames
+ * @param ram       size of the RAM log (0: stream to the file)
+ * @return the exit status
+ */
+static int replay_record(const char *path, uint32_t frames, size_t ram)
+{
+    t_display_trace trace;
+    FILE *file;
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    memset(&trace, 0, sizeof(trace));
+    trace.api = true;
+    if (ram != 0U)
+    {
+        trace.data = malloc(ram);
+        trace.size = ram;
+        if (trace.data == NULL)
+        {
+            fclose(file);
+            return EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        trace.write = replay_write;
+        trace.arg = file;
+    }
+
+    display_init();
+    display_trace_start(&trace);
+    replay_workload(frames);
+    display_trace_stop();
+
+    if (ram != 0U)
+    {
+        /* the RAM log holds the latest frames */
+        (void)fwrite(trace.data, 1U, trace.len, file);
+        printf("%s: %lu bytes, the log started over %lu times\n", path, (unsigned long)trace.len, (unsigned long)trace.restarts);
+        free(trace.data);
+    }
+    else
+    {
+        printf("%s: %ld bytes\n", path, ftell(file));
+    }
+    fclose(file);
+
+    return EXIT_SUCCESS;
+}
+
+/* Replay */
+
+/**
+ * Size of a record.
+ * @param r     the trace
+ * @param p     the record
+ * @param avail bytes left in the trace
+ * @return its size, 0 if it is unknown or truncated
+ */
+static size_t replay_size(const t_replay *r, const uint8_t *p, size_t avail)
+{
+    size_t lb = DEASPLAY_LINE_BYTES(r->lines);
+    size_t page = (size_t)r->lines * r->width;
+    size_t size;
+    size_t head;
+
+    switch ((e_display_trace_event)p[0])
+    {
+    case DISPLAY_TRACE_HEADER:          size = 12U; break;
+    case DISPLAY_TRACE_KEYFRAME:
+        size = 14U + lb + (2U * (size_t)r->lines * r->chars);
+        if (r->bitmap) size += ((size_t)r->lines * 4U) + page;
+        if (r->bitmap_shadow) size += page;
+        break;
+    case DISPLAY_TRACE_STEP:            size = 6U; break;
+    case DISPLAY_TRACE_DIRTY:
+        size = 2U + lb;
+        if (r->bitmap) size += (size_t)r->lines * 4U;
+        break;
+    case DISPLAY_TRACE_FLUSH:
+    case DISPLAY_TRACE_END:
+    case DISPLAY_TRACE_CLEAR:
+    case DISPLAY_TRACE_CLEAN:
+    case DISPLAY_TRACE_HAL_INIT:        size = 1U; break;
+    case DISPLAY_TRACE_HAL_POWER:
+    case DISPLAY_TRACE_HAL_CHAR:
+    case DISPLAY_TRACE_HAL_VISIBILITY:
+    case DISPLAY_TRACE_HAL_STATE:       size = 3U; break;
+    case DISPLAY_TRACE_HAL_CURSOR:
+    case DISPLAY_TRACE_API_CURSOR:      size = 5U; break;
+    case DISPLAY_TRACE_API_CHAR:        size = 3U; break;
+    case DISPLAY_TRACE_API_NUMBER:      size = 14U; break;
+    case DISPLAY_TRACE_API_SCROLL:      size = 13U; break;
+    case DISPLAY_TRACE_API_STRING:
+        head = 3U;
+        if (avail < head) return 0U;
+        size = head + replay_u16(&p[1]);
+        break;
+    case DISPLAY_TRACE_HAL_SCROLL:      size = 15U; break;
+    case DISPLAY_TRACE_LINE:
+    case DISPLAY_TRACE_HAL_RUN:
+    case DISPLAY_TRACE_HAL_SPAN:
+        head = 7U;
+        if (avail < head) return 0U;
+        size = head + replay_u16(&p[5]);
+        break;
+    case DISPLAY_TRACE_HAL_EXTENDED:
+        head = 5U;
+        if (avail < head) return 0U;
+        size = head + replay_u16(&p[3]);
+        break;
+    case DISPLAY_TRACE_HAL_BUFFER:
+        head = 9U;
+        if (avail < head) return 0U;
+        size = head + replay_u32(&p[5]);
+        break;
+    case DISPLAY_TRACE_HAL_SUBMIT:
+        head = 5U;
+        if (avail < head) return 0U;
+        size = head + replay_u32(&p[1]);
+        break;
+    default:
+        return 0U;
+    }
+
+    return (size <= avail) ? size : 0U;
+}
+
+/**
+ * Check that the traced display is the one the replay drives.
+ * @return true if they match
+ */
+static bool replay_header(t_replay *r, t_deasplay *ctx, const uint8_t *p)
+{
+    bool bitmap = false;
+    bool bitmap_shadow = false;
+
+    if (p[1] != DISPLAY_TRACE_VERSION)
+    {
+        fprintf(stderr, "trace version %u, expected %u\n", p[1], DISPLAY_TRACE_VERSION);
+        return false;
+    }
+    r->lines = replay_u16(&p[2]);
+    r->chars = replay_u16(&p[4]);
+    r->width = replay_u16(&p[6]);
+    r->font_x = replay_u16(&p[8]);
+    r->bitmap = (p[10] != 0U);
+    r->bitmap_shadow = (p[11] != 0U);
+    r->header = true;
+
+#ifdef HAS_BITMAP
+    bitmap = (ctx->hal->get_buffer != NULL);
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+    bitmap_shadow = bitmap && (ctx->bitmap_shadow != NULL);
+#endif
+#endif
+    if ((r->lines != ctx->lines) || (r->chars != ctx->chars) || (r->width != ctx->width) ||
+        (r->font_x != ctx->font_x) || (r->bitmap != bitmap) || (r->bitmap_shadow != bitmap_shadow))
+    {
+        fprintf(stderr, "trace of a %ux%u display (%u bytes per page, bitmap %u, shadow %u), this build drives %ux%u (%u, %u, %u)\n",
+                r->lines, r->chars, r->width, r->bitmap, r->bitmap_shadow,
+                ctx->lines, ctx->chars, ctx->width, bitmap, bitmap_shadow);
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef HAS_BITMAP
+static void replay_spans(t_deasplay *ctx, const uint8_t *p)
+{
+    deasplay_coord_t page;
+
+    for (page = 0; page < ctx->lines; page++)
+    {
+        ctx->spans[2U * page] = replay_u16(&p[4U * page]);
+        ctx->spans[(2U * page) + 1U] = replay_u16(&p[(4U * page) + 2U]);
+    }
+}
+
+/**
+ * Put in the bitmap bytes a call sent. The bytes sent first are the ones
+ * the call found in the bitmap: it draws those sent again later itself.
+ * @param b     the bitmap
+ * @param pos   offset of the bytes
+ * @param data  the bytes
+ * @param len   number of bytes
+ */
+static void replay_fill(uint8_t *b, size_t pos, const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; (i < len) && ((pos + i) < sizeof(replay_filled)); i++)
+    {
+        if (replay_filled[pos + i]) continue;
+        replay_filled[pos + i] = true;
+        b[pos + i] = data[i];
+    }
+}
+#endif
+
+/**
+ * Restore the state of the display from a key frame.
+ */
+static void replay_keyframe(const t_replay *r, t_deasplay *ctx, const uint8_t *p)
+{
+    uint8_t flags = p[1];
+    size_t lb = DEASPLAY_LINE_BYTES(ctx->lines);
+
+    ctx->status.frame = ((flags & 1U) != 0U);
+    ctx->status.in_line = ((flags & 2U) != 0U);
+    ctx->status.hw_valid = ((flags & 4U) != 0U);
+    ctx->status.refreshed = ctx->status.generation;
+    if ((flags & 8U) != 0U) ctx->status.generation++;
+    ctx->status.resume_line = (deasplay_index_t)replay_u32(&p[2]);
+    ctx->status.resume_index = (deasplay_index_t)replay_u32(&p[6]);
+    ctx->status.hw_index = (deasplay_index_t)replay_u32(&p[10]);
+    p += 14U;
+    memcpy(ctx->dirty, p, lb);
+    p += lb;
+    memcpy(ctx->buffer, p, ctx->elements);
+    p += ctx->elements;
+    memcpy(ctx->shadow, p, ctx->elements);
+    p += ctx->elements;
+#ifdef HAS_BITMAP
+    if (r->bitmap)
+    {
+        replay_spans(ctx, p);
+        p += (size_t)ctx->lines * 4U;
+        memcpy(ctx->hal->get_buffer(), p, (size_t)ctx->lines * ctx->width);
+        p += (size_t)ctx->lines * ctx->width;
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+        if (r->bitmap_shadow) memcpy(ctx->bitmap_shadow, p, (size_t)ctx->lines * ctx->width);
+#endif
+    }
+#else
+    (void)r;
+#endif
+}
+
+/**
+ * The logged driver call a recorded one corresponds to.
+ * @return false if the recording HAL does not log such calls
+ */
+static bool replay_expect(const uint8_t *p, size_t size, t_hal_record_event *e)
+{
+    memset(e, 0, sizeof(*e));
+    switch ((e_display_trace_event)p[0])
+    {
+    case DISPLAY_TRACE_HAL_INIT:
+        e->call = HAL_RECORD_INIT;
+        break;
+    case DISPLAY_TRACE_HAL_POWER:
+        e->call = HAL_RECORD_POWER;
+        e->a = replay_u16(&p[1]);
+        break;
+    case DISPLAY_TRACE_HAL_CURSOR:
+        e->call = HAL_RECORD_SET_CURSOR;
+        e->a = replay_u16(&p[1]);
+        e->b = replay_u16(&p[3]);
+        break;
+    case DISPLAY_TRACE_HAL_CHAR:
+        e->call = HAL_RECORD_WRITE_CHAR;
+        e->a = p[1];
+        e->len = 1U;
+        e->sum = hal_record_sum(&p[1], 1U);
+        break;
+    case DISPLAY_TRACE_HAL_RUN:
+    case DISPLAY_TRACE_HAL_SPAN:
+        e->call = (p[0] == (uint8_t)DISPLAY_TRACE_HAL_RUN) ? HAL_RECORD_WRITE_RUN : HAL_RECORD_WRITE_SPAN;
+        e->a = replay_u16(&p[1]);
+        e->b = replay_u16(&p[3]);
+        e->len = replay_u16(&p[5]);
+        e->sum = hal_record_sum(&p[7], e->len);
+        break;
+    case DISPLAY_TRACE_HAL_VISIBILITY:
+        e->call = HAL_RECORD_CURSOR_VISIBILITY;
+        e->a = replay_u16(&p[1]);
+        break;
+    case DISPLAY_TRACE_HAL_EXTENDED:
+        e->call = HAL_RECORD_SET_EXTENDED;
+        e->a = replay_u16(&p[1]);
+        e->len = replay_u16(&p[3]);
+        e->sum = hal_record_sum(&p[5], e->len);
+        break;
+    case DISPLAY_TRACE_HAL_BUFFER:
+        e->call = HAL_RECORD_WRITE_BUFFER;
+        e->a = replay_u16(&p[1]);
+        e->b = replay_u16(&p[3]);
+        e->len = (uint16_t)(size - 9U);
+        e->sum = hal_record_sum(&p[9], size - 9U);
+        break;
+    case DISPLAY_TRACE_HAL_SCROLL:
+        e->call = HAL_RECORD_SCROLL;
+        e->a = replay_u16(&p[1]);
+        e->b = replay_u16(&p[3]);
+        e->len = replay_u16(&p[7]);
+        break;
+    case DISPLAY_TRACE_HAL_STATE:
+        e->call = HAL_RECORD_STATE;
+        e->a = replay_u16(&p[1]);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Replay a refresh or flush call: the records from its STEP or FLUSH to its END.
+ * @param r         the trace
+ * @param ctx       the display
+ * @param from      offset of the STEP or FLUSH record
+ * @param to        offset of the END record
+ * @param stats     figures of the replay
+ * @param verbose   print the figures of the call
+ * @param api       the buffer comes from the replayed API calls: check the lines against it
+ */
+static void replay_call(const t_replay *r, t_deasplay *ctx, size_t from, size_t to, t_replay_stats *stats, bool verbose, bool api)
+{
+    const uint8_t *call = &r->data[from];
+    const uint8_t *p;
+    size_t pos;
+    size_t size;
+    size_t expected = 0U;
+    size_t logged;
+    size_t i;
+    uint16_t len;
+    uint32_t lines = 0U;
+    bool dirty = api;
+    uint64_t start;
+    uint64_t elapsed;
+    t_display_budget budget;
+    deasplay_index_t index;
+#ifdef HAS_BITMAP
+    uint8_t *b = r->bitmap ? ctx->hal->get_buffer() : NULL;
+#endif
+
+    /* put in what the call read: the lines, the bitmap bytes it sent */
+#ifdef HAS_BITMAP
+    memset(replay_filled, 0, sizeof(replay_filled));
+#endif
+    for (pos = from + replay_size(r, call, r->len - from); pos < to; pos += size)
+    {
+        p = &r->data[pos];
+        size = replay_size(r, p, r->len - pos);
+        switch ((e_display_trace_event)p[0])
+        {
+        case DISPLAY_TRACE_DIRTY:
+            /* the first pass of the call starts from here */
+            if (dirty) break;
+            dirty = true;
+            memcpy(ctx->dirty, &p[2], DEASPLAY_LINE_BYTES(ctx->lines));
+            ctx->status.refreshed = ctx->status.generation;
+            if (p[1] != 0U) ctx->status.generation++;
+#ifdef HAS_BITMAP
+            if (r->bitmap) replay_spans(ctx, &p[2U + DEASPLAY_LINE_BYTES(ctx->lines)]);
+#endif
+            break;
+        case DISPLAY_TRACE_LINE:
+            index = (deasplay_index_t)((replay_u16(&p[1]) * ctx->chars) + replay_u16(&p[3]));
+            len = replay_u16(&p[5]);
+            if (api && (memcmp(&ctx->buffer[index], &p[7], len) != 0)) lines++;
+            memcpy(&ctx->buffer[index], &p[7], len);
+            break;
+#ifdef HAS_BITMAP
+        case DISPLAY_TRACE_HAL_SPAN:
+            if (b != NULL) replay_fill(b, (replay_u16(&p[1]) * ctx->width) + replay_u16(&p[3]), &p[7], replay_u16(&p[5]));
+            break;
+        case DISPLAY_TRACE_HAL_BUFFER:
+            if ((b != NULL) && ((size - 9U) == ((size_t)ctx->lines * ctx->width))) replay_fill(b, 0U, &p[9], size - 9U);
+            break;
+#endif
+        default:
+            break;
+        }
+        if ((expected < REPLAY_EVENTS) && replay_expect(p, size, &replay_expected[expected])) expected++;
+    }
+
+    hal_record_reset();
+    hal_record_log(replay_logged, REPLAY_EVENTS);
+    start = replay_now();
+    if (call[0] == (uint8_t)DISPLAY_TRACE_FLUSH)
+    {
+#if defined(HAS_BITMAP) && defined(DISPLAY_HAS_BITMAP_SHADOW)
+        display_flush_ctx(ctx);
+#endif
+    }
+    else if (call[1] == 0U)
+    {
+        display_periodic_ctx(ctx);
+    }
+    else
+    {
+        budget.cells = replay_u16(&call[2]);
+        budget.bytes = replay_u16(&call[4]);
+        budget.time = 0U;
+        (void)display_periodic_step_ctx(ctx, &budget);
+    }
+    elapsed = replay_now() - start;
+    logged = hal_record_logged();
+    hal_record_log(NULL, 0U);
+
+    for (i = 0; (i < logged) && (i < expected); i++)
+    {
+        if ((replay_logged[i].call != replay_expected[i].call) || (replay_logged[i].a != replay_expected[i].a) ||
+            (replay_logged[i].b != replay_expected[i].b) || (replay_logged[i].len != replay_expected[i].len) ||
+            (replay_logged[i].sum != replay_expected[i].sum))
+        {
+            break;
+        }
+    }
+
+    stats->steps++;
+    stats->time_total += elapsed;
+    if (elapsed > stats->time_max) stats->time_max = elapsed;
+    stats->bytes_total += hal_record_stats.bus_bytes;
+    if (hal_record_stats.bus_bytes > stats->bytes_max) stats->bytes_max = hal_record_stats.bus_bytes;
+    if (lines != 0U)
+    {
+        stats->lines += lines;
+        printf("call %lu at offset %lu: %lu lines read differ from the buffer the API calls wrote\n",
+               (unsigned long)stats->steps, (unsigned long)from, (unsigned long)lines);
+    }
+    if ((i != logged) || (i != expected))
+    {
+        stats->mismatches++;
+        printf("call %lu at offset %lu: driver call %lu differs (%lu recorded, %lu replayed)\n",
+               (unsigned long)stats->steps, (unsigned long)from, (unsigned long)i,
+               (unsigned long)expected, (unsigned long)logged);
+    }
+    if (verbose)
+    {
+        printf("call %6lu %-8s %8lu ns %6lu bytes %4lu driver calls\n", (unsigned long)stats->steps,
+               (call[0] == (uint8_t)DISPLAY_TRACE_FLUSH) ? "flush" : ((call[1] == 0U) ? "periodic" : "step"),
+               (unsigned long)elapsed, (unsigned long)hal_record_stats.bus_bytes, (unsigned long)logged);
+    }
+}
+
+/**
+ * Replay a recorded API call.
+ * @param ctx   the display
+ * @param p     the record
+ */
+static void replay_api(t_deasplay *ctx, const uint8_t *p)
+{
+    t_display_format fmt;
+    char text[65];
+    uint16_t len;
+    uint16_t pos;
+    uint16_t n;
+
+    switch ((e_display_trace_event)p[0])
+    {
+    case DISPLAY_TRACE_API_CURSOR:
+        display_set_cursor_ctx(ctx, replay_u16(&p[1]), replay_u16(&p[3]));
+        break;
+    case DISPLAY_TRACE_API_CHAR:
+        display_write_char_ctx(ctx, p[1]);
+        break;
+    case DISPLAY_TRACE_API_STRING:
+        /* in pieces short enough for the stack */
+        len = replay_u16(&p[1]);
+        for (pos = 0; pos < len; pos += n)
+        {
+            n = ((size_t)(len - pos) < (sizeof(text) - 1U)) ? (uint16_t)(len - pos) : (uint16_t)(sizeof(text) - 1U);
+            memcpy(text, &p[3U + pos], n);
+            text[n] = '\0';
+            display_write_string_ctx(ctx, text);
+        }
+        break;
+    case DISPLAY_TRACE_API_NUMBER:
+        fmt.width = (uint8_t)replay_u16(&p[6]);
+        fmt.decimals = (uint8_t)replay_u16(&p[8]);
+        fmt.pad = (char)replay_u16(&p[10]);
+        fmt.align = (e_display_align)replay_u16(&p[12]);
+        if ((p[5] & 2U) != 0U)
+        {
+            display_write_hex_ctx(ctx, replay_u32(&p[1]), &fmt);
+        }
+        else if ((p[5] & 1U) != 0U)
+        {
+            display_write_int_ctx(ctx, (int32_t)(0U - replay_u32(&p[1])), &fmt);
+        }
+        else
+        {
+            display_write_uint_ctx(ctx, replay_u32(&p[1]), &fmt);
+        }
+        break;
+    case DISPLAY_TRACE_API_SCROLL:
+        display_scroll_ctx(ctx, replay_u16(&p[1]), replay_u16(&p[3]), replay_u16(&p[5]), replay_u16(&p[7]),
+                           (int8_t)p[9], (int8_t)p[11]);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Replay a trace.
+ * @param path      the trace file
+ * @param verbose   print every call
+ * @param api       replay the API calls
+ * @return the exit status
+ */
+static int replay_run(const char *path, bool verbose, bool api)
+{
+    t_deasplay *ctx = display_get_context();
+    t_replay r;
+    t_replay_stats stats;
+    struct stat st;
+    size_t pos = 0U;
+    size_t size;
+    size_t call = 0U;
+    bool in_call = false;
+    const uint8_t *p;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    if ((fstat(fd, &st) != 0) || (st.st_size == 0))
+    {
+        fprintf(stderr, "%s: empty trace\n", path);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    memset(&r, 0, sizeof(r));
+    memset(&stats, 0, sizeof(stats));
+    r.len = (size_t)st.st_size;
+    r.data = mmap(NULL, r.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (r.data == MAP_FAILED)
+    {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    display_init();
+
+    while (pos < r.len)
+    {
+        p = &r.data[pos];
+        if ((r.header == false) && (p[0] != (uint8_t)DISPLAY_TRACE_HEADER))
+        {
+            fprintf(stderr, "%s: no header at offset %lu\n", path, (unsigned long)pos);
+            break;
+        }
+        size = replay_size(&r, p, r.len - pos);
+        if (size == 0U)
+        {
+            fprintf(stderr, "%s: bad or truncated record %u at offset %lu\n", path, p[0], (unsigned long)pos);
+            break;
+        }
+
+        switch ((e_display_trace_event)p[0])
+        {
+        case DISPLAY_TRACE_HEADER:
+            /* a RAM log starting over: the call in progress is lost */
+            if (in_call) stats.skipped++;
+            in_call = false;
+            if (replay_header(&r, ctx, p) == false)
+            {
+                munmap((void*)r.data, r.len);
+                return EXIT_FAILURE;
+            }
+            break;
+        case DISPLAY_TRACE_KEYFRAME:
+            replay_keyframe(&r, ctx, p);
+            stats.keyframes++;
+            break;
+        case DISPLAY_TRACE_STEP:
+        case DISPLAY_TRACE_FLUSH:
+            call = pos;
+            in_call = true;
+            break;
+        case DISPLAY_TRACE_END:
+            if (in_call) replay_call(&r, ctx, call, pos, &stats, verbose, api);
+            in_call = false;
+            break;
+        case DISPLAY_TRACE_CLEAR:
+            if (in_call == false) display_clear_ctx(ctx);
+            break;
+        case DISPLAY_TRACE_CLEAN:
+            if (in_call == false) display_clean_ctx(ctx);
+            break;
+        case DISPLAY_TRACE_API_CURSOR:
+        case DISPLAY_TRACE_API_CHAR:
+        case DISPLAY_TRACE_API_STRING:
+        case DISPLAY_TRACE_API_NUMBER:
+        case DISPLAY_TRACE_API_SCROLL:
+            if (api && (in_call == false))
+            {
+                replay_api(ctx, p);
+                stats.api++;
+            }
+            break;
+        case DISPLAY_TRACE_HAL_SCROLL:
+            /* the panel shifted its contents and so does the shadow buffer;
+             * with -a the replayed scroll shifts both */
+            if ((api == false) && (in_call == false) && (p[13] != 0U))
+            {
+                display_scroll_ctx(ctx, replay_u16(&p[1]), replay_u16(&p[3]), replay_u16(&p[5]), replay_u16(&p[7]),
+                                   (int8_t)p[9], (int8_t)p[11]);
+            }
+            break;
+        case DISPLAY_TRACE_HAL_INIT:
+            if (in_call == false) ctx->status.frame = false;
+            /* fall through */
+        case DISPLAY_TRACE_HAL_EXTENDED:
+            /* the address counter is unknown */
+            if (in_call == false) ctx->status.hw_valid = false;
+            break;
+        default:
+            break;
+        }
+        pos += size;
+    }
+    if (in_call) stats.skipped++;
+    munmap((void*)r.data, r.len);
+
+    printf("%s: %lu calls replayed, %lu mismatched, %lu cut short, %lu key frames\n", path,
+           (unsigned long)stats.steps, (unsigned long)stats.mismatches, (unsigned long)stats.skipped,
+           (unsigned long)stats.keyframes);
+    if (api)
+    {
+        printf("%lu API calls replayed, %lu lines read differing from them\n",
+               (unsigned long)stats.api, (unsigned long)stats.lines);
+    }
+    if (stats.steps != 0U)
+    {
+        printf("refresh time: %.1f ns average, %lu ns max; bus bytes: %.2f average, %lu max\n",
+               (double)stats.time_total / (double)stats.steps, (unsigned long)stats.time_max,
+               (double)stats.bytes_total / (double)stats.steps, (unsigned long)stats.bytes_max);
+    }
+
+    return ((stats.mismatches == 0U) && (stats.lines == 0U)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    bool api = false;
+    int arg;
+
+    if ((argc >= 3) && (strcmp(argv[1], "-r") == 0))
+    {
+        return replay_record(argv[2], (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 1000U,
+                             (argc > 4) ? (size_t)strtoul(argv[4], NULL, 0) : 0U);
+    }
+    for (arg = 1; (arg < (argc - 1)) && (argv[arg][0] == '-'); arg++)
+    {
+        if (strcmp(argv[arg], "-v") == 0) verbose = true;
+        else if (strcmp(argv[arg], "-a") == 0) api = true;
+        else break;
+    }
+    if (arg == (argc - 1)) return replay_run(argv[arg], verbose, api);
+
+    fprintf(stderr, "usage: %s -r trace [frames [ram-bytes]] | %s [-v] [-a] trace\n", argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
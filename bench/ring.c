@@ -0,0 +1,202 @@
+/*
+ * ring.c
+ *
+ *  Stress test of the write ring (DISPLAY_HAS_RING), on top of the
+ *  recording HAL: producer threads hammer their own part of the display
+ *  while the main thread refreshes it. Every frame must show whole writes,
+ *  each spanning several slots of the ring, and once they are done the
+ *  display must show the last write of every producer.
+ *
+ *  Usage: ring [writes per producer]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "deasplay.h"
+#include "hal_record.h"
+
+/* two producers per line, each owning half of it */
+#define RING_PRODUCERS  (2U * DEASPLAY_TEXT_LINES)
+#define RING_CHARS      (DEASPLAY_TEXT_CHARS / 2U)
+/* a write: the producer letter, the write number and a check digit */
+#define RING_DIGITS     (RING_CHARS - 2U)
+#define RING_WRITES_MAX (999999U)
+
+/**< A producer thread */
+typedef struct
+{
+    pthread_t thread;
+    deasplay_coord_t line;      /**< Where it writes */
+    deasplay_coord_t chr;
+    uint32_t writes;            /**< Number of writes */
+    uint32_t full;              /**< Writes retried, the ring being full */
+} t_ring_producer;
+
+static t_ring_producer ring_producers[RING_PRODUCERS];
+static unsigned int ring_done;     /* producers done */
+
+/**
+ * Text of a write: the producer, the write number and the sum of its
+ * digits, which a write showing only in part is unlikely to match.
+ * @param p     the producer
+ * @param n     the write number
+ * @param text  RING_CHARS characters
+ */
+static void ring_text(const t_ring_producer *p, uint32_t n, uint8_t *text)
+{
+    uint32_t sum = 0U;
+    uint8_t i;
+
+    text[0] = (uint8_t)('A' + (p - ring_producers));
+    for (i = RING_DIGITS; i > 0U; i--)
+    {
+        text[i] = (uint8_t)('0' + (n % 10U));
+        sum += n % 10U;
+        n /= 10U;
+    }
+    text[RING_CHARS - 1U] = (uint8_t)('0' + (sum % 10U));
+}
+
+/**
+ * Check that a frame shows whole writes: for every producer nothing yet,
+ * or a write whose text is right, no older than the one shown before.
+ * @param shown last write shown per producer, plus one (0: none)
+ * @return false if a write shows only in part
+ */
+static bool ring_check_frame(uint32_t *shown)
+{
+    const uint8_t *screen = hal_record_screen();
+    const t_ring_producer *p;
+    uint8_t text[RING_CHARS];
+    uint32_t n;
+    uint8_t k;
+    uint8_t i;
+
+    for (k = 0; k < RING_PRODUCERS; k++)
+    {
+        p = &ring_producers[k];
+        memcpy(text, &screen[(p->line * DEASPLAY_TEXT_CHARS) + p->chr], RING_CHARS);
+        if (text[0] == ' ')
+        {
+            if (shown[k] != 0U) return false;
+            continue;
+        }
+        n = 0U;
+        for (i = 1U; i <= RING_DIGITS; i++)
+        {
+            if ((text[i] < '0') || (text[i] > '9')) return false;
+            n = (n * 10U) + (uint32_t)(text[i] - '0');
+        }
+        ring_text(p, n, text);
+        if ((memcmp(text, &screen[(p->line * DEASPLAY_TEXT_CHARS) + p->chr], RING_CHARS) != 0) || ((n + 1U) < shown[k])) return false;
+        shown[k] = n + 1U;
+    }
+
+    return true;
+}
+
+static void* ring_produce(void *arg)
+{
+    t_ring_producer *p = (t_ring_producer*)arg;
+    uint8_t text[RING_CHARS];
+    uint32_t n;
+
+    for (n = 0; n < p->writes; n++)
+    {
+        ring_text(p, n, text);
+        while (display_ring_write(p->line, p->chr, text, RING_CHARS) == false)
+        {
+            p->full++;
+            sched_yield();
+        }
+    }
+    __atomic_add_fetch(&ring_done, 1U, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t writes = 100000U;
+    uint32_t refreshes = 0U;
+    uint32_t full = 0U;
+    uint32_t torn = 0U;
+    uint32_t shown[RING_PRODUCERS] = { 0U };
+    uint8_t expected[DEASPLAY_TEXT_LINES * DEASPLAY_TEXT_CHARS];
+    t_ring_producer *p;
+    uint8_t k;
+
+    if (argc > 1) writes = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (writes > RING_WRITES_MAX) writes = RING_WRITES_MAX;
+
+    /* the ring is emptied by display_init(), before any producer runs */
+    display_init();
+    display_clear();
+    display_periodic();
+    hal_record_reset();
+
+    for (k = 0; k < RING_PRODUCERS; k++)
+    {
+        p = &ring_producers[k];
+        p->line = k / 2U;
+        p->chr = (k % 2U) * RING_CHARS;
+        p->writes = writes;
+        if (pthread_create(&p->thread, NULL, ring_produce, p) != 0)
+        {
+            printf("cannot start producer %u\n", (unsigned)k);
+            return 1;
+        }
+    }
+
+    /* refresh while they write, then until the ring is empty */
+    while (__atomic_load_n(&ring_done, __ATOMIC_ACQUIRE) < RING_PRODUCERS)
+    {
+        display_periodic();
+        refreshes++;
+        if (ring_check_frame(shown) == false) torn++;
+        sched_yield();
+    }
+    for (k = 0; k < RING_PRODUCERS; k++)
+    {
+        (void)pthread_join(ring_producers[k].thread, NULL);
+        full += ring_producers[k].full;
+    }
+    while (display_is_dirty())
+    {
+        display_periodic();
+        refreshes++;
+        if (ring_check_frame(shown) == false) torn++;
+    }
+
+    memset(expected, ' ', sizeof(expected));
+    for (k = 0; k < RING_PRODUCERS; k++)
+    {
+        p = &ring_producers[k];
+        if (writes != 0U) ring_text(p, writes - 1U, &expected[(p->line * DEASPLAY_TEXT_CHARS) + p->chr]);
+    }
+
+    printf("ring: %u producers x %u writes, %u refreshes, %u frames, %u retries on a full ring, %u frames with a partial write\n",
+           (unsigned)RING_PRODUCERS, (unsigned)writes, (unsigned)refreshes, (unsigned)hal_record_stats.frames, (unsigned)full,
+           (unsigned)torn);
+    for (k = 0; k < DEASPLAY_TEXT_LINES; k++)
+    {
+        printf("|%.*s|\n", (int)DEASPLAY_TEXT_CHARS, (const char*)&hal_record_screen()[k * DEASPLAY_TEXT_CHARS]);
+    }
+    if (torn != 0U)
+    {
+        printf("ring: writes split across frames\n");
+        return 1;
+    }
+    if ((memcmp(display_get_context()->buffer, expected, sizeof(expected)) != 0) ||
+        (memcmp(hal_record_screen(), expected, sizeof(expected)) != 0))
+    {
+        printf("ring: the display is not showing the last writes\n");
+        return 1;
+    }
+
+    return 0;
+}
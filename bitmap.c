@@ -5,14 +5,17 @@
  *      Author: lorenzo
  */
 
-#include "bitmap.h"
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "bitmap.h"
 
 const uint8_t font5x8[] BITMAP_STORAGE_FLAGS =
 {
     //- - - - - - -  STANDARD ASCII  (7bits)  - - - - - - -//
     //      8 byte wide codes                 ASCII val(dec) --> ASCII CODE
+#ifndef BITMAP_FONT5x8_ASCII
     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, //0/ -->
     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, //1/ -->
     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, //2/ -->
@@ -45,6 +48,7 @@ const uint8_t font5x8[] BITMAP_STORAGE_FLAGS =
     0x20,0x20,0x20,0x60,0xB0,0x60,0x20,0x20, //29/ -->
     0x00,0x30,0x28,0x60,0xA0,0x60,0x30,0x20, //30/ -->
     0x00,0x04,0x06,0x1D,0x25,0x24,0x20,0x20, //31/ -->
+#endif
     0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, //32/ -->
     0x00,0x00,0x4F,0x00,0x00,0x00,0x00,0x00, //33/ --> !
     0x00,0x07,0x00,0x07,0x00,0x00,0x00,0x00, //34/ --> "
@@ -140,6 +144,7 @@ const uint8_t font5x8[] BITMAP_STORAGE_FLAGS =
     0x00,0x00,0x00,0x7F,0x00,0x00,0x00,0x00, //124/ --> |
     0x00,0x41,0x36,0x08,0x00,0x00,0x00,0x00, //125/ --> }
     0x00,0x08,0x08,0x2A,0x1C,0x08,0x00,0x00, //126/ --> ~
+#ifndef BITMAP_FONT5x8_ASCII
     0x00,0x08,0x1C,0x2A,0x08,0x08,0x00,0x00, //127/ -->
             //  EXTENED ASCII CODES
 
@@ -271,19 +276,579 @@ const uint8_t font5x8[] BITMAP_STORAGE_FLAGS =
     0x00,0x19,0x14,0x15,0x18,0x20,0x20,0x20, //253/ --> ˝
     0x04,0x02,0x02,0x1A,0x22,0x22,0x21,0x20, //254/ --> ˛
     0x00,0x40,0x60,0x50,0x48,0x50,0x40,0x40 //255/ --> ˇ
+#endif
+};
+
+static const t_bitmap_font_range font5x8_ranges[] BITMAP_STORAGE_FLAGS =
+{
+#ifdef BITMAP_FONT5x8_ASCII
+    { 32U, 126U, 0U }
+#else
+    { 0U, 255U, 0U }
+#endif
+};
+
+const t_bitmap_font bitmap_font_5x8 BITMAP_STORAGE_FLAGS =
+{
+    .width = 8U,
+    .height = 8U,
+    .encoding = BITMAP_FONT_RAW,
+    .ranges = 1U,
+    .fallback = (uint8_t)'?',
+    .range = font5x8_ranges,
+    .widths = NULL,
+    .offsets = NULL,
+    .data = font5x8
 };
 
-// maybe set it as inline and place it in the .h file...
-void bitmap_character(char chr, uint8_t *destination, uint8_t len_max, e_font font)
+#ifdef __AVR
+#define BITMAP_READ_BYTE(p)         pgm_read_byte(p)
+#define BITMAP_READ_WORD(p)         pgm_read_word(p)
+#define BITMAP_READ(d, s, n)        memcpy_P((d), (s), (n))
+#else
+/* other generic C platforms */
+#define BITMAP_READ_BYTE(p)         (*(p))
+#define BITMAP_READ_WORD(p)         (*(p))
+#define BITMAP_READ(d, s, n)        memcpy((d), (s), (n))
+#endif
+
+/**< A glyph located in its font */
+typedef struct
+{
+    const uint8_t *data;    /**< Encoded glyph */
+    uint8_t width;          /**< Glyph width */
+    uint8_t height;         /**< Glyph height */
+    uint8_t pages;          /**< Pages of 8 rows */
+    uint8_t encoding;       /**< See e_bitmap_font_encoding */
+} t_bitmap_glyph;
+
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+/**< A glyph decoded, scaled and shifted down by 'phase' rows */
+typedef struct
+{
+    const t_bitmap_font *font;  /**< Font, NULL when the entry is free */
+    uint8_t code;               /**< Code as requested (not the fallback) */
+    uint8_t scale;              /**< Scale factor */
+    uint8_t phase;              /**< Blank rows above the glyph */
+    uint8_t width;              /**< Width of the rendered glyph */
+    uint8_t height;             /**< Height of the rendered glyph, phase included */
+    uint8_t data[BITMAP_GLYPH_CACHE_BYTES];
+} t_bitmap_cache_entry;
+#endif
+
+static void bitmap_blit_generic(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                                const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y,
+                                e_bitmap_rop rop, bool progmem, uint8_t top);
+
+/**
+ * Locate the glyph of a code, or the one of the fallback code.
+ * @return false if neither is in the font
+ */
+static bool bitmap_font_find(const t_bitmap_font *font, uint8_t code, t_bitmap_glyph *glyph)
+{
+    t_bitmap_font f;
+    t_bitmap_font_range r;
+    uint8_t pass;
+    uint8_t i;
+    uint16_t index = 0U;
+    bool found = false;
+    size_t offset;
+
+    BITMAP_READ(&f, font, sizeof(f));
+
+    for (pass = 0U; (pass < 2U) && (found == false); pass++)
+    {
+        for (i = 0U; (i < f.ranges) && (found == false); i++)
+        {
+            BITMAP_READ(&r, &f.range[i], sizeof(r));
+            if ((code >= r.first) && (code <= r.last))
+            {
+                index = (uint16_t)(r.glyph + (uint16_t)(code - r.first));
+                found = true;
+            }
+        }
+        code = f.fallback;
+    }
+    if (found == false) return false;
+
+    glyph->width = (f.widths != NULL) ? BITMAP_READ_BYTE(&f.widths[index]) : f.width;
+    glyph->height = f.height;
+    glyph->pages = (uint8_t)((f.height + 7U) / 8U);
+    glyph->encoding = f.encoding;
+
+    if (f.offsets != NULL)
+    {
+        offset = BITMAP_READ_WORD(&f.offsets[index]);
+    }
+    else if (f.encoding == (uint8_t)BITMAP_FONT_BITS)
+    {
+        offset = (size_t)index * ((((size_t)f.width * f.height) + 7U) / 8U);
+    }
+    else
+    {
+        offset = (size_t)index * f.width * glyph->pages;
+    }
+    glyph->data = &f.data[offset];
+
+    return true;
+}
+
+/**
+ * Decode a glyph into pages of one byte per column.
+ * The encoded data is streamed, hence it is read only once.
+ */
+static void bitmap_glyph_decode(const t_bitmap_glyph *glyph, uint8_t *destination)
+{
+    const uint8_t *src = glyph->data;
+    size_t size = (size_t)glyph->width * glyph->pages;
+    size_t count;
+    uint8_t n;
+    uint8_t x;
+    uint8_t p;
+    uint8_t bits;
+    uint16_t acc = 0U;
+    uint8_t avail = 0U;
+
+    switch (glyph->encoding)
+    {
+        case BITMAP_FONT_RLE:
+            while (size > 0U)
+            {
+                n = BITMAP_READ_BYTE(src);
+                src++;
+                count = (size_t)(n & 0x7FU) + 1U;
+                if (count > size) count = size;
+                if ((n & 0x80U) != 0U)
+                {
+                    memset(destination, BITMAP_READ_BYTE(src), count);
+                    src++;
+                }
+                else
+                {
+                    BITMAP_READ(destination, src, count);
+                    src += count;
+                }
+                destination += count;
+                size -= count;
+            }
+            break;
+        case BITMAP_FONT_BITS:
+            for (x = 0U; x < glyph->width; x++)
+            {
+                for (p = 0U; p < glyph->pages; p++)
+                {
+                    bits = (p == (glyph->pages - 1U)) ? (uint8_t)(glyph->height - (p * 8U)) : 8U;
+                    while (avail < bits)
+                    {
+                        acc |= (uint16_t)((uint16_t)BITMAP_READ_BYTE(src) << avail);
+                        src++;
+                        avail += 8U;
+                    }
+                    destination[((size_t)p * glyph->width) + x] = (uint8_t)(acc & ((1U << bits) - 1U));
+                    acc >>= bits;
+                    avail -= bits;
+                }
+            }
+            break;
+        default:
+            BITMAP_READ(destination, src, size);
+            break;
+    }
+}
+
+/**
+ * Scale a column of a decoded glyph, shifted down by 'phase' rows.
+ * @param src       the decoded glyph
+ * @param glyph     the glyph
+ * @param x         the column
+ * @param scale     scale factor
+ * @param phase     blank rows above the glyph
+ * @param column    the destination, ((height * scale + phase + 7) / 8) bytes
+ */
+static void bitmap_glyph_column(const uint8_t *src, const t_bitmap_glyph *glyph, uint8_t x,
+                                uint8_t scale, uint8_t phase, uint8_t *column)
+{
+    uint16_t row = phase;
+    uint8_t r;
+    uint8_t k;
+
+    memset(column, 0, (((size_t)glyph->height * scale) + phase + 7U) / 8U);
+    for (r = 0U; r < glyph->height; r++)
+    {
+        if ((src[((size_t)(r / 8U) * glyph->width) + x] & (1U << (r % 8U))) != 0U)
+        {
+            for (k = 0U; k < scale; k++)
+            {
+                column[(row + k) / 8U] |= (uint8_t)(1U << ((row + k) % 8U));
+            }
+        }
+        row = (uint16_t)(row + scale);
+    }
+}
+
+static t_bitmap_cache_stats bitmap_cache_stats;
+
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+
+static t_bitmap_cache_entry bitmap_cache[BITMAP_GLYPH_CACHE_SIZE];
+
+/**< Entries, most recently used first */
+static uint8_t bitmap_cache_order[BITMAP_GLYPH_CACHE_SIZE];
+
+static bool bitmap_cache_ready = false;
+
+/**
+ * Look a rendered glyph up, rendering it in the least recently used entry
+ * on a miss.
+ * @return the entry, NULL if the glyph does not fit
+ */
+static const t_bitmap_cache_entry* bitmap_cache_get(const t_bitmap_font *font, uint8_t code, const t_bitmap_glyph *glyph,
+                                                    uint8_t scale, uint8_t phase)
+{
+    uint8_t i;
+    uint8_t slot;
+    uint8_t cx;
+    uint8_t sx;
+    uint8_t p;
+    uint8_t width = (uint8_t)(glyph->width * scale);
+    uint8_t height = (uint8_t)((glyph->height * scale) + phase);
+    uint8_t pages = (uint8_t)((height + 7U) / 8U);
+    uint8_t scratch[BITMAP_FONT_GLYPH_MAX];
+    uint8_t column[BITMAP_GLYPH_COLUMN_MAX];
+    t_bitmap_cache_entry *e;
+
+    if (bitmap_cache_ready == false) bitmap_cache_clear();
+
+    for (i = 0U; i < BITMAP_GLYPH_CACHE_SIZE; i++)
+    {
+        slot = bitmap_cache_order[i];
+        e = &bitmap_cache[slot];
+        if ((e->font == font) && (e->code == code) && (e->scale == scale) && (e->phase == phase))
+        {
+            memmove(&bitmap_cache_order[1], &bitmap_cache_order[0], i);
+            bitmap_cache_order[0] = slot;
+            bitmap_cache_stats.hits++;
+            return e;
+        }
+    }
+
+    if ((((size_t)width * pages) > BITMAP_GLYPH_CACHE_BYTES) ||
+        (((size_t)glyph->width * glyph->pages) > sizeof(scratch)))
+    {
+        return NULL;
+    }
+    bitmap_cache_stats.misses++;
+
+    /* evict the least recently used entry */
+    slot = bitmap_cache_order[BITMAP_GLYPH_CACHE_SIZE - 1U];
+    memmove(&bitmap_cache_order[1], &bitmap_cache_order[0], BITMAP_GLYPH_CACHE_SIZE - 1U);
+    bitmap_cache_order[0] = slot;
+    e = &bitmap_cache[slot];
+
+    if ((scale == 1U) && (phase == 0U))
+    {
+        bitmap_glyph_decode(glyph, e->data);
+    }
+    else
+    {
+        bitmap_glyph_decode(glyph, scratch);
+        for (cx = 0U; cx < glyph->width; cx++)
+        {
+            bitmap_glyph_column(scratch, glyph, cx, scale, phase, column);
+            for (p = 0U; p < pages; p++)
+            {
+                for (sx = 0U; sx < scale; sx++)
+                {
+                    e->data[((size_t)p * width) + ((size_t)cx * scale) + sx] = column[p];
+                }
+            }
+        }
+    }
+
+    e->font = font;
+    e->code = code;
+    e->scale = scale;
+    e->phase = phase;
+    e->width = width;
+    e->height = height;
+
+    return e;
+}
+
+#endif
+
+void bitmap_cache_clear(void)
+{
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+    uint8_t i;
+
+    for (i = 0U; i < BITMAP_GLYPH_CACHE_SIZE; i++)
+    {
+        bitmap_cache[i].font = NULL;
+        bitmap_cache_order[i] = i;
+    }
+    bitmap_cache_ready = true;
+#endif
+    bitmap_cache_stats.hits = 0U;
+    bitmap_cache_stats.misses = 0U;
+}
+
+void bitmap_cache_get_stats(t_bitmap_cache_stats *stats)
+{
+    *stats = bitmap_cache_stats;
+}
+
+const t_bitmap_font* bitmap_font(e_font font)
+{
+    switch (font)
+    {
+#ifdef BITMAP_HAS_FONT_8x16
+        case FONT_8x16:
+            return &bitmap_font_8x16;
+#endif
+#ifdef BITMAP_HAS_FONT_12x24_DIGITS
+        case FONT_12x24_DIGITS:
+            return &bitmap_font_12x24_digits;
+#endif
+        default:
+            return &bitmap_font_5x8;
+    }
+}
+
+void bitmap_character(uint8_t chr, uint8_t *destination, uint8_t len_max, e_font font)
 {
-    uint8_t size = 8U;
-    if (len_max >= size)
+    const t_bitmap_font *f = bitmap_font(font);
+    t_bitmap_glyph glyph;
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+    const t_bitmap_cache_entry *e;
+#endif
+
+    if (bitmap_font_find(f, chr, &glyph) == false) return;
+    if (((size_t)glyph.width * glyph.pages) > len_max) return;
+
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+    /* raw glyphs are copied as fast as the cache would */
+    if (glyph.encoding != (uint8_t)BITMAP_FONT_RAW)
     {
+        e = bitmap_cache_get(f, chr, &glyph, 1U, 0U);
+        if (e != NULL)
+        {
+            memcpy(destination, e->data, (size_t)glyph.width * glyph.pages);
+            return;
+        }
+    }
+#endif
+    bitmap_glyph_decode(&glyph, destination);
+}
+
+uint8_t bitmap_font_glyph(const t_bitmap_font *font, uint8_t code, uint8_t *destination, uint16_t len_max)
+{
+    t_bitmap_glyph glyph;
+
+    if (bitmap_font_find(font, code, &glyph) == false) return 0U;
+    if (((size_t)glyph.width * glyph.pages) > len_max) return 0U;
+
+    bitmap_glyph_decode(&glyph, destination);
+
+    return glyph.width;
+}
+
+uint8_t bitmap_font_draw(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                         const t_bitmap_font *font, uint8_t code, int16_t x, int16_t y, e_bitmap_rop rop)
+{
+    return bitmap_font_draw_scaled(destination, dst_width, dst_height, font, code, x, y, 1U, rop);
+}
+
+uint8_t bitmap_font_draw_scaled(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                                const t_bitmap_font *font, uint8_t code, int16_t x, int16_t y,
+                                uint8_t scale, e_bitmap_rop rop)
+{
+    t_bitmap_glyph glyph;
+    uint8_t scratch[BITMAP_FONT_GLYPH_MAX];
+    uint8_t column[BITMAP_GLYPH_COLUMN_MAX];
+    uint8_t phase = (uint8_t)(((y % 8) + 8) % 8);
+    uint16_t width;
+    uint16_t height;
+    uint8_t cx;
+    uint8_t sx;
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+    const t_bitmap_cache_entry *e;
+#endif
+
+    if (scale == 0U) scale = 1U;
+    if (bitmap_font_find(font, code, &glyph) == false) return 0U;
+
+    width = (uint16_t)glyph.width * scale;
+    height = (uint16_t)glyph.height * scale;
+    if ((width > 0xFFU) || ((height + phase) > 0xFFU)) return 0U;
+
+    if ((glyph.encoding == (uint8_t)BITMAP_FONT_RAW) && (scale == 1U))
+    {
+        /* already in the blit format */
+        bitmap_blit(destination, dst_width, dst_height, glyph.data, glyph.width, glyph.height, x, y, rop);
+        return glyph.width;
+    }
+
+#if BITMAP_GLYPH_CACHE_SIZE > 0U
+    /* rendered with its phase, it is blitted on page boundaries */
+    e = bitmap_cache_get(font, code, &glyph, scale, phase);
+    if (e != NULL)
+    {
+        bitmap_blit_generic(destination, dst_width, dst_height, e->data, e->width, e->height,
+                            x, (int16_t)(y - phase), rop, false, phase);
+        return e->width;
+    }
+#endif
+
+    if (((size_t)glyph.width * glyph.pages) > sizeof(scratch))
+    {
+        /* too large for BITMAP_FONT_GLYPH_MAX: nothing drawn */
+        return 0U;
+    }
+    bitmap_glyph_decode(&glyph, scratch);
+
+    if (scale == 1U)
+    {
+        bitmap_blit_ram(destination, dst_width, dst_height, scratch, glyph.width, glyph.height, x, y, rop);
+    }
+    else
+    {
+        /* one scaled column at a time, repeated 'scale' times */
+        for (cx = 0U; cx < glyph.width; cx++)
+        {
+            bitmap_glyph_column(scratch, &glyph, cx, scale, 0U, column);
+            for (sx = 0U; sx < scale; sx++)
+            {
+                bitmap_blit_ram(destination, dst_width, dst_height, column, 1U, height,
+                                (int16_t)(x + (int16_t)(((uint16_t)cx * scale) + sx)), y, rop);
+            }
+        }
+    }
+
+    return (uint8_t)width;
+}
+
+uint8_t bitmap_font_width(const t_bitmap_font *font, uint8_t code)
+{
+    t_bitmap_glyph glyph;
+
+    return (bitmap_font_find(font, code, &glyph) == true) ? glyph.width : 0U;
+}
+
+uint8_t bitmap_font_height(const t_bitmap_font *font)
+{
+    return BITMAP_READ_BYTE(&font->height);
+}
+
+uint16_t bitmap_font_text_width(const t_bitmap_font *font, const char *str)
+{
+    uint16_t width = 0U;
+
+    while (*str != '\0')
+    {
+        width = (uint16_t)(width + bitmap_font_width(font, (uint8_t)*str));
+        str++;
+    }
+
+    return width;
+}
+
+/**
+ * Combine some bits of a destination byte.
+ */
+static inline void bitmap_rop(uint8_t *d, uint8_t bits, uint8_t mask, e_bitmap_rop rop)
+{
+    switch (rop)
+    {
+        case BITMAP_ROP_COPY:
+            *d = (uint8_t)((*d & (uint8_t)~mask) | (bits & mask));
+            break;
+        case BITMAP_ROP_OR:
+            *d |= (uint8_t)(bits & mask);
+            break;
+        case BITMAP_ROP_AND:
+            *d &= (uint8_t)(bits | (uint8_t)~mask);
+            break;
+        default:
+            *d ^= (uint8_t)(bits & mask);
+            break;
+    }
+}
+
+/**
+ * Blit rows 'top' to h - 1 of a source bitmap, the rows above 'top'
+ * being left untouched in the destination.
+ */
+static void bitmap_blit_generic(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                                const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y,
+                                e_bitmap_rop rop, bool progmem, uint8_t top)
+{
+    uint16_t src_pages = (uint16_t)((h + 7U) / 8U);
+    int32_t dst_pages = (int32_t)((dst_height + 7U) / 8U);
+    uint16_t sp;
+    int32_t row;
+    int32_t dp;
+    uint8_t shift;
+    uint8_t valid;
+    int32_t cx;
+    int32_t cx_start = (x < 0) ? -(int32_t)x : 0;
+    int32_t cx_end = (int32_t)w;
+    uint8_t s;
+    uint16_t bits;
+    uint16_t mask;
+    uint8_t *d;
+
+    /* clip the columns */
+    if (((int32_t)x + cx_end) > (int32_t)dst_width) cx_end = (int32_t)dst_width - x;
+    if (cx_start >= cx_end) return;
+
+    for (sp = 0; sp < src_pages; sp++)
+    {
+        /* destination page and shift of this source page (floor division) */
+        row = (int32_t)y + ((int32_t)sp * 8);
+        dp = (row >= 0) ? (row / 8) : -((7 - row) / 8);
+        shift = (uint8_t)(row - (dp * 8));
+
+        /* rows of the last source page past h are not part of the bitmap */
+        valid = ((sp == (src_pages - 1U)) && ((h % 8U) != 0U)) ? (uint8_t)((1U << (h % 8U)) - 1U) : 0xFFU;
+        if (sp == 0U) valid &= (uint8_t)(0xFFU << top);
+        mask = (uint16_t)((uint16_t)valid << shift);
+
+        /* skip pages that fall entirely outside */
+        if (((dp + 1) < 0) || (dp >= dst_pages)) continue;
+
+        for (cx = cx_start; cx < cx_end; cx++)
+        {
 #ifdef __AVR
-        memcpy_P(destination, font5x8 + (chr * 8U), size);
+            s = progmem ? pgm_read_byte(&source[((size_t)sp * w) + (size_t)cx]) : source[((size_t)sp * w) + (size_t)cx];
 #else
-    /* other generic C platforms */
-    memcpy(destination, font5x8 + (chr * 8U), size);
+            (void)progmem;
+            s = source[((size_t)sp * w) + (size_t)cx];
 #endif
+            bits = (uint16_t)((uint16_t)s << shift);
+            d = &destination[(size_t)(x + cx)];
+
+            /* the lower part lands on page dp, the upper part on page dp + 1 */
+            if (dp >= 0)
+            {
+                bitmap_rop(&d[(size_t)dp * dst_width], (uint8_t)bits, (uint8_t)mask, rop);
+            }
+            if ((shift != 0U) && ((dp + 1) < dst_pages))
+            {
+                bitmap_rop(&d[(size_t)(dp + 1) * dst_width], (uint8_t)(bits >> 8), (uint8_t)(mask >> 8), rop);
+            }
+        }
     }
 }
+
+void bitmap_blit(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                 const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop)
+{
+    bitmap_blit_generic(destination, dst_width, dst_height, source, w, h, x, y, rop, true, 0U);
+}
+
+void bitmap_blit_ram(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                     const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop)
+{
+    bitmap_blit_generic(destination, dst_width, dst_height, source, w, h, x, y, rop, false, 0U);
+}
@@ -8,6 +8,12 @@
 #ifndef DEASPLAY_BITMAP_H_
 #define DEASPLAY_BITMAP_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "deasplay_config.h"
+
 #ifdef __AVR
 /* RAM is not sufficient to store bitmaps, place them in the flash memory */
 #include <avr/pgmspace.h>
@@ -16,21 +22,208 @@
 #define BITMAP_STORAGE_FLAGS        /* not defined on other platforms */
 #endif
 
+/**< How blitted pixels are combined with the destination */
+typedef enum _e_bitmap_rop
+{
+    BITMAP_ROP_COPY,    /**< Replace */
+    BITMAP_ROP_OR,      /**< Draw the pixels that are set */
+    BITMAP_ROP_AND,     /**< Erase the pixels that are not set */
+    BITMAP_ROP_XOR      /**< Invert the pixels that are set */
+} e_bitmap_rop;
+
+/* Glyphs of a font larger than this many bytes are not drawn
+ * by bitmap_font_draw(), which decodes them on the stack */
+#ifndef BITMAP_FONT_GLYPH_MAX
+#define BITMAP_FONT_GLYPH_MAX       (72U)
+#endif
+
+/* Rendered glyph cache: entries and bytes per entry. The cache keeps
+ * decompressed, scaled and row-shifted glyphs ready to be blitted
+ * (a clock cycles through 10 digits and a colon); a size of 0 leaves it out. */
+#ifndef BITMAP_GLYPH_CACHE_SIZE
+#ifdef __AVR
+#define BITMAP_GLYPH_CACHE_SIZE     (0U)
+#else
+#define BITMAP_GLYPH_CACHE_SIZE     (12U)
+#endif
+#endif
+#ifndef BITMAP_GLYPH_CACHE_BYTES
+#define BITMAP_GLYPH_CACHE_BYTES    (192U)
+#endif
+#if BITMAP_GLYPH_CACHE_SIZE > 255U
+#error "BITMAP_GLYPH_CACHE_SIZE must not exceed 255"
+#endif
+
+/* Bytes of a scaled glyph column: glyphs are drawn up to 255 pixels tall */
+#define BITMAP_GLYPH_COLUMN_MAX     (32U)
+
+/**< Glyph cache counters */
+typedef struct _t_bitmap_cache_stats
+{
+    uint32_t hits;      /**< Glyphs found rendered */
+    uint32_t misses;    /**< Glyphs rendered into the cache */
+} t_bitmap_cache_stats;
+
+/**< How the glyphs of a font are stored */
+typedef enum _e_bitmap_font_encoding
+{
+    BITMAP_FONT_RAW,    /**< Pages of one byte per column, as the bitmap buffer */
+    BITMAP_FONT_RLE,    /**< The raw bytes in packets: n = 0x00-0x7F copies the n + 1 following bytes,
+                             n = 0x80-0xFF repeats the following byte (n & 0x7F) + 1 times */
+    BITMAP_FONT_BITS    /**< Columns of 'height' bits packed one after the other, from the LSB */
+} e_bitmap_font_encoding;
+
+/**< A range of consecutive codes of a font */
+typedef struct _t_bitmap_font_range
+{
+    uint8_t first;      /**< First code of the range */
+    uint8_t last;       /**< Last code of the range */
+    uint16_t glyph;     /**< Glyph index of the first code */
+} t_bitmap_font_range;
+
+/**< A font descriptor. The descriptor and all its tables are read the
+ * same way as the bitmaps (i.e. from flash on AVR). Descriptors are made
+ * by tools/fontgen.py out of BDF or TrueType fonts. */
+typedef struct _t_bitmap_font
+{
+    uint8_t width;                      /**< Glyph width, the widest glyph of proportional fonts */
+    uint8_t height;                     /**< Glyph height in pixels */
+    uint8_t encoding;                   /**< Glyph encoding, see e_bitmap_font_encoding */
+    uint8_t ranges;                     /**< Number of code ranges */
+    uint8_t fallback;                   /**< Code drawn in place of the codes out of the ranges */
+    const t_bitmap_font_range *range;   /**< Code ranges, in any order */
+    const uint8_t *widths;              /**< Width of every glyph, NULL when all are 'width' wide */
+    const uint16_t *offsets;            /**< Offset of every glyph in 'data', NULL when the glyphs
+                                             are raw or bit-packed and all 'width' wide */
+    const uint8_t *data;                /**< Glyph data */
+} t_bitmap_font;
+
 extern const uint8_t font5x8[] BITMAP_STORAGE_FLAGS;
+extern const t_bitmap_font bitmap_font_5x8 BITMAP_STORAGE_FLAGS;
+#ifdef BITMAP_HAS_FONT_8x16
+extern const t_bitmap_font bitmap_font_8x16 BITMAP_STORAGE_FLAGS;
+#endif
+#ifdef BITMAP_HAS_FONT_12x24_DIGITS
+extern const t_bitmap_font bitmap_font_12x24_digits BITMAP_STORAGE_FLAGS;
+#endif
 
+/**< The built-in fonts. Except for FONT_5x8 they are linked in
+ * only when enabled in deasplay_config.h, from the fonts directory. */
 typedef enum _e_font
 {
-    FONT_5x8
+    FONT_5x8,               /**< 5x8 glyphs in 8x8 cells, codes 0-255 (32-126 with BITMAP_FONT5x8_ASCII) */
+#ifdef BITMAP_HAS_FONT_8x16
+    FONT_8x16,              /**< Printable ASCII in 8x16 cells */
+#endif
+#ifdef BITMAP_HAS_FONT_12x24_DIGITS
+    FONT_12x24_DIGITS,      /**< Digits, ':', '-', '.' and space in 12x24 cells */
+#endif
 } e_font;
 
+/**
+ * Get the descriptor of a built-in font.
+ * @param font  the font
+ * @return the font descriptor
+ */
+const t_bitmap_font* bitmap_font(e_font font);
+
 /**
  * Write a selected character on a given buffer.
  * The function can internally fetch the data in different ways, depending on the platform
  * but the output is always defined as an array of bytes.
+ * Glyphs taller than 8 pixels are written as consecutive pages of the glyph width.
+ * @param chr   the character code (codepage_font5x8 translates UTF-8 text for FONT_5x8)
  * @param destination
  * @param len_max
  * @param font
  */
-void bitmap_character(char chr, uint8_t *destination, uint8_t len_max, e_font font);
+void bitmap_character(uint8_t chr, uint8_t *destination, uint8_t len_max, e_font font);
+
+/**
+ * Decode a glyph into pages of one byte per column, as the bitmap buffer.
+ * Codes missing in the font are replaced by the fallback code.
+ * @param font          the font descriptor
+ * @param code          the character code
+ * @param destination   the destination, ((height + 7) / 8) pages of the glyph width
+ * @param len_max       size of the destination
+ * @return the glyph width, 0 if the glyph does not fit or is missing
+ */
+uint8_t bitmap_font_glyph(const t_bitmap_font *font, uint8_t code, uint8_t *destination, uint16_t len_max);
+
+/**
+ * Draw a glyph at any pixel position of a paged buffer, see bitmap_blit().
+ * @return the glyph width, i.e. the advance to the next character,
+ *         0 if missing or too large (see bitmap_font_draw_scaled())
+ */
+uint8_t bitmap_font_draw(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                         const t_bitmap_font *font, uint8_t code, int16_t x, int16_t y, e_bitmap_rop rop);
+
+/**
+ * Draw a glyph magnified 'scale' times, see bitmap_font_draw().
+ * Compressed, scaled or not page aligned glyphs go through the glyph cache.
+ * @return the scaled glyph width, 0 if missing or too large
+ */
+uint8_t bitmap_font_draw_scaled(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                                const t_bitmap_font *font, uint8_t code, int16_t x, int16_t y,
+                                uint8_t scale, e_bitmap_rop rop);
+
+/**
+ * Empty the glyph cache and reset its counters.
+ */
+void bitmap_cache_clear(void);
+
+/**
+ * Get the glyph cache counters, the hit rate being hits / (hits + misses).
+ * @param stats the destination
+ */
+void bitmap_cache_get_stats(t_bitmap_cache_stats *stats);
+
+/**
+ * Get the width of a glyph.
+ * @param font  the font descriptor
+ * @param code  the character code
+ * @return the glyph width, 0 if missing
+ */
+uint8_t bitmap_font_width(const t_bitmap_font *font, uint8_t code);
+
+/**
+ * Get the height of the glyphs of a font.
+ * @param font  the font descriptor
+ * @return the height in pixels
+ */
+uint8_t bitmap_font_height(const t_bitmap_font *font);
+
+/**
+ * Get the width of a string.
+ * @param font  the font descriptor
+ * @param str   a NUL terminated string
+ * @return the width in pixels
+ */
+uint16_t bitmap_font_text_width(const t_bitmap_font *font, const char *str);
+
+/**
+ * Draw a bitmap at any pixel position of a paged buffer.
+ * Both bitmaps are organized in pages of 8 rows, one byte per column,
+ * the least significant bit being the top row. The source is shifted
+ * and merged across destination pages and clipped against its edges.
+ * The source is read the same way as the fonts (i.e. from flash on AVR).
+ * @param destination   the destination buffer
+ * @param dst_width     destination width (bytes per page)
+ * @param dst_height    destination height in pixels
+ * @param source        the source bitmap, ((h + 7) / 8) pages of w bytes
+ * @param w             source width
+ * @param h             source height
+ * @param x             destination column of the left edge
+ * @param y             destination row of the top edge
+ * @param rop           raster operation
+ */
+void bitmap_blit(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                 const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop);
+
+/**
+ * Same as bitmap_blit() for a source that lives in RAM.
+ */
+void bitmap_blit_ram(uint8_t *destination, uint16_t dst_width, uint16_t dst_height,
+                     const uint8_t *source, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop);
 
 #endif /* DEASPLAY_BITMAP_H_ */
@@ -0,0 +1,136 @@
+/*
+ * busbatch.c
+ *
+ *  Bus transaction batching for drivers.
+ */
+
+#include <string.h>
+
+#include "busbatch.h"
+
+void busbatch_init(t_busbatch *batch, e_busbatch_framing framing, uint8_t *buffer, size_t size, t_busbatch_transfer transfer)
+{
+    memset(batch, 0, sizeof(*batch));
+    batch->buffer = buffer;
+    batch->size = size;
+    batch->transfer = transfer;
+    batch->framing = (uint8_t)framing;
+}
+
+void busbatch_flush(t_busbatch *batch)
+{
+    if (batch->used == 0U) return;
+
+    batch->transfer((e_busbatch_kind)batch->kind, batch->buffer, batch->used);
+    batch->transactions++;
+    batch->used = 0U;
+}
+
+/**
+ * Open a stream of bytes of a kind at the end of the transaction.
+ * @param batch     the stage
+ * @param kind      e_busbatch_kind of the stream
+ */
+static void busbatch_open(t_busbatch *batch, uint8_t kind)
+{
+    if (batch->framing == (uint8_t)BUSBATCH_I2C_CONTROL)
+    {
+        batch->stream = batch->used;
+        batch->buffer[batch->used++] = (kind == (uint8_t)BUSBATCH_DATA) ? BUSBATCH_I2C_DC : 0x00U;
+    }
+    batch->kind = kind;
+}
+
+/**
+ * Bytes of another kind follow: keep the transaction open when the
+ * framing allows it at a low enough cost, otherwise perform it.
+ * @param batch     the stage
+ * @param kind      e_busbatch_kind of the following bytes
+ */
+static void busbatch_switch(t_busbatch *batch, uint8_t kind)
+{
+    size_t n;
+    size_t i;
+    uint8_t control;
+    uint8_t byte;
+
+    if (batch->framing == (uint8_t)BUSBATCH_I2C_CONTROL)
+    {
+        /* the last stream becomes Co pairs, one control byte per byte,
+         * which costs n - 1 bytes; then the new stream needs a control
+         * byte and room for one byte */
+        n = batch->used - batch->stream - 1U;
+        if (((n - 1U) <= BUSBATCH_I2C_OVERHEAD) && ((batch->used + n + 1U) <= batch->size))
+        {
+            control = (uint8_t)(batch->buffer[batch->stream] | BUSBATCH_I2C_CO);
+            /* from the end, no byte is overwritten before being moved */
+            for (i = n; i > 0U; i--)
+            {
+                byte = batch->buffer[batch->stream + i];
+                batch->buffer[batch->stream + (2U * i) - 1U] = byte;
+                batch->buffer[batch->stream + (2U * i) - 2U] = control;
+            }
+            batch->used = batch->stream + (2U * n);
+            busbatch_open(batch, kind);
+            return;
+        }
+    }
+    busbatch_flush(batch);
+}
+
+/**
+ * Queue bytes of a kind, performing the transactions that fill up.
+ * @param batch     the stage
+ * @param kind      e_busbatch_kind of the bytes
+ * @param data      the bytes
+ * @param len       number of bytes
+ */
+static void busbatch_put(t_busbatch *batch, uint8_t kind, const uint8_t *data, size_t len)
+{
+    size_t n;
+
+    /* raw transactions mix both kinds */
+    if (batch->framing == (uint8_t)BUSBATCH_RAW) kind = batch->kind;
+
+    if ((batch->used != 0U) && (kind != batch->kind)) busbatch_switch(batch, kind);
+    while (len > 0U)
+    {
+        if (batch->used == 0U) busbatch_open(batch, kind);
+        n = batch->size - batch->used;
+        if (n > len) n = len;
+        memcpy(&batch->buffer[batch->used], data, n);
+        batch->used += n;
+        data += n;
+        len -= n;
+        if (batch->used == batch->size) busbatch_flush(batch);
+    }
+    /* outside a refresh every call is a transaction */
+    if (batch->batching == false) busbatch_flush(batch);
+}
+
+void busbatch_command(t_busbatch *batch, const uint8_t *cmd, size_t len)
+{
+    busbatch_put(batch, (uint8_t)BUSBATCH_COMMAND, cmd, len);
+}
+
+void busbatch_data(t_busbatch *batch, const uint8_t *data, size_t len)
+{
+    busbatch_put(batch, (uint8_t)BUSBATCH_DATA, data, len);
+}
+
+void busbatch_state(t_busbatch *batch, e_deasplay_state state)
+{
+    switch (state)
+    {
+        case DEASPLAY_STATE_PERIODIC_START:
+        case DEASPLAY_STATE_PERIODIC_RESUME:
+            batch->batching = true;
+            break;
+        default:
+            /* paused or over: the calls until the next start, e.g. a
+             * scroll between two steps, are transactions of their own */
+            busbatch_flush(batch);
+            batch->batching = false;
+            break;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * busbatch.h
+ *
+ *  Bus transaction batching for drivers: the command and data bytes a
+ *  refresh produces are collected and merged into as few bus transactions
+ *  as the framing allows, instead of one transaction per HAL call.
+ *
+ *  The driver keeps a t_busbatch, feeds it with busbatch_command() and
+ *  busbatch_data() from its HAL functions, forwards its state callback to
+ *  busbatch_state() and performs the transactions in the transfer function
+ *  it supplies (e.g. one write on its taxibus hw_interface). Outside a
+ *  refresh (initialization, power) every call is a transaction of its own,
+ *  so delays between commands keep working.
+ */
+
+#ifndef DEASPLAY_BUSBATCH_H_
+#define DEASPLAY_BUSBATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "deasplay_hal.h"
+
+/* I2C control byte (SSD1306, ST7032, AIP31068 and similar): Co set, one
+ * byte follows and then another control byte; Co clear, all the bytes up
+ * to the stop are of the same kind. D/C selects command or data. */
+#define BUSBATCH_I2C_CO             (0x80U)
+#define BUSBATCH_I2C_DC             (0x40U)
+
+/* Cost of starting a new I2C transaction (address byte, start and stop
+ * conditions) in bytes: a short command or data stream is turned into
+ * Co continuation pairs, keeping the transaction open, when that costs no
+ * more than this. */
+#ifndef BUSBATCH_I2C_OVERHEAD
+#define BUSBATCH_I2C_OVERHEAD       (2U)
+#endif
+
+/**< How commands and data share a transaction */
+typedef enum _e_busbatch_framing
+{
+    BUSBATCH_RAW,               /**< No distinction: every byte goes in the same transaction (e.g. an I2C port expander) */
+    BUSBATCH_I2C_CONTROL,       /**< I2C with control bytes: commands and data share a transaction */
+    BUSBATCH_SPI                /**< SPI with a D/C line: a burst per run of commands or of data */
+} e_busbatch_framing;
+
+/**< Kind of the bytes */
+typedef enum _e_busbatch_kind
+{
+    BUSBATCH_COMMAND,
+    BUSBATCH_DATA
+} e_busbatch_kind;
+
+/**
+ * Perform one bus transaction.
+ * @param kind      SPI: level of the D/C line; I2C: kind of the last bytes,
+ *                  the bytes carry their own control bytes
+ * @param data      the bytes
+ * @param len       number of bytes
+ */
+typedef void (*t_busbatch_transfer)(e_busbatch_kind kind, const uint8_t *data, size_t len);
+
+/**< A batching stage (see busbatch_init()) */
+typedef struct _t_busbatch
+{
+    uint8_t *buffer;                /**< The transaction being collected */
+    size_t size;                    /**< Capacity of the buffer, the longest transaction */
+    size_t used;                    /**< Bytes in the buffer */
+    size_t stream;                  /**< I2C: index of the control byte of the last stream */
+    t_busbatch_transfer transfer;   /**< Performs a transaction */
+    uint32_t transactions;          /**< Transactions performed */
+    uint8_t framing;                /**< e_busbatch_framing */
+    uint8_t kind;                   /**< e_busbatch_kind of the last bytes */
+    bool batching;                  /**< Within a refresh: hold the bytes until the buffer is full or the refresh ends */
+} t_busbatch;
+
+/**
+ * Initialize a batching stage.
+ * @param batch     the stage
+ * @param framing   how commands and data share a transaction
+ * @param buffer    room for a transaction (at least 2 bytes); its size also
+ *                  bounds the transactions, e.g. 32 with the Arduino Wire library
+ * @param size      size of the buffer
+ * @param transfer  performs a transaction
+ */
+void busbatch_init(t_busbatch *batch, e_busbatch_framing framing, uint8_t *buffer, size_t size, t_busbatch_transfer transfer);
+
+/**
+ * Queue command bytes.
+ * @param batch     the stage
+ * @param cmd       the commands
+ * @param len       number of bytes
+ */
+void busbatch_command(t_busbatch *batch, const uint8_t *cmd, size_t len);
+
+/**
+ * Queue data bytes.
+ * @param batch     the stage
+ * @param data      the data
+ * @param len       number of bytes
+ */
+void busbatch_data(t_busbatch *batch, const uint8_t *data, size_t len);
+
+/**
+ * Perform the transaction being collected, if any.
+ * @param batch     the stage
+ */
+void busbatch_flush(t_busbatch *batch);
+
+/**
+ * Follow the refresh: batch from its start (PERIODIC_START, or
+ * PERIODIC_RESUME after a pause), flush and stop batching when it pauses (display_periodic_step()
+ * out of budget) and when it ends.
+ * Call it from deasplay_hal_state_callback().
+ * @param batch     the stage
+ * @param state     the state notified
+ */
+void busbatch_state(t_busbatch *batch, e_deasplay_state state);
+
+#endif /* DEASPLAY_BUSBATCH_H_ */
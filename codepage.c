@@ -0,0 +1,123 @@
+/*
+ * codepage.c
+ *
+ *  UTF-8 decoding and code point translation.
+ */
+
+#include <string.h>
+
+#include "codepage.h"
+
+#ifdef __AVR
+#define CODEPAGE_READ_BYTE(p)       pgm_read_byte(p)
+#define CODEPAGE_READ(d, s, n)      memcpy_P((d), (s), (n))
+#else
+#define CODEPAGE_READ_BYTE(p)       (*(p))
+#define CODEPAGE_READ(d, s, n)      memcpy((d), (s), (n))
+#endif
+
+/* Decoder states, as offsets of their row in codepage_utf8_next */
+#define CODEPAGE_UTF8_ACCEPT        (0U)
+#define CODEPAGE_UTF8_REJECT        (12U)
+#define CODEPAGE_UTF8_CLASSES       (12U)
+
+/* Classes of the bytes: 0 ASCII, 1-3 continuation 80-8F, 90-9F, A0-BF,
+ * 4 lead of 2 bytes, 5-7 leads of 3 bytes (E0, E1-EC EE-EF, ED),
+ * 8-10 leads of 4 bytes (F0, F1-F3, F4), 11 never valid */
+static const uint8_t codepage_utf8_class[256] CODEPAGE_STORAGE_FLAGS =
+{
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  /* 00 */
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  /* 20 */
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  /* 40 */
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  /* 60 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 80 */
+    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,  /* A0 */
+    11,11,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,  /* C0 */
+    5,6,6,6,6,6,6,6,6,6,6,6,6,7,6,6,8,9,9,9,10,11,11,11,11,11,11,11,11,11,11,11  /* E0 */
+};
+
+/* Payload bits of a byte starting a character, per class */
+static const uint8_t codepage_utf8_mask[CODEPAGE_UTF8_CLASSES] CODEPAGE_STORAGE_FLAGS =
+{
+    0x7FU, 0x00U, 0x00U, 0x00U, 0x1FU, 0x0FU, 0x0FU, 0x0FU, 0x07U, 0x07U, 0x07U, 0x00U
+};
+
+/* Next state, per state and class. Besides accept and reject the states
+ * count the continuation bytes still expected, the first one restricted
+ * after E0 (A0-BF), ED (80-9F, no surrogates), F0 (90-BF) and F4 (80-8F) */
+static const uint8_t codepage_utf8_next[9U * CODEPAGE_UTF8_CLASSES] CODEPAGE_STORAGE_FLAGS =
+{
+/*   ASC  80   90   A0   C2   E0   E1   ED   F0   F1   F4   bad */
+      0,  12,  12,  12,  24,  48,  36,  60,  84,  72,  96,  12,     /*  0: accept */
+     12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12,     /* 12: reject */
+     12,   0,   0,   0,  12,  12,  12,  12,  12,  12,  12,  12,     /* 24: 1 more */
+     12,  24,  24,  24,  12,  12,  12,  12,  12,  12,  12,  12,     /* 36: 2 more */
+     12,  12,  12,  24,  12,  12,  12,  12,  12,  12,  12,  12,     /* 48: 2 more after E0 */
+     12,  24,  24,  12,  12,  12,  12,  12,  12,  12,  12,  12,     /* 60: 2 more after ED */
+     12,  36,  36,  36,  12,  12,  12,  12,  12,  12,  12,  12,     /* 72: 3 more */
+     12,  12,  36,  36,  12,  12,  12,  12,  12,  12,  12,  12,     /* 84: 3 more after F0 */
+     12,  36,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12      /* 96: 3 more after F4 */
+};
+
+void codepage_load(t_codepage *dest, const t_codepage *page)
+{
+    CODEPAGE_READ(dest, page, sizeof(*dest));
+}
+
+uint8_t codepage_lookup(const t_codepage *page, uint32_t code)
+{
+    uint16_t block;
+
+    if (code > 0xFFFFUL) return page->fallback;
+
+    block = CODEPAGE_READ_BYTE(&page->top[code >> (CODEPAGE_LEAF_BITS + CODEPAGE_MID_BITS)]);
+    block = CODEPAGE_READ_BYTE(&page->mid[(block << CODEPAGE_MID_BITS) | ((code >> CODEPAGE_LEAF_BITS) & ((1U << CODEPAGE_MID_BITS) - 1U))]);
+    return CODEPAGE_READ_BYTE(&page->leaf[(block << CODEPAGE_LEAF_BITS) | (code & ((1U << CODEPAGE_LEAF_BITS) - 1U))]);
+}
+
+const char* codepage_next(const t_codepage *page, const char *str, uint8_t *code)
+{
+    const uint8_t *s = (const uint8_t*)str;
+    uint32_t point = 0U;
+    uint8_t state = CODEPAGE_UTF8_ACCEPT;
+    uint8_t cls;
+
+    do
+    {
+        cls = CODEPAGE_READ_BYTE(&codepage_utf8_class[*s]);
+        point = (state == CODEPAGE_UTF8_ACCEPT) ? (uint32_t)(*s & CODEPAGE_READ_BYTE(&codepage_utf8_mask[cls]))
+                                                : ((point << 6) | (*s & 0x3FU));
+        state = CODEPAGE_READ_BYTE(&codepage_utf8_next[state + cls]);
+        s++;
+    } while (state > CODEPAGE_UTF8_REJECT);
+
+    if (state == CODEPAGE_UTF8_REJECT)
+    {
+        /* the byte breaking a sequence (or its terminator) may start the next one */
+        if ((s - (const uint8_t*)str) > 1) s--;
+        *code = page->fallback;
+    }
+    else
+    {
+        *code = codepage_lookup(page, point);
+    }
+
+    return (const char*)s;
+}
+
+size_t codepage_translate(const t_codepage *page, const char *str, uint8_t *dest, size_t size)
+{
+    t_codepage p;
+    size_t len = 0U;
+
+    if (size == 0U) return 0U;
+    codepage_load(&p, page);
+    while ((*str != '\0') && (len < (size - 1U)))
+    {
+        str = codepage_next(&p, str, &dest[len]);
+        len++;
+    }
+    dest[len] = 0U;
+
+    return len;
+}
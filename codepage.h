@@ -0,0 +1,85 @@
+/*
+ * codepage.h
+ *
+ *  UTF-8 text on displays with their own character sets: a table driven
+ *  UTF-8 decoder and, per controller, a table translating code points
+ *  into the character codes the controller shows them with. The tables
+ *  are made by tools/codepagegen.py and live in the codepages directory;
+ *  link in the ones of the displays in use.
+ */
+
+#ifndef DEASPLAY_CODEPAGE_H_
+#define DEASPLAY_CODEPAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __AVR
+/* the tables are read from the flash memory */
+#include <avr/pgmspace.h>
+#define CODEPAGE_STORAGE_FLAGS      PROGMEM
+#else
+#define CODEPAGE_STORAGE_FLAGS      /* not defined on other platforms */
+#endif
+
+/* Bits of the code point indexing the mid and leaf blocks of a table,
+ * the top table takes the remaining bits of the 16 (see codepagegen.py) */
+#define CODEPAGE_LEAF_BITS          (5U)
+#define CODEPAGE_MID_BITS           (5U)
+
+/**< Code points U+0000 to U+FFFF to character codes, in three levels:
+ * top[cp >> 10] selects a block of mid, which selects a block of leaf
+ * holding the codes. Identical blocks are stored once. The descriptor and
+ * its tables are read the same way as the fonts (i.e. from flash on AVR). */
+typedef struct _t_codepage
+{
+    const uint8_t *top;         /**< Mid block of every 1024 code points */
+    const uint8_t *mid;         /**< Leaf block of every 32 code points */
+    const uint8_t *leaf;        /**< Character code of every code point */
+    uint8_t fallback;           /**< Character code shown for malformed text and code points beyond U+FFFF */
+} t_codepage;
+
+/* The character sets (only the ones linked in can be used) */
+extern const t_codepage codepage_hd44780_a00 CODEPAGE_STORAGE_FLAGS;  /**< HD44780 ROM A00, Japanese */
+extern const t_codepage codepage_hd44780_a02 CODEPAGE_STORAGE_FLAGS;  /**< HD44780 ROM A02, European */
+extern const t_codepage codepage_lc75710 CODEPAGE_STORAGE_FLAGS;      /**< LC75710 VFD */
+extern const t_codepage codepage_font5x8 CODEPAGE_STORAGE_FLAGS;      /**< font5x8 of the bitmap displays */
+extern const t_codepage codepage_ascii CODEPAGE_STORAGE_FLAGS;        /**< Printable ASCII (BITMAP_FONT5x8_ASCII) */
+
+/**
+ * Copy a codepage descriptor into RAM, as codepage_next() and
+ * codepage_lookup() take it.
+ * @param dest      the copy
+ * @param page      the codepage
+ */
+void codepage_load(t_codepage *dest, const t_codepage *page);
+
+/**
+ * Character code of a code point.
+ * @param page      the codepage, loaded with codepage_load()
+ * @param code      the code point
+ * @return the character code
+ */
+uint8_t codepage_lookup(const t_codepage *page, uint32_t code);
+
+/**
+ * Decode the next character of a UTF-8 string. A malformed sequence
+ * gives one fallback code and decoding resumes on the byte breaking it.
+ * @param page      the codepage, loaded with codepage_load()
+ * @param str       the string, not at its end
+ * @param code      the character code
+ * @return the rest of the string
+ */
+const char* codepage_next(const t_codepage *page, const char *str, uint8_t *code);
+
+/**
+ * Translate a UTF-8 string into character codes, e.g. for graphics_text().
+ * @param page      the codepage
+ * @param str       the string
+ * @param dest      the character codes, NUL terminated
+ * @param size      size of dest
+ * @return the number of character codes
+ */
+size_t codepage_translate(const t_codepage *page, const char *str, uint8_t *dest, size_t size);
+
+#endif /* DEASPLAY_CODEPAGE_H_ */
@@ -0,0 +1,129 @@
+/*
+ * codepage_ascii.c
+ *
+ *  Code points to character codes: Printable ASCII, e.g. font5x8 with BITMAP_FONT5x8_ASCII.
+ *  Generated by tools/codepagegen.py, 846 code points shown, fallback 0x3F,
+ *  1600 bytes of tables. Do not edit, generate it again instead.
+ */
+
+#include "codepage.h"
+
+static const uint8_t codepage_ascii_top[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x01,0x02,0x00,0x00,0x00,0x00,0x00,0x03,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x05
+};
+
+static const uint8_t codepage_ascii_mid[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 0
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x01,0x02,0x03,0x00,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x00,0x0B,0x0C,0x0D, // 1
+    0x0E,0x0F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x11,0x12,0x13,0x14,0x15,
+    0x16,0x17,0x18,0x00,0x00,0x00,0x19,0x1A,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 2
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x1B,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 3
+    0x1C,0x1D,0x1E,0x1F,0x20,0x21,0x22,0x23,0x00,0x00,0x00,0x00,0x00,0x24,0x00,0x00,
+    0x25,0x26,0x27,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 4
+    0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 5
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x29,0x02,0x03,0x00,0x00,0x00,0x00,0x00
+};
+
+static const uint8_t codepage_ascii_leaf[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 0
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F, // 1
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F, // 2
+    0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+    0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F, // 3
+    0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x3F,
+    0x20,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,0x3F,0x61,0x22,0x3F,0x3F,0x3F,0x20, // 4
+    0x3F,0x3F,0x32,0x33,0x27,0x75,0x3F,0x2E,0x20,0x31,0x6F,0x22,0x3F,0x3F,0x3F,0x3F,
+    0x41,0x41,0x41,0x41,0x41,0x41,0x41,0x43,0x45,0x45,0x45,0x45,0x49,0x49,0x49,0x49, // 5
+    0x3F,0x4E,0x4F,0x4F,0x4F,0x4F,0x4F,0x78,0x4F,0x55,0x55,0x55,0x55,0x59,0x3F,0x42,
+    0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x63,0x65,0x65,0x65,0x65,0x69,0x69,0x69,0x69, // 6
+    0x3F,0x6E,0x6F,0x6F,0x6F,0x6F,0x6F,0x3A,0x6F,0x75,0x75,0x75,0x75,0x79,0x3F,0x79,
+    0x41,0x61,0x41,0x61,0x41,0x61,0x43,0x63,0x43,0x63,0x43,0x63,0x43,0x63,0x44,0x64, // 7
+    0x44,0x64,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x47,0x67,0x47,0x67,
+    0x47,0x67,0x47,0x67,0x48,0x68,0x3F,0x3F,0x49,0x69,0x49,0x69,0x49,0x69,0x49,0x69, // 8
+    0x49,0x69,0x3F,0x3F,0x4A,0x6A,0x4B,0x6B,0x3F,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x3F,
+    0x3F,0x4C,0x6C,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x3F,0x3F,0x3F,0x4F,0x6F,0x4F,0x6F, // 9
+    0x4F,0x6F,0x4F,0x6F,0x52,0x72,0x52,0x72,0x52,0x72,0x53,0x73,0x53,0x73,0x53,0x73,
+    0x53,0x73,0x54,0x74,0x54,0x74,0x3F,0x3F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75, // 10
+    0x55,0x75,0x55,0x75,0x57,0x77,0x59,0x79,0x59,0x5A,0x7A,0x5A,0x7A,0x5A,0x7A,0x73,
+    0x4F,0x6F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x55, // 11
+    0x75,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x41,0x61,0x49, // 12
+    0x69,0x4F,0x6F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x3F,0x41,0x61,
+    0x41,0x61,0x41,0x61,0x3F,0x3F,0x47,0x67,0x4B,0x6B,0x4F,0x6F,0x4F,0x6F,0x3F,0x3F, // 13
+    0x6A,0x3F,0x3F,0x3F,0x47,0x67,0x3F,0x3F,0x4E,0x6E,0x41,0x61,0x41,0x61,0x4F,0x6F,
+    0x41,0x61,0x41,0x61,0x45,0x65,0x45,0x65,0x49,0x69,0x49,0x69,0x4F,0x6F,0x4F,0x6F, // 14
+    0x52,0x72,0x52,0x72,0x55,0x75,0x55,0x75,0x53,0x73,0x54,0x74,0x3F,0x3F,0x48,0x68,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x41,0x61,0x45,0x65,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F, // 15
+    0x4F,0x6F,0x59,0x79,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x49,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 16
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 17
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,0x3F,0x3F,0x3F,0x3B,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x20,0x20,0x41,0x2E,0x45,0x48,0x49,0x3F,0x4F,0x3F,0x59,0x3F, // 18
+    0x49,0x41,0x42,0x3F,0x3F,0x45,0x5A,0x48,0x3F,0x49,0x4B,0x3F,0x4D,0x4E,0x3F,0x4F,
+    0x3F,0x50,0x3F,0x3F,0x54,0x59,0x3F,0x58,0x3F,0x3F,0x49,0x59,0x41,0x45,0x48,0x49, // 19
+    0x59,0x41,0x42,0x3F,0x3F,0x45,0x5A,0x48,0x3F,0x49,0x4B,0x3F,0x4D,0x4E,0x3F,0x4F,
+    0x3F,0x50,0x3F,0x3F,0x54,0x59,0x3F,0x58,0x3F,0x3F,0x49,0x59,0x4F,0x59,0x3F,0x3F, // 20
+    0x42,0x3F,0x59,0x59,0x59,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 21
+    0x4B,0x50,0x3F,0x3F,0x3F,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x4B,0x3F,0x3F,0x3F, // 22
+    0x41,0x3F,0x42,0x3F,0x3F,0x45,0x3F,0x3F,0x3F,0x3F,0x4B,0x3F,0x4D,0x48,0x4F,0x3F,
+    0x50,0x43,0x54,0x3F,0x3F,0x58,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 23
+    0x41,0x3F,0x42,0x3F,0x3F,0x45,0x3F,0x3F,0x3F,0x3F,0x4B,0x3F,0x4D,0x48,0x4F,0x3F,
+    0x50,0x43,0x54,0x3F,0x3F,0x58,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 24
+    0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x4B,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 25
+    0x41,0x41,0x41,0x41,0x3F,0x3F,0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x4F,0x4F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 26
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x42,0x3F,0x4F,0x43,0x54,0x54,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 27
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x41,0x61,0x42,0x62,0x42,0x62,0x42,0x62,0x43,0x63,0x44,0x64,0x44,0x64,0x44,0x64, // 28
+    0x44,0x64,0x44,0x64,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x46,0x66,
+    0x47,0x67,0x48,0x68,0x48,0x68,0x48,0x68,0x48,0x68,0x48,0x68,0x49,0x69,0x49,0x69, // 29
+    0x4B,0x6B,0x4B,0x6B,0x4B,0x6B,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x4D,0x6D,
+    0x4D,0x6D,0x4D,0x6D,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x4F,0x6F,0x4F,0x6F, // 30
+    0x4F,0x6F,0x4F,0x6F,0x50,0x70,0x50,0x70,0x52,0x72,0x52,0x72,0x52,0x72,0x52,0x72,
+    0x53,0x73,0x53,0x73,0x53,0x73,0x53,0x73,0x53,0x73,0x54,0x74,0x54,0x74,0x54,0x74, // 31
+    0x54,0x74,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x56,0x76,0x56,0x76,
+    0x57,0x77,0x57,0x77,0x57,0x77,0x57,0x77,0x57,0x77,0x58,0x78,0x58,0x78,0x59,0x79, // 32
+    0x5A,0x7A,0x5A,0x7A,0x5A,0x7A,0x68,0x74,0x77,0x79,0x3F,0x73,0x3F,0x3F,0x3F,0x3F,
+    0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61, // 33
+    0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,
+    0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x49,0x69,0x49,0x69,0x4F,0x6F,0x4F,0x6F, // 34
+    0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,
+    0x4F,0x6F,0x4F,0x6F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75, // 35
+    0x55,0x75,0x59,0x79,0x59,0x79,0x59,0x79,0x59,0x79,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 36
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x49,0x3F,
+    0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x3F,0x3F,0x3F,0x3F,0x3F, // 37
+    0x2D,0x2D,0x2D,0x2D,0x2D,0x3F,0x3F,0x20,0x27,0x27,0x27,0x3F,0x22,0x22,0x22,0x3F,
+    0x3F,0x3F,0x2E,0x3F,0x2E,0x3F,0x2E,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20, // 38
+    0x3F,0x3F,0x27,0x22,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 39
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 40
+    0x3F,0x3F,0x2D,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F, // 41
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F
+};
+
+const t_codepage codepage_ascii CODEPAGE_STORAGE_FLAGS =
+{
+    .top = codepage_ascii_top,
+    .mid = codepage_ascii_mid,
+    .leaf = codepage_ascii_leaf,
+    .fallback = 0x3FU
+};
@@ -0,0 +1,151 @@
+/*
+ * codepage_hd44780_a02.c
+ *
+ *  Code points to character codes: HD44780 ROM code A02 (European standard font).
+ *  Generated by tools/codepagegen.py, 968 code points shown, fallback 0x3F,
+ *  1952 bytes of tables. Do not edit, generate it again instead.
+ */
+
+#include "codepage.h"
+
+static const uint8_t codepage_hd44780_a02_top[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x01,0x02,0x00,0x00,0x00,0x00,0x00,0x03,0x04,0x05,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x06
+};
+
+static const uint8_t codepage_hd44780_a02_mid[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 0
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x01,0x02,0x03,0x00,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E, // 1
+    0x0F,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x11,0x12,0x13,0x14,0x15,0x16,
+    0x17,0x18,0x19,0x00,0x00,0x00,0x1A,0x1B,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 2
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x1C,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 3
+    0x1D,0x1E,0x1F,0x20,0x21,0x22,0x23,0x24,0x00,0x00,0x00,0x00,0x00,0x25,0x00,0x00,
+    0x26,0x27,0x28,0x00,0x00,0x29,0x00,0x00,0x00,0x00,0x00,0x00,0x2A,0x2B,0x00,0x00, // 4
+    0x2C,0x2D,0x00,0x2E,0x00,0x00,0x00,0x00,0x2F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x30,0x31,0x00, // 5
+    0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 6
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x33,0x02,0x03,0x00,0x00,0x00,0x00,0x00
+};
+
+static const uint8_t codepage_hd44780_a02_leaf[] CODEPAGE_STORAGE_FLAGS =
+{
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 0
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F, // 1
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F, // 2
+    0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+    0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F, // 3
+    0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x3F,
+    0x20,0xA1,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0x20,0xA9,0xAA,0xAB,0x3F,0x3F,0xAE,0x20, // 4
+    0xB0,0xB1,0xB2,0xB3,0x27,0xB5,0xB6,0xB7,0x20,0xB9,0xBA,0xBB,0xBC,0xBD,0xBE,0xBF,
+    0xC0,0xC1,0xC2,0xC3,0xC4,0xC5,0xC6,0xC7,0xC8,0xC9,0xCA,0xCB,0xCC,0xCD,0xCE,0xCF, // 5
+    0xD0,0xD1,0xD2,0xD3,0xD4,0xD5,0xD6,0xD7,0xD8,0xD9,0xDA,0xDB,0xDC,0xDD,0xDE,0xDF,
+    0xE0,0xE1,0xE2,0xE3,0xE4,0xE5,0xE6,0xE7,0xE8,0xE9,0xEA,0xEB,0xEC,0xED,0xEE,0xEF, // 6
+    0xF0,0xF1,0xF2,0xF3,0xF4,0xF5,0xF6,0xF7,0xF8,0xF9,0xFA,0xFB,0xFC,0xFD,0xFE,0xFF,
+    0x41,0x61,0x41,0x61,0x41,0x61,0x43,0x63,0x43,0x63,0x43,0x63,0x43,0x63,0x44,0x64, // 7
+    0x44,0x64,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x47,0x67,0x47,0x67,
+    0x47,0x67,0x47,0x67,0x48,0x68,0x3F,0x3F,0x49,0x69,0x49,0x69,0x49,0x69,0x49,0x69, // 8
+    0x49,0x69,0x3F,0x3F,0x4A,0x6A,0x4B,0x6B,0x3F,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x3F,
+    0x3F,0x4C,0x6C,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x3F,0x3F,0x3F,0x4F,0x6F,0x4F,0x6F, // 9
+    0x4F,0x6F,0x4F,0x6F,0x52,0x72,0x52,0x72,0x52,0x72,0x53,0x73,0x53,0x73,0x53,0x73,
+    0x53,0x73,0x54,0x74,0x54,0x74,0x3F,0x3F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75, // 10
+    0x55,0x75,0x55,0x75,0x57,0x77,0x59,0x79,0x59,0x5A,0x7A,0x5A,0x7A,0x5A,0x7A,0x73,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 11
+    0x3F,0x3F,0xA8,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x4F,0x6F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x55, // 12
+    0x75,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x41,0x61,0x49, // 13
+    0x69,0x4F,0x6F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x3F,0x41,0x61,
+    0x41,0x61,0xC6,0xE6,0x3F,0x3F,0x47,0x67,0x4B,0x6B,0x4F,0x6F,0x4F,0x6F,0x3F,0x3F, // 14
+    0x6A,0x3F,0x3F,0x3F,0x47,0x67,0x3F,0x3F,0x4E,0x6E,0x41,0x61,0xC6,0xE6,0xD8,0xF8,
+    0x41,0x61,0x41,0x61,0x45,0x65,0x45,0x65,0x49,0x69,0x49,0x69,0x4F,0x6F,0x4F,0x6F, // 15
+    0x52,0x72,0x52,0x72,0x55,0x75,0x55,0x75,0x53,0x73,0x54,0x74,0x3F,0x3F,0x48,0x68,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x41,0x61,0x45,0x65,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F, // 16
+    0x4F,0x6F,0x59,0x79,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x49,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 17
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 18
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,0x3F,0x3F,0x3F,0x3B,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x20,0x20,0x41,0xB7,0x45,0x48,0x49,0x3F,0x4F,0x3F,0x59,0x9A, // 19
+    0x49,0x41,0x42,0x92,0x3F,0x45,0x5A,0x48,0x99,0x49,0x4B,0x3F,0x4D,0x4E,0x3F,0x4F,
+    0x3F,0x50,0x3F,0x94,0x54,0x59,0x3F,0x58,0x3F,0x9A,0x49,0x59,0x90,0x9E,0x48,0x49, // 20
+    0x59,0x90,0x42,0x92,0x9B,0x9E,0x5A,0x48,0x99,0x49,0x4B,0x3F,0x4D,0x4E,0x3F,0x4F,
+    0x93,0x50,0x94,0x95,0x97,0x59,0x3F,0x58,0x3F,0xB8,0x49,0x59,0x4F,0x59,0xB8,0x3F, // 21
+    0x42,0x99,0x59,0x59,0x59,0x3F,0x93,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 22
+    0x4B,0x50,0x94,0x3F,0x99,0x9E,0x3F,0x3F,0x3F,0x94,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x4B,0x84,0x88,0x3F, // 23
+    0x41,0x80,0x42,0x3F,0x81,0x45,0x82,0x83,0x84,0x85,0x4B,0x86,0x4D,0x48,0x4F,0x87,
+    0x50,0x43,0x54,0x88,0x3F,0x58,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x3F,0x8F,0xAC,0xAD, // 24
+    0x41,0x80,0x42,0x3F,0x81,0x45,0x82,0x83,0x84,0x84,0x4B,0x86,0x4D,0x48,0x4F,0x87,
+    0x50,0x43,0x54,0x88,0x3F,0x58,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x3F,0x8F,0xAC,0xAD, // 25
+    0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x4B,0x84,0x88,0x3F,
+    0x3F,0x82,0x82,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 26
+    0x41,0x41,0x41,0x41,0x3F,0x3F,0x45,0x45,0x3F,0x3F,0x3F,0x3F,0x82,0x82,0x83,0x83,
+    0x3F,0x3F,0x84,0x84,0x84,0x84,0x4F,0x4F,0x3F,0x3F,0x3F,0x3F,0x8F,0x8F,0x88,0x88, // 27
+    0x88,0x88,0x88,0x88,0x8A,0x8A,0x3F,0x3F,0x8E,0x8E,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x42,0x81,0x4F,0x43,0x54,0x54,0x8D,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 28
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x41,0x61,0x42,0x62,0x42,0x62,0x42,0x62,0x43,0x63,0x44,0x64,0x44,0x64,0x44,0x64, // 29
+    0x44,0x64,0x44,0x64,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x46,0x66,
+    0x47,0x67,0x48,0x68,0x48,0x68,0x48,0x68,0x48,0x68,0x48,0x68,0x49,0x69,0x49,0x69, // 30
+    0x4B,0x6B,0x4B,0x6B,0x4B,0x6B,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x4C,0x6C,0x4D,0x6D,
+    0x4D,0x6D,0x4D,0x6D,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x4E,0x6E,0x4F,0x6F,0x4F,0x6F, // 31
+    0x4F,0x6F,0x4F,0x6F,0x50,0x70,0x50,0x70,0x52,0x72,0x52,0x72,0x52,0x72,0x52,0x72,
+    0x53,0x73,0x53,0x73,0x53,0x73,0x53,0x73,0x53,0x73,0x54,0x74,0x54,0x74,0x54,0x74, // 32
+    0x54,0x74,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x56,0x76,0x56,0x76,
+    0x57,0x77,0x57,0x77,0x57,0x77,0x57,0x77,0x57,0x77,0x58,0x78,0x58,0x78,0x59,0x79, // 33
+    0x5A,0x7A,0x5A,0x7A,0x5A,0x7A,0x68,0x74,0x77,0x79,0x3F,0x73,0x3F,0x3F,0x3F,0x3F,
+    0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61, // 34
+    0x41,0x61,0x41,0x61,0x41,0x61,0x41,0x61,0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,
+    0x45,0x65,0x45,0x65,0x45,0x65,0x45,0x65,0x49,0x69,0x49,0x69,0x4F,0x6F,0x4F,0x6F, // 35
+    0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,0x4F,0x6F,
+    0x4F,0x6F,0x4F,0x6F,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75,0x55,0x75, // 36
+    0x55,0x75,0x59,0x79,0x59,0x79,0x59,0x79,0x59,0x79,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 37
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x49,0x3F,
+    0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x3F,0x3F,0x3F,0x3F,0x3F, // 38
+    0x2D,0x2D,0x2D,0x2D,0x2D,0x3F,0x3F,0x20,0xAF,0x27,0x27,0x3F,0x12,0x13,0x22,0x3F,
+    0x3F,0x3F,0x2E,0x3F,0x2E,0x3F,0x2E,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20, // 39
+    0x3F,0x3F,0x27,0x22,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 40
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x20,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0xB4,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 41
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 42
+    0x1B,0x18,0x1A,0x19,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 43
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x17,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 44
+    0x3F,0x3F,0x2D,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x9C,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x9F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 45
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x1C,0x1D,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 46
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x7F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 47
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F, // 48
+    0x3F,0x3F,0x1E,0x3F,0x3F,0x3F,0x10,0x3F,0x3F,0x3F,0x3F,0x3F,0x1F,0x3F,0x3F,0x3F,
+    0x11,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x16, // 49
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x9D,0x3F,0x3F,0x3F,0x3F,0x91,0x3F,0x96,0x3F,0x3F,0x3F, // 50
+    0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,0x3F,
+    0x3F,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F, // 51
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F
+};
+
+const t_codepage codepage_hd44780_a02 CODEPAGE_STORAGE_FLAGS =
+{
+    .top = codepage_hd44780_a02_top,
+    .mid = codepage_hd44780_a02_mid,
+    .leaf = codepage_hd44780_a02_leaf,
+    .fallback = 0x3FU
+};
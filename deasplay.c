@@ -31,202 +31,3402 @@
 #include <stdbool.h>
 
 #include <stdio.h>  /* printf-like facility */
+#ifdef DISPLAY_HAS_PRINTF
+#include <stdarg.h>
+#endif
+
+#include "deasplay.h"
+
+#if defined(DISPLAY_HAS_RING) && defined(__AVR)
+#include <util/atomic.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DEASPLAY_DIFF_VECTOR    (16U)
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DEASPLAY_DIFF_VECTOR    (16U)
+#endif
+
+#ifdef HAS_BITMAP
+#include "bitmap.h"
+#endif
+
+#ifdef __AVR
+/* constant tables stay in the flash memory */
+#include <avr/pgmspace.h>
+#define DEASPLAY_ROM                    PROGMEM
+#define DEASPLAY_ROM_BYTE(p)            pgm_read_byte(p)
+#else
+#define DEASPLAY_ROM
+#define DEASPLAY_ROM_BYTE(p)            (*(p))
+#endif
+
+/* The implementation of the APIs is shared by the default display and by
+ * the display contexts: the driver table is passed separately so that, for
+ * the default display, the compiler resolves it at build time and calls the
+ * driver directly. */
+#ifdef __GNUC__
+#define DEASPLAY_INLINE                 static inline __attribute__((always_inline))
+#else
+#define DEASPLAY_INLINE                 static inline
+#endif
+
+#define DEASPLAY_WORD_SIZE              (sizeof(deasplay_word_t))
+
+/* performance counters, compiled out unless requested */
+#ifdef DISPLAY_HAS_STATS
+#define DEASPLAY_STAT_ADD(ctx, counter, n)  ((ctx)->stats.counter += (uint32_t)(n))
+#else
+#define DEASPLAY_STAT_ADD(ctx, counter, n)
+#endif
+
+/* a configured index type must be able to address the whole buffer */
+typedef char deasplay_index_check[((deasplay_index_t)DEASPLAY_BUFFER_ELEMENTS == DEASPLAY_BUFFER_ELEMENTS) ? 1 : -1];
+
+/* Default display: driven through the deasplay_hal_* functions */
+static void display_default_init(void)
+{
+    deasplay_hal_init();
+}
+
+static void display_default_power(e_deasplay_power state)
+{
+    deasplay_hal_power(state);
+}
+
+static void display_default_set_cursor(deasplay_coord_t line, deasplay_coord_t chr)
+{
+    deasplay_hal_set_cursor(line, chr);
+}
+
+static void display_default_write_char(uint8_t chr)
+{
+    deasplay_hal_write_char(chr);
+}
+
+#ifdef deasplay_hal_write_run
+static void display_default_write_run(deasplay_coord_t line, deasplay_coord_t chr, uint8_t *data, deasplay_index_t len)
+{
+    deasplay_hal_write_run(line, chr, data, len);
+}
+#endif
+
+static void display_default_cursor_visibility(bool visible)
+{
+    deasplay_hal_cursor_visibility(visible);
+}
+
+static void display_default_set_extended(uint8_t id, uint8_t *data, uint8_t len)
+{
+    deasplay_hal_set_extended(id, data, len);
+}
+
+static void display_default_state_callback(e_deasplay_state state)
+{
+    (void)state;
+    deasplay_hal_state_callback(state);
+}
+
+#ifdef HAS_BITMAP
+static uint8_t* display_default_get_buffer(void)
+{
+    return bitmap_buffer;
+}
+
+static void display_default_write_buffer(deasplay_coord_t x_rect, deasplay_coord_t y_rect)
+{
+    display_hal_write_buffer(x_rect, y_rect);
+}
+
+#ifdef display_hal_write_span
+static void display_default_write_span(deasplay_coord_t page, deasplay_coord_t x, uint8_t *data, deasplay_coord_t len)
+{
+    display_hal_write_span(page, x, data, len);
+}
+#endif
+#endif
+
+#ifdef deasplay_hal_scroll
+static bool display_default_scroll(deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+    return deasplay_hal_scroll(line, chr, lines, chars, dx, dy);
+}
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+static void display_default_submit(uint8_t *queue, size_t len)
+{
+    deasplay_hal_submit(queue, len);
+}
+#endif
+
+static const t_deasplay_hal display_default_hal =
+{
+    .init = display_default_init,
+    .power = display_default_power,
+    .set_cursor = display_default_set_cursor,
+    .write_char = display_default_write_char,
+#ifdef deasplay_hal_write_run
+    .write_run = display_default_write_run,
+#else
+    .write_run = NULL,
+#endif
+    .cursor_visibility = display_default_cursor_visibility,
+    .set_extended = display_default_set_extended,
+    .state_callback = display_default_state_callback,
+#ifdef HAS_BITMAP
+    .get_buffer = display_default_get_buffer,
+    .write_buffer = display_default_write_buffer,
+#else
+    .get_buffer = NULL,
+    .write_buffer = NULL,
+#endif
+#if defined(HAS_BITMAP) && defined(display_hal_write_span)
+    .write_span = display_default_write_span,
+#else
+    .write_span = NULL,
+#endif
+#ifdef deasplay_hal_scroll
+    .scroll = display_default_scroll,
+#else
+    .scroll = NULL,
+#endif
+    .span_overhead = DISPLAY_HAL_SPAN_OVERHEAD,
+#ifdef DISPLAY_HAS_UTF8
+    .codepage = &DISPLAY_HAL_CODEPAGE,
+#endif
+#ifdef DISPLAY_HAS_ASYNC
+    .submit = display_default_submit,
+#endif
+};
+
+DEASPLAY_CONTEXT_BUFFERS(display_default, DEASPLAY_TEXT_LINES, DEASPLAY_TEXT_CHARS);
+static t_deasplay display_default = DEASPLAY_CONTEXT_INIT(display_default, &display_default_hal,
+                                                          DEASPLAY_TEXT_LINES, DEASPLAY_TEXT_CHARS,
+                                                          DEASPLAY_FONT_X, DEASPLAY_CHARS);
+
+/* Geometry of a display. The default display's is known at compile time:
+ * once an implementation is inlined into a single-display wrapper the
+ * comparison folds away and the loops run over constant bounds. */
+#define DISPLAY_CTX_GEOMETRY(ctx, member, value)    (((ctx) == &display_default) ? (value) : (ctx)->member)
+#define DISPLAY_CTX_LINES(ctx)          DISPLAY_CTX_GEOMETRY(ctx, lines, (deasplay_coord_t)DEASPLAY_TEXT_LINES)
+#define DISPLAY_CTX_CHARS(ctx)          DISPLAY_CTX_GEOMETRY(ctx, chars, (deasplay_coord_t)DEASPLAY_TEXT_CHARS)
+#define DISPLAY_CTX_FONT_X(ctx)         DISPLAY_CTX_GEOMETRY(ctx, font_x, (deasplay_coord_t)DEASPLAY_FONT_X)
+#define DISPLAY_CTX_WIDTH(ctx)          DISPLAY_CTX_GEOMETRY(ctx, width, (deasplay_coord_t)DEASPLAY_CHARS)
+#define DISPLAY_CTX_ELEMENTS(ctx)       DISPLAY_CTX_GEOMETRY(ctx, elements, (deasplay_index_t)DEASPLAY_BUFFER_ELEMENTS)
+
+/* Driver of the default display: its table, unless a trace has put the
+ * recording driver in between */
+#ifdef DISPLAY_HAS_TRACE
+#define DISPLAY_DEFAULT_HAL             (display_default.hal)
+#else
+#define DISPLAY_DEFAULT_HAL             (&display_default_hal)
+#endif
+
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+static deasplay_word_t display_default_bitmap_shadow[DEASPLAY_WORDS((DEASPLAY_LINES / 8U) * DEASPLAY_CHARS)];
+#endif
+
+#ifdef DISPLAY_HAS_PRINTF
+static char snprintf_buf[DEASPLAY_BUFFER_ELEMENTS];
+#endif
+
+t_deasplay_timestamp hw_timestamp;
+
+/* what a refresh is still allowed to do */
+typedef struct
+{
+    size_t cells;       /* cells that can still be compared */
+    size_t bytes;       /* bytes that can still be sent */
+    uint32_t deadline;  /* hw_timestamp() value to stop at */
+    bool timed;         /* the deadline applies */
+    bool spent;         /* the budget ran out */
+} t_display_work;
+
+#ifdef DISPLAY_HAS_FIELDS
+static void display_fields_update(t_deasplay *ctx);
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+static void display_cgram_reset(t_deasplay *ctx);
+static bool display_cgram_upload(t_deasplay *ctx, const t_deasplay_hal *hal, t_display_work *work);
+#endif
+
+t_deasplay* display_get_context(void)
+{
+    return &display_default;
+}
+
+#ifdef DISPLAY_HAS_TRACE
+/* the display being traced and the recording driver standing in for its own */
+static t_deasplay *display_trace_ctx;
+static t_deasplay_hal display_trace_hal;
+
+static uint8_t display_trace_u16(uint8_t *record, uint8_t pos, uint32_t value)
+{
+    record[pos] = (uint8_t)value;
+    record[pos + 1U] = (uint8_t)(value >> 8);
+    return (uint8_t)(pos + 2U);
+}
+
+static uint8_t display_trace_u32(uint8_t *record, uint8_t pos, uint32_t value)
+{
+    pos = display_trace_u16(record, pos, value);
+    return display_trace_u16(record, pos, value >> 16);
+}
+
+/**
+ * Append bytes to a trace.
+ * @param trace     the trace
+ * @param data      the bytes
+ * @param len       number of bytes
+ * @param reserve   bytes that must still fit in a RAM log (the rest of the record)
+ */
+static void display_trace_put(t_display_trace *trace, const uint8_t *data, size_t len, size_t reserve)
+{
+    if (trace->write != NULL)
+    {
+        if (len != 0U) trace->write(data, len, trace->arg);
+        return;
+    }
+    if (trace->full) return;
+    if ((trace->size - trace->len) < (len + reserve))
+    {
+        /* dropped: the log starts over with the next refresh */
+        trace->full = true;
+        return;
+    }
+    memcpy(&trace->data[trace->len], data, len);
+    trace->len += len;
+}
+
+/**
+ * Append a record to a trace.
+ * @param trace     the trace
+ * @param record    event and arguments
+ * @param len       size of event and arguments
+ * @param data      data of the record (NULL: none)
+ * @param dlen      size of the data
+ */
+static void display_trace_record(t_display_trace *trace, const uint8_t *record, uint8_t len, const uint8_t *data, size_t dlen)
+{
+    display_trace_put(trace, record, len, dlen);
+    if ((dlen != 0U) && (trace->full == false)) display_trace_put(trace, data, dlen, 0U);
+}
+
+/**
+ * Append a record made of 16-bit arguments to a trace.
+ * @param trace     the trace
+ * @param event     the record
+ * @param args      its arguments
+ * @param count     number of arguments, up to 8
+ * @param data      its data (NULL: none)
+ * @param len       size of the data
+ */
+static void display_trace_args(t_display_trace *trace, e_display_trace_event event, const uint32_t *args, uint8_t count, const uint8_t *data, size_t len)
+{
+    uint8_t record[17];
+    uint8_t pos = 1U;
+    uint8_t i;
+
+    record[0] = (uint8_t)event;
+    for (i = 0; i < count; i++)
+    {
+        pos = display_trace_u16(record, pos, args[i]);
+    }
+    display_trace_record(trace, record, pos, data, len);
+}
+
+/**
+ * Record the geometry and the whole state of a display, from which a replay can start.
+ */
+static void display_trace_keyframe(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+    t_display_trace *trace = ctx->trace;
+    uint8_t record[16];
+    uint8_t pos;
+    size_t size;
+    uint8_t flags;
+    uint32_t cursor[2];
+    bool bitmap = false;
+    bool bitmap_shadow = false;
+#ifdef HAS_BITMAP
+    deasplay_coord_t page;
+    uint8_t span[4];
+#endif
+
+#ifdef HAS_BITMAP
+    bitmap = (hal->get_buffer != NULL);
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+    bitmap_shadow = bitmap && (ctx->bitmap_shadow != NULL);
+#endif
+#else
+    (void)hal;
+#endif
+
+    record[0] = (uint8_t)DISPLAY_TRACE_HEADER;
+    record[1] = (uint8_t)DISPLAY_TRACE_VERSION;
+    pos = display_trace_u16(record, 2U, DISPLAY_CTX_LINES(ctx));
+    pos = display_trace_u16(record, pos, DISPLAY_CTX_CHARS(ctx));
+    pos = display_trace_u16(record, pos, DISPLAY_CTX_WIDTH(ctx));
+    pos = display_trace_u16(record, pos, DISPLAY_CTX_FONT_X(ctx));
+    record[pos++] = bitmap ? 1U : 0U;
+    record[pos++] = bitmap_shadow ? 1U : 0U;
+
+    /* the key frame goes in as a whole or not at all */
+    size = (size_t)pos + 14U + DEASPLAY_LINE_BYTES(DISPLAY_CTX_LINES(ctx)) + (2U * (size_t)DISPLAY_CTX_ELEMENTS(ctx));
+    if (bitmap) size += ((size_t)DISPLAY_CTX_LINES(ctx) * 4U) + ((size_t)DISPLAY_CTX_LINES(ctx) * DISPLAY_CTX_WIDTH(ctx));
+    if (bitmap_shadow) size += (size_t)DISPLAY_CTX_LINES(ctx) * DISPLAY_CTX_WIDTH(ctx);
+    display_trace_put(trace, record, pos, size - pos);
+    if (trace->full) return;
+
+    flags = (uint8_t)((ctx->status.frame ? 1U : 0U) | (ctx->status.in_line ? 2U : 0U) |
+                      (ctx->status.hw_valid ? 4U : 0U) | ((ctx->status.generation != ctx->status.refreshed) ? 8U : 0U));
+    record[0] = (uint8_t)DISPLAY_TRACE_KEYFRAME;
+    record[1] = flags;
+    pos = display_trace_u32(record, 2U, ctx->status.resume_line);
+    pos = display_trace_u32(record, pos, ctx->status.resume_index);
+    pos = display_trace_u32(record, pos, ctx->status.hw_index);
+    display_trace_put(trace, record, pos, 0U);
+    display_trace_put(trace, ctx->dirty, DEASPLAY_LINE_BYTES(DISPLAY_CTX_LINES(ctx)), 0U);
+    display_trace_put(trace, ctx->buffer, DISPLAY_CTX_ELEMENTS(ctx), 0U);
+    display_trace_put(trace, ctx->shadow, DISPLAY_CTX_ELEMENTS(ctx), 0U);
+#ifdef HAS_BITMAP
+    if (bitmap)
+    {
+        for (page = 0; page < DISPLAY_CTX_LINES(ctx); page++)
+        {
+            (void)display_trace_u16(span, 0U, ctx->spans[2U * page]);
+            (void)display_trace_u16(span, 2U, ctx->spans[(2U * page) + 1U]);
+            display_trace_put(trace, span, sizeof(span), 0U);
+        }
+        display_trace_put(trace, hal->get_buffer(), (size_t)DISPLAY_CTX_LINES(ctx) * DISPLAY_CTX_WIDTH(ctx), 0U);
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+        if (bitmap_shadow) display_trace_put(trace, ctx->bitmap_shadow, (size_t)DISPLAY_CTX_LINES(ctx) * DISPLAY_CTX_WIDTH(ctx), 0U);
+#endif
+    }
+#endif
+    if (trace->api)
+    {
+        /* where the next recorded write goes */
+        cursor[0] = ctx->status.line;
+        cursor[1] = ctx->status.index - (ctx->status.line * DISPLAY_CTX_CHARS(ctx));
+        display_trace_args(trace, DISPLAY_TRACE_API_CURSOR, cursor, 2U, NULL, 0U);
+    }
+}
+
+/**
+ * Record the start of a refresh or flush call; a full RAM log starts over here.
+ * @param ctx       the display
+ * @param event     DISPLAY_TRACE_STEP or DISPLAY_TRACE_FLUSH
+ * @param budget    budget of a display_periodic_step() call (NULL: none)
+ */
+static void display_trace_begin(t_deasplay *ctx, e_display_trace_event event, const t_display_budget *budget)
+{
+    t_display_trace *trace = ctx->trace;
+    uint8_t record[6];
+    uint8_t pos;
+
+    if ((trace->write == NULL) && trace->full)
+    {
+        trace->len = 0U;
+        trace->full = false;
+        trace->restarts++;
+        display_trace_keyframe(ctx, trace->hal);
+    }
+    record[0] = (uint8_t)event;
+    pos = 1U;
+    if (event == DISPLAY_TRACE_STEP)
+    {
+        record[pos++] = (budget != NULL) ? 1U : 0U;
+        pos = display_trace_u16(record, pos, (budget != NULL) ? budget->cells : 0U);
+        pos = display_trace_u16(record, pos, (budget != NULL) ? budget->bytes : 0U);
+    }
+    display_trace_record(trace, record, pos, NULL, 0U);
+}
+
+/**
+ * Record the lines, and the bitmap spans, a refresh pass is about to look at.
+ */
+static void display_trace_dirty(t_deasplay *ctx)
+{
+    t_display_trace *trace = ctx->trace;
+    uint8_t record[2];
+    size_t size = DEASPLAY_LINE_BYTES(DISPLAY_CTX_LINES(ctx));
+#ifdef HAS_BITMAP
+    deasplay_coord_t page;
+    uint8_t span[4];
+#endif
+
+    record[0] = (uint8_t)DISPLAY_TRACE_DIRTY;
+    record[1] = (ctx->status.generation != ctx->status.refreshed) ? 1U : 0U;
+#ifdef HAS_BITMAP
+    if (trace->hal->get_buffer != NULL) size += (size_t)DISPLAY_CTX_LINES(ctx) * 4U;
+#endif
+    display_trace_put(trace, record, sizeof(record), size);
+    if (trace->full) return;
+    display_trace_put(trace, ctx->dirty, DEASPLAY_LINE_BYTES(DISPLAY_CTX_LINES(ctx)), 0U);
+#ifdef HAS_BITMAP
+    if (trace->hal->get_buffer == NULL) return;
+    for (page = 0; page < DISPLAY_CTX_LINES(ctx); page++)
+    {
+        (void)display_trace_u16(span, 0U, ctx->spans[2U * page]);
+        (void)display_trace_u16(span, 2U, ctx->spans[(2U * page) + 1U]);
+        display_trace_put(trace, span, sizeof(span), 0U);
+    }
+#endif
+}
+
+/**
+ * Record an event without arguments (end of a call, display_clear()).
+ */
+static void display_trace_event(t_deasplay *ctx, e_display_trace_event event)
+{
+    uint8_t record = (uint8_t)event;
+
+    display_trace_record(ctx->trace, &record, 1U, NULL, 0U);
+}
+
+/**
+ * Record a line, from a character on, as the refresh is about to read it.
+ */
+static void display_trace_line(t_deasplay *ctx, deasplay_index_t line, deasplay_index_t index)
+{
+    uint8_t record[7];
+    uint8_t pos;
+    deasplay_index_t len = ((line + 1U) * DISPLAY_CTX_CHARS(ctx)) - index;
+
+    record[0] = (uint8_t)DISPLAY_TRACE_LINE;
+    pos = display_trace_u16(record, 1U, line);
+    pos = display_trace_u16(record, pos, index - (line * DISPLAY_CTX_CHARS(ctx)));
+    pos = display_trace_u16(record, pos, len);
+    display_trace_record(ctx->trace, record, pos, &ctx->buffer[index], len);
+}
+
+/**
+ * Record a driver call.
+ * @param event     the call
+ * @param args      its arguments
+ * @param count     number of arguments
+ * @param data      its data (NULL: none)
+ * @param len       size of the data
+ */
+static void display_trace_driver(e_display_trace_event event, const uint32_t *args, uint8_t count, const uint8_t *data, size_t len)
+{
+    display_trace_args(display_trace_ctx->trace, event, args, count, data, len);
+}
+
+/**
+ * Record a call writing the buffer, if the trace takes them.
+ * @param ctx       the display
+ * @param event     the call
+ * @param args      its arguments
+ * @param count     number of arguments
+ * @param data      its data (NULL: none)
+ * @param len       size of the data
+ */
+static void display_trace_api(t_deasplay *ctx, e_display_trace_event event, const uint32_t *args, uint8_t count, const uint8_t *data, size_t len)
+{
+    if (ctx->trace->api) display_trace_args(ctx->trace, event, args, count, data, len);
+}
+
+/**
+ * Record a number write, if the trace takes the calls writing the buffer.
+ */
+static void display_trace_number(t_deasplay *ctx, uint32_t mag, bool negative, bool hex, const t_display_format *fmt)
+{
+    static const t_display_format plain = { 0U, 0U, '\0', DISPLAY_ALIGN_RIGHT };
+    uint8_t record[14];
+    uint8_t pos;
+
+    if (ctx->trace->api == false) return;
+    if (fmt == NULL) fmt = &plain;
+    record[0] = (uint8_t)DISPLAY_TRACE_API_NUMBER;
+    pos = display_trace_u32(record, 1U, mag);
+    record[pos++] = (uint8_t)((negative ? 1U : 0U) | (hex ? 2U : 0U));
+    pos = display_trace_u16(record, pos, fmt->width);
+    pos = display_trace_u16(record, pos, fmt->decimals);
+    pos = display_trace_u16(record, pos, (uint8_t)fmt->pad);
+    pos = display_trace_u16(record, pos, (uint32_t)fmt->align);
+    display_trace_record(ctx->trace, record, pos, NULL, 0U);
+}
+
+static void display_trace_init(void)
+{
+    display_trace_driver(DISPLAY_TRACE_HAL_INIT, NULL, 0U, NULL, 0U);
+    display_trace_ctx->trace->hal->init();
+}
+
+static void display_trace_power(e_deasplay_power state)
+{
+    uint32_t args[1] = { (uint32_t)state };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_POWER, args, 1U, NULL, 0U);
+    display_trace_ctx->trace->hal->power(state);
+}
+
+static void display_trace_set_cursor(deasplay_coord_t line, deasplay_coord_t chr)
+{
+    uint32_t args[2] = { line, chr };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_CURSOR, args, 2U, NULL, 0U);
+    display_trace_ctx->trace->hal->set_cursor(line, chr);
+}
+
+static void display_trace_write_char(uint8_t chr)
+{
+    uint32_t args[1] = { chr };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_CHAR, args, 1U, NULL, 0U);
+    display_trace_ctx->trace->hal->write_char(chr);
+}
+
+static void display_trace_write_run(deasplay_coord_t line, deasplay_coord_t chr, uint8_t *data, deasplay_index_t len)
+{
+    uint32_t args[3] = { line, chr, len };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_RUN, args, 3U, data, len);
+    display_trace_ctx->trace->hal->write_run(line, chr, data, len);
+}
+
+static void display_trace_cursor_visibility(bool visible)
+{
+    uint32_t args[1] = { visible ? 1U : 0U };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_VISIBILITY, args, 1U, NULL, 0U);
+    display_trace_ctx->trace->hal->cursor_visibility(visible);
+}
+
+static void display_trace_set_extended(uint8_t id, uint8_t *data, uint8_t len)
+{
+    uint32_t args[2] = { id, len };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_EXTENDED, args, 2U, data, len);
+    display_trace_ctx->trace->hal->set_extended(id, data, len);
+}
+
+static void display_trace_state_callback(e_deasplay_state state)
+{
+    uint32_t args[1] = { (uint32_t)state };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_STATE, args, 1U, NULL, 0U);
+    display_trace_ctx->trace->hal->state_callback(state);
+}
+
+static void display_trace_write_buffer(deasplay_coord_t x_rect, deasplay_coord_t y_rect)
+{
+    const t_deasplay_hal *hal = display_trace_ctx->trace->hal;
+    size_t len = (hal->get_buffer != NULL) ? ((size_t)display_trace_ctx->lines * display_trace_ctx->width) : 0U;
+    uint32_t args[4] = { x_rect, y_rect, (uint32_t)len, (uint32_t)len >> 16 };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_BUFFER, args, 4U, (len != 0U) ? hal->get_buffer() : NULL, len);
+    hal->write_buffer(x_rect, y_rect);
+}
+
+static void display_trace_write_span(deasplay_coord_t page, deasplay_coord_t x, uint8_t *data, deasplay_coord_t len)
+{
+    uint32_t args[3] = { page, x, len };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_SPAN, args, 3U, data, len);
+    display_trace_ctx->trace->hal->write_span(page, x, data, len);
+}
+
+static bool display_trace_scroll(deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+    bool done = display_trace_ctx->trace->hal->scroll(line, chr, lines, chars, dx, dy);
+    uint32_t args[7] = { line, chr, lines, chars, (uint8_t)dx, (uint8_t)dy, done ? 1U : 0U };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_SCROLL, args, 7U, NULL, 0U);
+    return done;
+}
+
+#ifdef DISPLAY_HAS_ASYNC
+static void display_trace_submit(uint8_t *queue, size_t len)
+{
+    uint32_t args[2] = { (uint32_t)len, (uint32_t)len >> 16 };
+
+    display_trace_driver(DISPLAY_TRACE_HAL_SUBMIT, args, 2U, queue, len);
+    display_trace_ctx->trace->hal->submit(queue, len);
+}
+#endif
+
+void display_trace_start_ctx(t_deasplay *ctx, t_display_trace *trace)
+{
+    const t_deasplay_hal *hal = ctx->hal;
+
+    if (display_trace_ctx != NULL) display_trace_stop_ctx(display_trace_ctx);
+
+    /* the recording driver forwards every call to the display's own */
+    display_trace_hal = *hal;
+    display_trace_hal.init = display_trace_init;
+    display_trace_hal.power = display_trace_power;
+    display_trace_hal.set_cursor = display_trace_set_cursor;
+    display_trace_hal.write_char = display_trace_write_char;
+    if (hal->write_run != NULL) display_trace_hal.write_run = display_trace_write_run;
+    display_trace_hal.cursor_visibility = display_trace_cursor_visibility;
+    display_trace_hal.set_extended = display_trace_set_extended;
+    if (hal->state_callback != NULL) display_trace_hal.state_callback = display_trace_state_callback;
+    if (hal->write_buffer != NULL) display_trace_hal.write_buffer = display_trace_write_buffer;
+    if (hal->write_span != NULL) display_trace_hal.write_span = display_trace_write_span;
+    if (hal->scroll != NULL) display_trace_hal.scroll = display_trace_scroll;
+#ifdef DISPLAY_HAS_ASYNC
+    if (hal->submit != NULL) display_trace_hal.submit = display_trace_submit;
+#endif
+
+    trace->hal = hal;
+    trace->len = 0U;
+    trace->restarts = 0U;
+    trace->full = false;
+    ctx->trace = trace;
+    ctx->hal = &display_trace_hal;
+    display_trace_ctx = ctx;
+    display_trace_keyframe(ctx, hal);
+}
+
+void display_trace_start(t_display_trace *trace)
+{
+    display_trace_start_ctx(&display_default, trace);
+}
+
+void display_trace_stop_ctx(t_deasplay *ctx)
+{
+    if (ctx->trace == NULL) return;
+    ctx->hal = ctx->trace->hal;
+    ctx->trace = NULL;
+    display_trace_ctx = NULL;
+}
+
+void display_trace_stop(void)
+{
+    display_trace_stop_ctx(&display_default);
+}
+#endif
+
+#ifdef DISPLAY_HAS_RING
+/* The turn numbers and the head are shared with the producers. An int is
+ * loaded and stored in two halves on AVR, which has no compare and swap
+ * either: there they are accessed with the interrupts off. */
+
+/**
+ * Read a turn number or the head.
+ * @param p     the value
+ * @return the value, the data it publishes being visible
+ */
+static unsigned int display_ring_load(unsigned int *p)
+{
+#ifdef __AVR
+    unsigned int v = 0U;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        v = *(volatile unsigned int*)p;
+    }
+    return v;
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Write a turn number or the head.
+ * @param p     the value
+ * @param v     the new value, publishing what has been written before
+ */
+static void display_ring_store(unsigned int *p, unsigned int v)
+{
+#ifdef __AVR
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        *(volatile unsigned int*)p = v;
+    }
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Move the head past consecutive slots, unless another producer did it first.
+ * @param ctx   the display
+ * @param pos   the first slot; updated with the current head on failure
+ * @param count number of slots
+ * @return true if the slots are claimed
+ */
+static bool display_ring_claim(t_deasplay *ctx, unsigned int *pos, unsigned int count)
+{
+#ifdef __AVR
+    bool claimed = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (ctx->ring.head == *pos)
+        {
+            ctx->ring.head = *pos + count;
+            claimed = true;
+        }
+        else
+        {
+            *pos = ctx->ring.head;
+        }
+    }
+    return claimed;
+#else
+    return __atomic_compare_exchange_n(&ctx->ring.head, pos, *pos + count, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * Empty the ring. Not to be called while writes are being queued: the
+ * turns start over, a producer in the middle of a write would publish
+ * into a slot that no longer expects it.
+ * @param ctx   the display
+ */
+static void display_ring_reset(t_deasplay *ctx)
+{
+    unsigned int i;
+
+    for (i = 0; i < DEASPLAY_RING_SIZE; i++)
+    {
+        display_ring_store(&ctx->ring.slot[i].seq, i);
+    }
+    ctx->ring.tail = 0U;
+    display_ring_store(&ctx->ring.head, 0U);
+}
+#endif
+
+DEASPLAY_INLINE void display_init_impl(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+    hal->init();
+    ctx->status.hw_valid = false;
+    ctx->status.frame = false;
+#ifdef DISPLAY_HAS_RING
+    display_ring_reset(ctx);
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+    /* the controller has just forgotten its custom characters */
+    display_cgram_reset(ctx);
+#endif
+    display_set_cursor_ctx(ctx, 0, 0);
+    hal->state_callback(DEASPLAY_STATE_INIT);
+}
+
+void display_init_ctx(t_deasplay *ctx)
+{
+    display_init_impl(ctx, ctx->hal);
+}
+
+void display_init(void)
+{
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+    display_default.bitmap_shadow = (uint8_t*)display_default_bitmap_shadow;
+#endif
+    display_init_impl(&display_default, DISPLAY_DEFAULT_HAL);
+}
+
+void display_power_ctx(t_deasplay *ctx, e_deasplay_power state)
+{
+    ctx->hal->power(state);
+}
+
+void display_power(e_deasplay_power state)
+{
+    DISPLAY_DEFAULT_HAL->power(state);
+}
+
+/**
+ * Wake up the next refresh. The generation counter moves only away from
+ * the generation last refreshed, so it cannot come back to it however
+ * many changes happen between two refreshes.
+ * @param ctx   the display
+ */
+static void display_touch(t_deasplay *ctx)
+{
+    if (ctx->status.generation == ctx->status.refreshed) ctx->status.generation++;
+}
+
+/**
+ * Flag a line as changed since the last refresh.
+ * @param ctx   the display
+ * @param line  the line to be flagged
+ */
+static void display_mark_line(t_deasplay *ctx, deasplay_index_t line)
+{
+    uint8_t mask = (uint8_t)(1U << (line & 7U));
+
+    if ((ctx->dirty[line >> 3] & mask) == 0U)
+    {
+        ctx->dirty[line >> 3] |= mask;
+        display_touch(ctx);
+    }
+}
+
+/**
+ * Flag all lines as changed since the last refresh.
+ * @param ctx   the display
+ */
+static void display_mark_all(t_deasplay *ctx)
+{
+    memset(ctx->dirty, 0xFF, DEASPLAY_LINE_BYTES(DISPLAY_CTX_LINES(ctx)));
+    display_touch(ctx);
+}
+
+#ifdef DISPLAY_HAS_FIELDS
+void display_fields_invalidate_ctx(t_deasplay *ctx)
+{
+    t_display_field *field;
+
+    for (field = ctx->fields; field != NULL; field = field->next)
+    {
+        field->valid = false;
+    }
+}
+
+void display_fields_invalidate(void)
+{
+    display_fields_invalidate_ctx(&display_default);
+}
+#endif
+
+DEASPLAY_INLINE void display_clear_impl(t_deasplay *ctx)
+{
+    memset(ctx->buffer, (int)' ', DISPLAY_CTX_ELEMENTS(ctx));     /* space in the current buffer */
+    memset(ctx->shadow, (int)'\0', DISPLAY_CTX_ELEMENTS(ctx));    /* zero the previous buffer to force a complete redraw */
+    display_mark_all(ctx);
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_event(ctx, DISPLAY_TRACE_CLEAR);
+#endif
+#ifdef DISPLAY_HAS_FIELDS
+    /* the fields have been wiped out */
+    display_fields_invalidate_ctx(ctx);
+#endif
+}
+
+void display_clear_ctx(t_deasplay *ctx)
+{
+    display_clear_impl(ctx);
+}
+
+void display_clear(void)
+{
+    display_clear_impl(&display_default);
+}
+
+DEASPLAY_INLINE void display_clean_impl(t_deasplay *ctx)
+{
+    memset(ctx->buffer, (int)' ', DISPLAY_CTX_ELEMENTS(ctx));     /* space in the current buffer */
+    display_mark_all(ctx);
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_event(ctx, DISPLAY_TRACE_CLEAN);
+#endif
+#ifdef DISPLAY_HAS_FIELDS
+    display_fields_invalidate_ctx(ctx);
+#endif
+}
+
+void display_clean_ctx(t_deasplay *ctx)
+{
+    display_clean_impl(ctx);
+}
+
+void display_clean(void)
+{
+    display_clean_impl(&display_default);
+}
+
+#ifdef DISPLAY_HAS_RING
+/* The ring is a bounded queue where every slot carries a turn number
+ * (seq): producers claim the slots of a write by moving the head with a
+ * compare and swap, fill them and hand them over by publishing their
+ * turns; the refresh takes the slots in order and gives them back one
+ * round later.
+ * Producers never wait on each other nor on the refresh. */
+
+/**
+ * Queue one positioned write, in as many slots as it takes. The slots are
+ * claimed at once and handed over the last one first: the refresh, which
+ * stops at the first slot not handed over, takes the whole write or none
+ * of it.
+ * @param ctx   the display
+ * @param line  line of the first character
+ * @param chr   column of the first character
+ * @param data  the characters
+ * @param len   number of characters
+ * @return false if the ring has not enough free slots: nothing is queued
+ */
+static bool display_ring_put(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, const uint8_t *data, deasplay_index_t len)
+{
+    t_deasplay_ring_slot *slot;
+    unsigned int count = ((unsigned int)len + DEASPLAY_RING_DATA - 1U) / DEASPLAY_RING_DATA;
+    unsigned int pos = display_ring_load(&ctx->ring.head);
+    unsigned int last;
+    unsigned int seq;
+    unsigned int i;
+    deasplay_index_t offset;
+
+    if (count == 0U) return true;
+    if (count > DEASPLAY_RING_SIZE) return false;
+
+    for (;;)
+    {
+        /* the slots come back in turn order: with the last one free for
+         * this turn, so are the others */
+        last = pos + count - 1U;
+        seq = display_ring_load(&ctx->ring.slot[last & (DEASPLAY_RING_SIZE - 1U)].seq);
+        if (seq == last)
+        {
+            /* try to claim them */
+            if (display_ring_claim(ctx, &pos, count)) break;
+        }
+        else if ((int)(seq - last) < 0)
+        {
+            /* still holding a write of the previous round */
+            return false;
+        }
+        else
+        {
+            /* another producer took them */
+            pos = display_ring_load(&ctx->ring.head);
+        }
+    }
+
+    for (i = count; i > 0U; i--)
+    {
+        slot = &ctx->ring.slot[(pos + i - 1U) & (DEASPLAY_RING_SIZE - 1U)];
+        offset = (deasplay_index_t)((i - 1U) * DEASPLAY_RING_DATA);
+        slot->line = line;
+        slot->chr = (deasplay_coord_t)(chr + offset);
+        slot->len = ((size_t)(len - offset) > DEASPLAY_RING_DATA) ? (uint8_t)DEASPLAY_RING_DATA : (uint8_t)(len - offset);
+        memcpy(slot->data, &data[offset], slot->len);
+        display_ring_store(&slot->seq, pos + i);
+    }
+
+    return true;
+}
+
+/**
+ * Check for writes waiting in the ring.
+ * @param ctx   the display
+ * @return true if the next slot has been filled
+ */
+static bool display_ring_pending(t_deasplay *ctx)
+{
+    unsigned int pos = ctx->ring.tail;
+
+    return (display_ring_load(&ctx->ring.slot[pos & (DEASPLAY_RING_SIZE - 1U)].seq) == (pos + 1U));
+}
+
+/**
+ * Apply the queued writes to the buffer. Only the refresh calls it.
+ * @param ctx   the display
+ */
+static void display_ring_drain(t_deasplay *ctx)
+{
+    t_deasplay_ring_slot *slot;
+    deasplay_index_t index;
+    uint8_t i;
+
+    while (display_ring_pending(ctx))
+    {
+        slot = &ctx->ring.slot[ctx->ring.tail & (DEASPLAY_RING_SIZE - 1U)];
+        if ((slot->line < DISPLAY_CTX_LINES(ctx)) && (slot->chr < DISPLAY_CTX_CHARS(ctx)))
+        {
+            index = ((deasplay_index_t)slot->line * DISPLAY_CTX_CHARS(ctx)) + slot->chr;
+            /* the write stops at the end of its line */
+            for (i = 0; (i < slot->len) && ((slot->chr + i) < DISPLAY_CTX_CHARS(ctx)); i++)
+            {
+                if (ctx->buffer[index + i] != slot->data[i])
+                {
+                    ctx->buffer[index + i] = slot->data[i];
+                    display_mark_line(ctx, slot->line);
+                }
+            }
+        }
+
+        /* give the slot back for the next round */
+        display_ring_store(&slot->seq, ctx->ring.tail + DEASPLAY_RING_SIZE);
+        ctx->ring.tail++;
+    }
+}
+#endif
+
+bool display_is_dirty_ctx(t_deasplay *ctx)
+{
+#ifdef DISPLAY_HAS_RING
+    if (display_ring_pending(ctx)) return true;
+#endif
+#ifdef DISPLAY_HAS_ASYNC
+    /* operations waiting in a queue are not on the display yet */
+    if (ctx->async.used != 0U) return true;
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+    if (ctx->cgram.pending != 0U) return true;
+#endif
+    return (ctx->status.generation != ctx->status.refreshed) || ctx->status.frame;
+}
+
+bool display_is_dirty(void)
+{
+    return display_is_dirty_ctx(&display_default);
+}
+
+/**
+ * Find the first byte, in the given range, that differs between two buffers.
+ * Bytes are compared a word (or a vector) at a time; byte comparison
+ * is done only inside words that differ and in the tail of the range.
+ * @param a     first buffer
+ * @param b     second buffer
+ * @param from  first byte to be checked
+ * @param to    end of the range (excluded)
+ * @return the index of the first differing byte or 'to' if none differs
+ */
+static size_t display_diff(const uint8_t *a, const uint8_t *b, size_t from, size_t to)
+{
+    size_t i = from;
+    deasplay_word_t wa;
+    deasplay_word_t wb;
+
+#ifdef DEASPLAY_DIFF_VECTOR
+    while ((to - i) >= DEASPLAY_DIFF_VECTOR)
+    {
+#if defined(__SSE2__)
+        __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+        __m128i vb = _mm_loadu_si128((const __m128i*)&b[i]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) break;
+#else
+        uint8x16_t eq = vceqq_u8(vld1q_u8(&a[i]), vld1q_u8(&b[i]));
+        if (vminvq_u8(eq) != 0xFFU) break;
+#endif
+        i += DEASPLAY_DIFF_VECTOR;
+    }
+#endif
+
+    /* memcpy() turns into plain loads, and keeps unaligned buffers safe */
+    while ((to - i) >= DEASPLAY_WORD_SIZE)
+    {
+        memcpy(&wa, &a[i], DEASPLAY_WORD_SIZE);
+        memcpy(&wb, &b[i], DEASPLAY_WORD_SIZE);
+        if (wa != wb) break;
+        i += DEASPLAY_WORD_SIZE;
+    }
+
+    /* per-byte inside the differing word and in the tail */
+    while ((i < to) && (a[i] == b[i]))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * Find the first cell, in the given range, that changed since the last refresh.
+ * @param ctx   the display
+ * @param from  first cell to be checked
+ * @param to    end of the range (excluded)
+ * @return the index of the changed cell or 'to' if none changed
+ */
+static deasplay_index_t display_diff_next(t_deasplay *ctx, deasplay_index_t from, deasplay_index_t to)
+{
+    return (deasplay_index_t)display_diff(ctx->buffer, ctx->shadow, from, to);
+}
+
+/**
+ * Check, after something has been sent, whether the budget of a refresh ran out.
+ * The deadline is only checked here so that every call makes some progress.
+ * @param work  what the refresh is still allowed to do
+ * @return true if the refresh has to stop
+ */
+static bool display_work_check(t_display_work *work)
+{
+    if ((work->cells == 0U) || (work->bytes == 0U) ||
+        (work->timed && ((int32_t)(hw_timestamp() - work->deadline) >= 0)))
+    {
+        work->spent = true;
+    }
+
+    return work->spent;
+}
+
+/**
+ * Take bytes from the budget of a refresh.
+ * @param work  what the refresh is still allowed to do
+ * @param n     number of bytes
+ */
+static void display_work_take(t_display_work *work, size_t n)
+{
+    work->bytes = (work->bytes > n) ? (work->bytes - n) : 0U;
+}
+
+#ifdef DISPLAY_HAS_ASYNC
+#define DEASPLAY_ASYNC_HEADER           (sizeof(t_deasplay_async_op))
+
+/* the display is refreshed through the transfer queues */
+#define DEASPLAY_ASYNC(ctx)             ((ctx)->async.queue[0] != NULL)
+
+/**
+ * Append an operation to the queue being filled.
+ * The refresh budget (display_async_budget()) guarantees that it fits.
+ * @param ctx   the display
+ * @param op    the operation (e_deasplay_async_op)
+ * @param a     line or page
+ * @param b     character or column
+ * @param data  the data bytes
+ * @param len   number of data bytes
+ */
+static void display_async_put(t_deasplay *ctx, uint8_t op, deasplay_coord_t a, deasplay_coord_t b,
+                              const uint8_t *data, deasplay_coord_t len)
+{
+    t_deasplay_async_op header;
+    uint8_t *q = &ctx->async.queue[ctx->async.fill][ctx->async.used];
+
+    header.op = op;
+    header.a = a;
+    header.b = b;
+    header.len = len;
+    memcpy(q, &header, DEASPLAY_ASYNC_HEADER);
+    if (len != 0U) memcpy(&q[DEASPLAY_ASYNC_HEADER], data, len);
+
+    ctx->async.used += DEASPLAY_ASYNC_HEADER + len;
+}
+
+/**
+ * Limit the budget of a refresh to the room left in the queue being filled.
+ * The headers of the last run (cursor and data) and of the state
+ * notification ending the step are kept aside, the others
+ * are taken from the budget as they are queued.
+ * @param ctx   the display
+ * @param work  what the refresh is still allowed to do
+ */
+static void display_async_budget(t_deasplay *ctx, t_display_work *work)
+{
+    size_t room = ctx->async.size - ctx->async.used;
+
+    /* and the state notification closing the step */
+    room = (room > (3U * DEASPLAY_ASYNC_HEADER)) ? (room - (3U * DEASPLAY_ASYNC_HEADER)) : 0U;
+    if (work->bytes > room) work->bytes = room;
+    if (work->bytes == 0U) work->spent = true;
+}
+
+/**
+ * Hand the queue being filled to the driver, unless the
+ * other one is still being transferred.
+ * @param ctx   the display
+ * @param hal   its driver
+ */
+DEASPLAY_INLINE void display_async_publish(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+    uint8_t *queue;
+    size_t len;
+
+    if ((ctx->async.used == 0U) || __atomic_load_n(&ctx->async.busy, __ATOMIC_ACQUIRE)) return;
+
+    queue = ctx->async.queue[ctx->async.fill];
+    len = ctx->async.used;
+    ctx->async.fill ^= 1U;
+    ctx->async.used = 0U;
+
+    /* the transfer may complete before submit() returns */
+    __atomic_store_n(&ctx->async.busy, true, __ATOMIC_RELEASE);
+    hal->submit(queue, len);
+}
+
+/**
+ * Queue customized characters behind the pending operations, so that
+ * the driver traffic stays in order. Never waits for the driver.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param id    the id of the character
+ * @param data  the data
+ * @param len   length of the data
+ * @return false if both queues are taken: to be done again once the
+ *         transfer in progress completes
+ */
+DEASPLAY_INLINE bool display_async_extended(t_deasplay *ctx, const t_deasplay_hal *hal, uint8_t id, uint8_t *data, uint8_t len)
+{
+    if ((ctx->async.size - ctx->async.used) < (DEASPLAY_ASYNC_HEADER + len))
+    {
+        /* hand the full queue over, the character goes in the other one */
+        display_async_publish(ctx, hal);
+        if ((ctx->async.size - ctx->async.used) < (DEASPLAY_ASYNC_HEADER + len))
+        {
+            if ((ctx->async.used != 0U) || __atomic_load_n(&ctx->async.busy, __ATOMIC_ACQUIRE)) return false;
+
+            /* larger than a queue: sent directly, the driver being idle */
+            hal->set_extended(id, data, len);
+            return true;
+        }
+    }
+
+    display_async_put(ctx, DEASPLAY_ASYNC_EXTENDED, id, 0U, data, len);
+
+    return true;
+}
+#endif
+
+/**
+ * Notify the driver of a state of the refresh; through the queue, in order
+ * with the operations, when refreshing asynchronously.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param state the state
+ */
+DEASPLAY_INLINE void display_state(t_deasplay *ctx, const t_deasplay_hal *hal, e_deasplay_state state)
+{
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx))
+    {
+        display_async_put(ctx, DEASPLAY_ASYNC_STATE, (deasplay_coord_t)state, 0U, NULL, 0U);
+        return;
+    }
+#else
+    (void)ctx;
+#endif
+    hal->state_callback(state);
+}
+
+/**
+ * Send a run of changed characters to the hardware.
+ * The cursor command is skipped when the controller's auto-increment
+ * already points to the first character of the run.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param line  line of the first character
+ * @param chr   column of the first character
+ * @param data  the characters to be written
+ * @param len   number of characters
+ * @param work  what the refresh is still allowed to do
+ */
+DEASPLAY_INLINE void display_write_run(t_deasplay *ctx, const t_deasplay_hal *hal,
+                                       deasplay_index_t line, deasplay_index_t chr,
+                                       uint8_t *data, deasplay_index_t len,
+                                       t_display_work *work)
+{
+    deasplay_index_t index = (line * DISPLAY_CTX_CHARS(ctx)) + chr;
+    deasplay_index_t i;
+
+    if ((ctx->status.hw_valid == false) || (ctx->status.hw_index != index))
+    {
+#ifdef DISPLAY_HAS_ASYNC
+        if (DEASPLAY_ASYNC(ctx))
+        {
+            display_async_put(ctx, DEASPLAY_ASYNC_CURSOR, (deasplay_coord_t)line, (deasplay_coord_t)chr, NULL, 0U);
+            display_work_take(work, DEASPLAY_ASYNC_HEADER);
+        }
+        else
+#endif
+        {
+            hal->set_cursor(line, chr);
+        }
+        DEASPLAY_STAT_ADD(ctx, cursor_commands, 1U);
+    }
+    DEASPLAY_STAT_ADD(ctx, cells_dirty, len);
+    DEASPLAY_STAT_ADD(ctx, bytes_written, len);
+    display_work_take(work, len);
+
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx))
+    {
+        /* the driver writes the run when it replays the queue */
+        display_async_put(ctx, DEASPLAY_ASYNC_RUN, (deasplay_coord_t)line, (deasplay_coord_t)chr, data, (deasplay_coord_t)len);
+        display_work_take(work, DEASPLAY_ASYNC_HEADER);
+    }
+    else
+#endif
+    if (hal->write_run != NULL)
+    {
+        /* the driver can transfer the whole run at once */
+        hal->write_run(line, chr, data, len);
+    }
+    else
+    {
+        /* fallback: one character at a time */
+        for (i = 0; i < len; i++)
+        {
+            hal->write_char(data[i]);
+        }
+    }
+
+    /* the controller auto-increments the address after each character but what
+     * happens past the end of a line is controller specific, hence do not rely on it */
+    ctx->status.hw_index = index + len;
+    ctx->status.hw_valid = ((chr + len) < DISPLAY_CTX_CHARS(ctx));
+}
+
+#ifdef HAS_BITMAP
+/**
+ * Extend the changed columns of a bitmap page.
+ * @param ctx   the display
+ * @param page  the page
+ * @param x     first changed column
+ * @param w     number of changed columns (the caller keeps x + w within the page)
+ * @return true if the page had no change pending
+ */
+static bool display_mark_span(t_deasplay *ctx, deasplay_coord_t page, deasplay_coord_t x, deasplay_coord_t w)
+{
+    deasplay_coord_t *span = &ctx->spans[2U * page];
+    bool was_clean = (span[0] >= span[1]);
+
+    if (was_clean)
+    {
+        span[0] = x;
+        span[1] = x + w;
+    }
+    else
+    {
+        if (x < span[0]) span[0] = x;
+        if ((x + w) > span[1]) span[1] = x + w;
+    }
+
+    return was_clean;
+}
+
+/**
+ * Push the changed columns of a page in one transfer, or as much
+ * of them as the budget allows.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param page  the page
+ * @param work  what the refresh is still allowed to do
+ * @return true if the page is done
+ */
+DEASPLAY_INLINE bool display_flush_page_span(t_deasplay *ctx, const t_deasplay_hal *hal,
+                                             deasplay_coord_t page, t_display_work *work)
+{
+    deasplay_coord_t *span = &ctx->spans[2U * page];
+    deasplay_coord_t len;
+
+    if (span[0] >= span[1]) return true;
+    if (work->spent) return false;
+
+    if (hal->write_span != NULL)
+    {
+        len = span[1] - span[0];
+        if (len > work->bytes) len = (deasplay_coord_t)work->bytes;
+
+#ifdef DISPLAY_HAS_ASYNC
+        if (DEASPLAY_ASYNC(ctx))
+        {
+            display_async_put(ctx, DEASPLAY_ASYNC_SPAN, page, span[0], &hal->get_buffer()[((size_t)page * DISPLAY_CTX_WIDTH(ctx)) + span[0]], len);
+            display_work_take(work, DEASPLAY_ASYNC_HEADER);
+        }
+        else
+#endif
+        {
+            hal->write_span(page, span[0], &hal->get_buffer()[((size_t)page * DISPLAY_CTX_WIDTH(ctx)) + span[0]], len);
+        }
+        DEASPLAY_STAT_ADD(ctx, bytes_written, len);
+        display_work_take(work, len);
+        span[0] += len;
+
+        if (display_work_check(work) && (span[0] < span[1])) return false;
+    }
+
+    /* without write_span the application pushes the buffer itself */
+    span[0] = 0U;
+    span[1] = 0U;
+
+    return true;
+}
+#endif
+
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+/**
+ * Push the bytes of a page that differ from the shadow copy.
+ * Changed runs separated by less unchanged bytes than the cost of
+ * starting a new transfer (the driver's span_overhead) are merged.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param page  the page
+ * @param from  first column to be checked
+ * @param work  what the refresh is still allowed to do
+ * @return the column to resume from, the page width once the page is done
+ */
+DEASPLAY_INLINE size_t display_flush_page(t_deasplay *ctx, const t_deasplay_hal *hal,
+                                          deasplay_coord_t page, size_t from, t_display_work *work)
+{
+    size_t x;
+    size_t start;
+    size_t limit;
+    size_t next;
+    uint8_t *b = &hal->get_buffer()[(size_t)page * DISPLAY_CTX_WIDTH(ctx)];
+    uint8_t *s = &ctx->bitmap_shadow[(size_t)page * DISPLAY_CTX_WIDTH(ctx)];
+
+    x = display_diff(b, s, from, DISPLAY_CTX_WIDTH(ctx));
+    while ((x < DISPLAY_CTX_WIDTH(ctx)) && (work->spent == false))
+    {
+        start = x;
+        limit = DISPLAY_CTX_WIDTH(ctx);
+        if ((limit - start) > work->bytes) limit = start + work->bytes;
+        for (;;)
+        {
+            /* end of the changed run */
+            while ((x < limit) && (b[x] != s[x]))
+            {
+                s[x] = b[x];
+                x++;
+            }
+
+            /* merge the next run if the gap is cheaper than a new transfer */
+            next = display_diff(b, s, x, DISPLAY_CTX_WIDTH(ctx));
+            if ((next >= limit) || ((next - x) > hal->span_overhead)) break;
+            x = next;
+        }
+
+#ifdef DISPLAY_HAS_ASYNC
+        if (DEASPLAY_ASYNC(ctx))
+        {
+            display_async_put(ctx, DEASPLAY_ASYNC_SPAN, page, (deasplay_coord_t)start, &b[start], (deasplay_coord_t)(x - start));
+            display_work_take(work, DEASPLAY_ASYNC_HEADER);
+        }
+        else
+#endif
+        {
+            hal->write_span(page, (deasplay_coord_t)start, &b[start], (deasplay_coord_t)(x - start));
+        }
+        DEASPLAY_STAT_ADD(ctx, bytes_written, x - start);
+        display_work_take(work, x - start);
+        x = next;
+
+        (void)display_work_check(work);
+    }
+    if (x < DISPLAY_CTX_WIDTH(ctx)) return x;
+
+    /* everything is in sync, the glyph spans are not needed */
+    ctx->spans[2U * page] = 0U;
+    ctx->spans[(2U * page) + 1U] = 0U;
+
+    return DISPLAY_CTX_WIDTH(ctx);
+}
+
+/**
+ * Push the bitmap bytes that differ from the shadow copy, page by page.
+ * @param ctx   the display
+ * @param hal   its driver
+ */
+DEASPLAY_INLINE void display_flush_run(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+    t_display_work work = { SIZE_MAX, SIZE_MAX, 0U, false, false };
+    deasplay_coord_t page;
+    size_t x;
+
+    if ((ctx->bitmap_shadow == NULL) || (hal->get_buffer == NULL) || (hal->write_span == NULL)) return;
+
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx))
+    {
+        /* what does not fit in the queue is pushed by the next call */
+        display_async_publish(ctx, hal);
+        display_async_budget(ctx, &work);
+    }
+#endif
+
+    for (page = 0; page < DISPLAY_CTX_LINES(ctx); page++)
+    {
+        x = display_flush_page(ctx, hal, page, 0U, &work);
+        if (x < DISPLAY_CTX_WIDTH(ctx))
+        {
+            /* the queue is full: leave the rest to display_periodic() */
+            if (display_mark_span(ctx, page, (deasplay_coord_t)x, (deasplay_coord_t)(DISPLAY_CTX_WIDTH(ctx) - x))) display_touch(ctx);
+        }
+    }
+
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx)) display_async_publish(ctx, hal);
+#endif
+}
+
+DEASPLAY_INLINE void display_flush_impl(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        display_trace_begin(ctx, DISPLAY_TRACE_FLUSH, NULL);
+        display_flush_run(ctx, hal);
+        display_trace_event(ctx, DISPLAY_TRACE_END);
+        return;
+    }
+#endif
+    display_flush_run(ctx, hal);
+}
+
+void display_flush_ctx(t_deasplay *ctx)
+{
+    display_flush_impl(ctx, ctx->hal);
+}
+
+void display_flush(void)
+{
+    display_flush_impl(&display_default, DISPLAY_DEFAULT_HAL);
+}
+
+void display_set_bitmap_shadow_ctx(t_deasplay *ctx, uint8_t *shadow)
+{
+    ctx->bitmap_shadow = shadow;
+}
+#endif
+
+/**
+ * Shift a window of a grid of cells, filling the cells uncovered.
+ * @param cells     the grid
+ * @param stride    cells per row of the grid
+ * @param row       first row of the window
+ * @param col       first column of the window
+ * @param rows      rows of the window
+ * @param cols      columns of the window
+ * @param dx        columns to shift by, positive to the right
+ * @param dy        rows to shift by, positive downwards
+ * @param fill      value of the uncovered cells
+ */
+static void display_shift_cells(uint8_t *cells, size_t stride, deasplay_coord_t row, deasplay_coord_t col,
+                                deasplay_coord_t rows, deasplay_coord_t cols, int16_t dx, int16_t dy, uint8_t fill)
+{
+    deasplay_coord_t i;
+    int32_t r;
+    int32_t src;
+    uint8_t *d;
+    uint8_t *s;
+    size_t n = ((dx >= 0) ? (size_t)dx : (size_t)-dx);
+
+    if (n > cols) n = cols;
+    for (i = 0; i < rows; i++)
+    {
+        /* downwards the bottom row is moved first, upwards the top one */
+        r = (dy > 0) ? (int32_t)(rows - 1U - i) : (int32_t)i;
+        src = r - dy;
+        d = &cells[((size_t)(row + r) * stride) + col];
+        if ((src < 0) || (src >= (int32_t)rows))
+        {
+            memset(d, (int)fill, cols);
+            continue;
+        }
+        s = &cells[((size_t)(row + src) * stride) + col];
+        if (dx >= 0)
+        {
+            memmove(&d[n], s, cols - n);
+            memset(d, (int)fill, n);
+        }
+        else
+        {
+            memmove(d, &s[n], cols - n);
+            memset(&d[cols - n], (int)fill, n);
+        }
+    }
+}
+
+#if defined(HAS_BITMAP) && defined(DISPLAY_HAS_BITMAP_SHADOW)
+/**
+ * Send the columns of a window uncovered by a panel shift.
+ * @param ctx       the display
+ * @param hal       its driver
+ * @param line      first text line (page) of the window
+ * @param chr       first character of the window
+ * @param lines     text lines of the window
+ * @param chars     characters of the window
+ * @param dx        characters shifted by
+ * @param dy        lines shifted by
+ */
+static void display_scroll_blank(t_deasplay *ctx, const t_deasplay_hal *hal, deasplay_coord_t line, deasplay_coord_t chr,
+                                 deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+    deasplay_coord_t page;
+    deasplay_coord_t x = (deasplay_coord_t)(chr * DISPLAY_CTX_FONT_X(ctx));
+    deasplay_coord_t w = (deasplay_coord_t)(chars * DISPLAY_CTX_FONT_X(ctx));
+    deasplay_coord_t n = (deasplay_coord_t)(((dx >= 0) ? dx : -dx) * DISPLAY_CTX_FONT_X(ctx));
+    deasplay_coord_t first = (dy > 0) ? (deasplay_coord_t)(line + dy) : line;
+    deasplay_coord_t last = (dy < 0) ? (deasplay_coord_t)(line + lines + dy) : (deasplay_coord_t)(line + lines);
+    uint8_t *buffer = hal->get_buffer();
+
+    if (n > w) n = w;
+    for (page = line; page < (line + lines); page++)
+    {
+        if ((page < first) || (page >= last))
+        {
+            hal->write_span(page, x, &buffer[((size_t)page * DISPLAY_CTX_WIDTH(ctx)) + x], w);
+            DEASPLAY_STAT_ADD(ctx, bytes_written, w);
+        }
+        else if (n != 0U)
+        {
+            /* a blank strip on the side the window moved away from */
+            deasplay_coord_t from = (dx > 0) ? x : (deasplay_coord_t)(x + w - n);
+            hal->write_span(page, from, &buffer[((size_t)page * DISPLAY_CTX_WIDTH(ctx)) + from], n);
+            DEASPLAY_STAT_ADD(ctx, bytes_written, n);
+        }
+    }
+}
+#endif
+
+DEASPLAY_INLINE void display_scroll_impl(t_deasplay *ctx, const t_deasplay_hal *hal, deasplay_coord_t line, deasplay_coord_t chr,
+                                         deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+    deasplay_coord_t i;
+    bool shifted = false;
+#ifdef HAS_BITMAP
+    deasplay_coord_t page;
+    bool pending = false;
+#endif
+
+    /* clip the window against the panel */
+    if ((line >= DISPLAY_CTX_LINES(ctx)) || (chr >= DISPLAY_CTX_CHARS(ctx)) || (lines == 0U) || (chars == 0U)) return;
+    if (lines > (DISPLAY_CTX_LINES(ctx) - line)) lines = DISPLAY_CTX_LINES(ctx) - line;
+    if (chars > (DISPLAY_CTX_CHARS(ctx) - chr)) chars = DISPLAY_CTX_CHARS(ctx) - chr;
+    if ((dx == 0) && (dy == 0)) return;
+
+    display_shift_cells(ctx->buffer, DISPLAY_CTX_CHARS(ctx), line, chr, lines, chars, dx, dy, (uint8_t)' ');
+    for (i = line; i < (line + lines); i++)
+    {
+        display_mark_line(ctx, i);
+    }
+
+    /* queued transfers would land after the shift: no hardware scrolling */
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx) == false)
+#endif
+    {
+        shifted = (hal->scroll != NULL) && hal->scroll(line, chr, lines, chars, dx, dy);
+    }
+    if (shifted == false) return;
+
+    /* the panel still matches the shadow: the uncovered cells are unknown */
+    display_shift_cells(ctx->shadow, DISPLAY_CTX_CHARS(ctx), line, chr, lines, chars, dx, dy, (uint8_t)'\0');
+    ctx->status.hw_valid = false;
+#ifdef HAS_BITMAP
+    if (hal->get_buffer != NULL)
+    {
+        /* a text line is a page: move the pixels of the window along */
+        display_shift_cells(hal->get_buffer(), DISPLAY_CTX_WIDTH(ctx), line, (deasplay_coord_t)(chr * DISPLAY_CTX_FONT_X(ctx)), lines,
+                            (deasplay_coord_t)(chars * DISPLAY_CTX_FONT_X(ctx)), (int16_t)(dx * (int16_t)DISPLAY_CTX_FONT_X(ctx)), dy, 0U);
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+        if ((ctx->bitmap_shadow != NULL) && (hal->write_span != NULL))
+        {
+            /* no byte value stands for 'unknown' in the shadow: the uncovered
+             * columns, blank now, are sent at once so that the shadow holds */
+            display_shift_cells(ctx->bitmap_shadow, DISPLAY_CTX_WIDTH(ctx), line, (deasplay_coord_t)(chr * DISPLAY_CTX_FONT_X(ctx)), lines,
+                                (deasplay_coord_t)(chars * DISPLAY_CTX_FONT_X(ctx)), (int16_t)(dx * (int16_t)DISPLAY_CTX_FONT_X(ctx)), dy, 0U);
+            display_scroll_blank(ctx, hal, line, chr, lines, chars, dx, dy);
+        }
+#endif
+        /* columns waiting to be sent have moved: send the whole window */
+        for (page = line; page < (line + lines); page++)
+        {
+            if (ctx->spans[2U * page] < ctx->spans[(2U * page) + 1U]) pending = true;
+        }
+        if (pending)
+        {
+            for (page = line; page < (line + lines); page++)
+            {
+                (void)display_mark_span(ctx, page, (deasplay_coord_t)(chr * DISPLAY_CTX_FONT_X(ctx)), (deasplay_coord_t)(chars * DISPLAY_CTX_FONT_X(ctx)));
+            }
+            display_touch(ctx);
+        }
+    }
+#endif
+}
+
+#ifdef DISPLAY_HAS_TRACE
+/**
+ * Record a scroll called by the application; the scrolls of the marquees
+ * and the viewport are not.
+ */
+static void display_scroll_trace(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+    uint32_t args[6] = { line, chr, lines, chars, (uint16_t)(int16_t)dx, (uint16_t)(int16_t)dy };
+
+    if (ctx->trace != NULL) display_trace_api(ctx, DISPLAY_TRACE_API_SCROLL, args, 6U, NULL, 0U);
+}
+#endif
+
+void display_scroll_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+#ifdef DISPLAY_HAS_TRACE
+    display_scroll_trace(ctx, line, chr, lines, chars, dx, dy);
+#endif
+    display_scroll_impl(ctx, ctx->hal, line, chr, lines, chars, dx, dy);
+}
+
+void display_scroll(deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy)
+{
+#ifdef DISPLAY_HAS_TRACE
+    display_scroll_trace(&display_default, line, chr, lines, chars, dx, dy);
+#endif
+    display_scroll_impl(&display_default, DISPLAY_DEFAULT_HAL, line, chr, lines, chars, dx, dy);
+}
+
+/**
+ * Get the character of a marquee at a position of its period.
+ */
+static uint8_t display_marquee_char(const t_display_marquee *marquee, uint16_t pos)
+{
+    uint16_t len = (uint16_t)(marquee->period - marquee->gap);
+
+    pos = (uint16_t)(pos % marquee->period);
+    return (pos < len) ? (uint8_t)marquee->text[pos] : (uint8_t)' ';
+}
+
+void display_marquee_start_ctx(t_deasplay *ctx, t_display_marquee *marquee)
+{
+    deasplay_coord_t i;
+    deasplay_index_t base;
+
+    marquee->period = (uint16_t)(strlen(marquee->text) + marquee->gap);
+    marquee->pos = 0U;
+    if ((marquee->period == 0U) || (marquee->line >= DISPLAY_CTX_LINES(ctx)) || (marquee->chr >= DISPLAY_CTX_CHARS(ctx))) return;
+    if (marquee->chars > (DISPLAY_CTX_CHARS(ctx) - marquee->chr)) marquee->chars = DISPLAY_CTX_CHARS(ctx) - marquee->chr;
+
+    base = (deasplay_index_t)((marquee->line * DISPLAY_CTX_CHARS(ctx)) + marquee->chr);
+    for (i = 0; i < marquee->chars; i++)
+    {
+        ctx->buffer[base + i] = display_marquee_char(marquee, i);
+    }
+    display_mark_line(ctx, marquee->line);
+}
+
+void display_marquee_start(t_display_marquee *marquee)
+{
+    display_marquee_start_ctx(&display_default, marquee);
+}
+
+void display_marquee_step_ctx(t_deasplay *ctx, t_display_marquee *marquee)
+{
+    deasplay_index_t last;
+
+    if ((marquee->period == 0U) || (marquee->chars == 0U) || (marquee->line >= DISPLAY_CTX_LINES(ctx)) || (marquee->chr >= DISPLAY_CTX_CHARS(ctx))) return;
+
+    /* everything moves one column to the left, one character comes in */
+    display_scroll_impl(ctx, ctx->hal, marquee->line, marquee->chr, 1U, marquee->chars, -1, 0);
+    marquee->pos = (uint16_t)((marquee->pos + 1U) % marquee->period);
+    last = (deasplay_index_t)((marquee->line * DISPLAY_CTX_CHARS(ctx)) + marquee->chr + marquee->chars - 1U);
+    ctx->buffer[last] = display_marquee_char(marquee, (uint16_t)(marquee->pos + marquee->chars - 1U));
+}
+
+void display_marquee_step(t_display_marquee *marquee)
+{
+    display_marquee_step_ctx(&display_default, marquee);
+}
+
+#ifdef DISPLAY_HAS_LAYERS
+/**
+ * Add an area of the display to the cells to be composited again.
+ * @param ctx   the display
+ * @param line  first line, may be off the display
+ * @param chr   first character, may be off the display
+ * @param lines number of lines
+ * @param chars number of characters
+ */
+static void display_layers_dirty(t_deasplay *ctx, int32_t line, int32_t chr, int32_t lines, int32_t chars)
+{
+    deasplay_coord_t *dirty = ctx->layers.dirty;
+    int32_t end_line = line + lines;
+    int32_t end_chr = chr + chars;
+
+    if (line < 0) line = 0;
+    if (chr < 0) chr = 0;
+    if (end_line > (int32_t)DISPLAY_CTX_LINES(ctx)) end_line = (int32_t)DISPLAY_CTX_LINES(ctx);
+    if (end_chr > (int32_t)DISPLAY_CTX_CHARS(ctx)) end_chr = (int32_t)DISPLAY_CTX_CHARS(ctx);
+    if ((line >= end_line) || (chr >= end_chr)) return;
+
+    if (dirty[0] >= dirty[2])
+    {
+        dirty[0] = (deasplay_coord_t)line;
+        dirty[1] = (deasplay_coord_t)chr;
+        dirty[2] = (deasplay_coord_t)end_line;
+        dirty[3] = (deasplay_coord_t)end_chr;
+        return;
+    }
+    /* a single rectangle, growing to cover both */
+    if (line < (int32_t)dirty[0]) dirty[0] = (deasplay_coord_t)line;
+    if (chr < (int32_t)dirty[1]) dirty[1] = (deasplay_coord_t)chr;
+    if (end_line > (int32_t)dirty[2]) dirty[2] = (deasplay_coord_t)end_line;
+    if (end_chr > (int32_t)dirty[3]) dirty[3] = (deasplay_coord_t)end_chr;
+}
+
+/**
+ * Add the area of the display covered by a visible layer to the cells to be composited again.
+ */
+static void display_layer_dirty_area(t_deasplay *ctx, e_display_layer id)
+{
+    const t_display_layer *layer = ctx->layers.layer[id];
+
+    if ((layer == NULL) || (layer->visible == false)) return;
+    if (id == DISPLAY_LAYER_BASE)
+    {
+        display_layers_dirty(ctx, 0, 0, (int32_t)DISPLAY_CTX_LINES(ctx), (int32_t)DISPLAY_CTX_CHARS(ctx));
+    }
+    else
+    {
+        display_layers_dirty(ctx, (int32_t)layer->line, (int32_t)layer->chr, (int32_t)layer->lines, (int32_t)layer->chars);
+    }
+}
+
+/**
+ * Composite the layers into the cells of the buffer touched since the last time.
+ * @param ctx   the display
+ */
+static void display_layers_compose(t_deasplay *ctx)
+{
+    deasplay_coord_t *dirty = ctx->layers.dirty;
+    const t_display_layer *layer;
+    deasplay_coord_t line;
+    deasplay_coord_t chr;
+    uint32_t l;
+    uint32_t c;
+    uint8_t id;
+    uint8_t value;
+    uint8_t *cell;
+    bool changed;
+#ifdef DISPLAY_HAS_FIELDS
+    t_display_field *field;
+#endif
+
+    for (line = dirty[0]; line < dirty[2]; line++)
+    {
+        changed = false;
+        cell = &ctx->buffer[((deasplay_index_t)line * DISPLAY_CTX_CHARS(ctx)) + dirty[1]];
+        for (chr = dirty[1]; chr < dirty[3]; chr++, cell++)
+        {
+            value = (uint8_t)' ';
+            /* the topmost layer with something to show wins */
+            for (id = DISPLAY_LAYERS; id > 0U; id--)
+            {
+                layer = ctx->layers.layer[id - 1U];
+                if ((layer == NULL) || (layer->visible == false)) continue;
+                if ((id - 1U) == DISPLAY_LAYER_BASE)
+                {
+                    l = (uint32_t)line + layer->line;
+                    c = (uint32_t)chr + layer->chr;
+                }
+                else
+                {
+                    if ((line < layer->line) || (chr < layer->chr)) continue;
+                    l = (uint32_t)line - layer->line;
+                    c = (uint32_t)chr - layer->chr;
+                }
+                if ((l >= layer->lines) || (c >= layer->chars)) continue;
+                if (layer->cells[(l * layer->chars) + c] != (uint8_t)DISPLAY_LAYER_CLEAR)
+                {
+                    value = layer->cells[(l * layer->chars) + c];
+                    break;
+                }
+            }
+            if (*cell != value)
+            {
+                *cell = value;
+                changed = true;
+            }
+        }
+        if (changed) display_mark_line(ctx, line);
+    }
+
+#ifdef DISPLAY_HAS_FIELDS
+    /* fields stay on top of the layers */
+    for (field = ctx->fields; field != NULL; field = field->next)
+    {
+        if ((field->line >= dirty[0]) && (field->line < dirty[2]) &&
+            (field->chr < dirty[3]) && ((field->chr + field->len) > dirty[1]))
+        {
+            field->valid = false;
+        }
+    }
+#endif
+
+    dirty[0] = 0U;
+    dirty[2] = 0U;
+}
+
+void display_layer_set_ctx(t_deasplay *ctx, e_display_layer id, t_display_layer *layer)
+{
+    display_layer_dirty_area(ctx, id);
+    ctx->layers.layer[id] = layer;
+    display_layer_dirty_area(ctx, id);
+}
+
+void display_layer_set(e_display_layer id, t_display_layer *layer)
+{
+    display_layer_set_ctx(&display_default, id, layer);
+}
+
+void display_layer_show_ctx(t_deasplay *ctx, e_display_layer id, bool visible)
+{
+    t_display_layer *layer = ctx->layers.layer[id];
+
+    if ((layer == NULL) || (layer->visible == visible)) return;
+    /* the area is dirty whether the layer appears or goes */
+    layer->visible = true;
+    display_layer_dirty_area(ctx, id);
+    layer->visible = visible;
+}
+
+void display_layer_show(e_display_layer id, bool visible)
+{
+    display_layer_show_ctx(&display_default, id, visible);
+}
+
+void display_layer_move_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr)
+{
+    t_display_layer *layer = ctx->layers.layer[id];
+    int32_t dx;
+    int32_t dy;
+    uint8_t other;
+
+    if (layer == NULL) return;
+    if (id != DISPLAY_LAYER_BASE)
+    {
+        display_layer_dirty_area(ctx, id);
+        layer->line = line;
+        layer->chr = chr;
+        display_layer_dirty_area(ctx, id);
+        return;
+    }
+
+    /* the viewport stays on the canvas */
+    if (((uint32_t)line + DISPLAY_CTX_LINES(ctx)) > layer->lines)
+    {
+        line = (layer->lines > DISPLAY_CTX_LINES(ctx)) ? (deasplay_coord_t)(layer->lines - DISPLAY_CTX_LINES(ctx)) : 0U;
+    }
+    if (((uint32_t)chr + DISPLAY_CTX_CHARS(ctx)) > layer->chars)
+    {
+        chr = (layer->chars > DISPLAY_CTX_CHARS(ctx)) ? (deasplay_coord_t)(layer->chars - DISPLAY_CTX_CHARS(ctx)) : 0U;
+    }
+    dx = (int32_t)layer->chr - (int32_t)chr;
+    dy = (int32_t)layer->line - (int32_t)line;
+    if ((dx == 0) && (dy == 0)) return;
+
+    if ((layer->visible == false) || (dx <= -(int32_t)DISPLAY_CTX_CHARS(ctx)) || (dx >= (int32_t)DISPLAY_CTX_CHARS(ctx)) ||
+        (dy <= -(int32_t)DISPLAY_CTX_LINES(ctx)) || (dy >= (int32_t)DISPLAY_CTX_LINES(ctx)) || (dx < INT8_MIN) || (dx > INT8_MAX) ||
+        (dy < INT8_MIN) || (dy > INT8_MAX)
+#ifdef DISPLAY_HAS_FIELDS
+        /* fields would move along with the text */
+        || (ctx->fields != NULL)
+#endif
+        )
+    {
+        layer->line = line;
+        layer->chr = chr;
+        display_layer_dirty_area(ctx, id);
+        return;
+    }
+
+    /* a small move: shift what is on the display (by the panel when it can)
+     * and composite the uncovered cells and the layers that do not move;
+     * the pending cells are composited first, or they would move too */
+    if (ctx->layers.dirty[0] < ctx->layers.dirty[2]) display_layers_compose(ctx);
+    layer->line = line;
+    layer->chr = chr;
+    display_scroll_impl(ctx, ctx->hal, 0U, 0U, DISPLAY_CTX_LINES(ctx), DISPLAY_CTX_CHARS(ctx), (int8_t)dx, (int8_t)dy);
+    if (dy > 0) display_layers_dirty(ctx, 0, 0, dy, (int32_t)DISPLAY_CTX_CHARS(ctx));
+    if (dy < 0) display_layers_dirty(ctx, (int32_t)DISPLAY_CTX_LINES(ctx) + dy, 0, -dy, (int32_t)DISPLAY_CTX_CHARS(ctx));
+    if (dx > 0) display_layers_dirty(ctx, 0, 0, (int32_t)DISPLAY_CTX_LINES(ctx), dx);
+    if (dx < 0) display_layers_dirty(ctx, 0, (int32_t)DISPLAY_CTX_CHARS(ctx) + dx, (int32_t)DISPLAY_CTX_LINES(ctx), -dx);
+    for (other = DISPLAY_LAYER_BASE + 1U; other < DISPLAY_LAYERS; other++)
+    {
+        /* where the layer is and where the shift has taken its cells */
+        layer = ctx->layers.layer[other];
+        if ((layer == NULL) || (layer->visible == false)) continue;
+        display_layers_dirty(ctx, (int32_t)layer->line, (int32_t)layer->chr, (int32_t)layer->lines, (int32_t)layer->chars);
+        display_layers_dirty(ctx, (int32_t)layer->line + dy, (int32_t)layer->chr + dx, (int32_t)layer->lines, (int32_t)layer->chars);
+    }
+}
+
+void display_layer_move(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr)
+{
+    display_layer_move_ctx(&display_default, id, line, chr);
+}
+
+void display_layer_invalidate_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars)
+{
+    const t_display_layer *layer = ctx->layers.layer[id];
+
+    if ((layer == NULL) || (layer->visible == false)) return;
+    if (id == DISPLAY_LAYER_BASE)
+    {
+        /* canvas to display coordinates */
+        display_layers_dirty(ctx, (int32_t)line - layer->line, (int32_t)chr - layer->chr, (int32_t)lines, (int32_t)chars);
+    }
+    else
+    {
+        display_layers_dirty(ctx, (int32_t)line + layer->line, (int32_t)chr + layer->chr, (int32_t)lines, (int32_t)chars);
+    }
+}
+
+void display_layer_invalidate(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars)
+{
+    display_layer_invalidate_ctx(&display_default, id, line, chr, lines, chars);
+}
+
+void display_layer_write_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, const char *str)
+{
+    t_display_layer *layer = ctx->layers.layer[id];
+    deasplay_coord_t len = 0U;
+
+    if ((layer == NULL) || (line >= layer->lines) || (chr >= layer->chars)) return;
+    while ((str[len] != '\0') && (len < (layer->chars - chr)))
+    {
+        layer->cells[((uint32_t)line * layer->chars) + chr + len] = (uint8_t)str[len];
+        len++;
+    }
+    display_layer_invalidate_ctx(ctx, id, line, chr, 1U, len);
+}
+
+void display_layer_write(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, const char *str)
+{
+    display_layer_write_ctx(&display_default, id, line, chr, str);
+}
+#endif
+
+/**
+ * Refresh the changed cells of a line, or as many of them as the budget allows.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param line  the line to be refreshed
+ * @param from  first cell to be checked
+ * @param work  what the refresh is still allowed to do
+ * @return the cell to resume from, the end of the line once the line is done
+ */
+DEASPLAY_INLINE deasplay_index_t display_refresh_line(t_deasplay *ctx, const t_deasplay_hal *hal,
+                                                      deasplay_index_t line, deasplay_index_t from,
+                                                      t_display_work *work)
+{
+    deasplay_index_t i = from;
+    deasplay_index_t end = (line + 1U) * DISPLAY_CTX_CHARS(ctx);
+    deasplay_index_t start;
+    deasplay_index_t limit;
+#ifdef HAS_BITMAP
+    deasplay_index_t chr;
+    uint8_t* b;
+    size_t pos;
+#endif
+
+    /* do not look further than allowed */
+    if ((size_t)(end - i) > work->cells) end = i + (deasplay_index_t)work->cells;
+
+    i = display_diff_next(ctx, i, end);
+    while ((i < end) && (work->spent == false))
+    {
+#ifdef HAS_BITMAP
+        if (hal->get_buffer != NULL)
+        {
+            ctx->shadow[i] = ctx->buffer[i];
+            chr = i - (line * DISPLAY_CTX_CHARS(ctx));
+            /* no cursor command: the glyph reaches the display with the
+             * page spans (or display_write_buffer()), which carry their position */
+            DEASPLAY_STAT_ADD(ctx, cells_dirty, 1U);
+
+            /* pass the character to the bitmap layer */
+            b = hal->get_buffer();
+
+            pos = (size_t)chr * DISPLAY_CTX_FONT_X(ctx); /* font spacing */
+            pos += (size_t)line * DISPLAY_CTX_WIDTH(ctx);
+
+            /* fetch the character */
+            bitmap_character(ctx->buffer[i], &b[pos], 8U, FONT_5x8);
+            display_mark_span(ctx, line, chr * DISPLAY_CTX_FONT_X(ctx), DISPLAY_CTX_FONT_X(ctx));
+            i++;
+        }
+        else
+#endif
+        {
+            /* collect the maximal span of changed characters the budget allows */
+            start = i;
+            limit = end;
+            if ((size_t)(limit - i) > work->bytes) limit = i + (deasplay_index_t)work->bytes;
+            while ((i < limit) && (ctx->buffer[i] != ctx->shadow[i]))
+            {
+                ctx->shadow[i] = ctx->buffer[i];
+                i++;
+            }
+
+            /* pass the run directly to the hardware driver */
+            display_write_run(ctx, hal, line, start - (line * DISPLAY_CTX_CHARS(ctx)), &ctx->buffer[start], i - start, work);
+        }
+        if (display_work_check(work)) break;
+        i = display_diff_next(ctx, i, end);
+    }
+
+    DEASPLAY_STAT_ADD(ctx, cells_scanned, i - from);
+    work->cells -= (size_t)(i - from);
+    if (work->cells == 0U) work->spent = true;
+
+    return i;
+}
+
+#ifdef DISPLAY_HAS_STATS
+/**
+ * Account the duration of a refresh.
+ * @param ctx   the display
+ * @param start timestamp at the beginning of the refresh
+ */
+static void display_stats_time(t_deasplay *ctx, uint32_t start)
+{
+    uint32_t elapsed;
+
+    if (hw_timestamp == NULL) return;
+
+    elapsed = hw_timestamp() - start;
+    if ((ctx->stats.time_min == 0U) || (elapsed < ctx->stats.time_min)) ctx->stats.time_min = elapsed;
+    if (elapsed > ctx->stats.time_max) ctx->stats.time_max = elapsed;
+    ctx->stats.time_total += elapsed;
+}
+#endif
+
+/**
+ * Refresh the dirty lines, resuming where the previous call stopped.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param work  what the refresh is still allowed to do
+ * @return true if all the lines are done
+ */
+DEASPLAY_INLINE bool display_step_lines(t_deasplay *ctx, const t_deasplay_hal *hal, t_display_work *work)
+{
+    deasplay_index_t line;
+    uint8_t mask;
+
+    for (; ctx->status.resume_line < DISPLAY_CTX_LINES(ctx); ctx->status.resume_line++)
+    {
+        line = ctx->status.resume_line;
+        if (ctx->status.in_line == false)
+        {
+            /* visit only the lines that have been written to */
+            mask = (uint8_t)(1U << (line & 7U));
+            if ((ctx->dirty[line >> 3] & mask) == 0U) continue;
+            if (work->spent) return false;
+            ctx->dirty[line >> 3] &= (uint8_t)~mask;
+
+            ctx->status.resume_index = line * DISPLAY_CTX_CHARS(ctx);
+            ctx->status.in_line = true;
+        }
+
+#ifdef DISPLAY_HAS_TRACE
+        if (ctx->trace != NULL) display_trace_line(ctx, line, ctx->status.resume_index);
+#endif
+        ctx->status.resume_index = display_refresh_line(ctx, hal, line, ctx->status.resume_index, work);
+        if (ctx->status.resume_index < ((line + 1U) * DISPLAY_CTX_CHARS(ctx))) return false;
+        ctx->status.in_line = false;
+    }
+
+    return true;
+}
+
+#ifdef HAS_BITMAP
+/**
+ * Push the changed bitmap pages, resuming where the previous call stopped.
+ * The pages follow the lines in the resume position.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param work  what the refresh is still allowed to do
+ * @return true if all the pages are done
+ */
+DEASPLAY_INLINE bool display_step_pages(t_deasplay *ctx, const t_deasplay_hal *hal, t_display_work *work)
+{
+    deasplay_coord_t page;
+
+    for (; ctx->status.resume_line < (2U * DISPLAY_CTX_LINES(ctx)); ctx->status.resume_line++)
+    {
+        page = ctx->status.resume_line - DISPLAY_CTX_LINES(ctx);
+        if (work->spent) return false;
+
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+        if ((ctx->bitmap_shadow != NULL) && (hal->write_span != NULL))
+        {
+            /* the diff also picks up what has been drawn directly into the
+             * page, though only when a frame runs (changed text or
+             * display_mark_dirty()): drawing alone is pushed by display_flush().
+             * It restarts from the first column as display_flush() may have
+             * sent part of the page in the meantime */
+            if (display_flush_page(ctx, hal, page, 0U, work) < DISPLAY_CTX_WIDTH(ctx)) return false;
+        }
+        else
+#endif
+        if (display_flush_page_span(ctx, hal, page, work) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+/**
+ * Run a refresh until it completes or the budget runs out.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param work  what the refresh is allowed to do
+ * @return true if the display is up to date
+ */
+DEASPLAY_INLINE bool display_step_impl(t_deasplay *ctx, const t_deasplay_hal *hal, t_display_work *work)
+{
+    bool done;
+#ifdef DISPLAY_HAS_STATS
+    uint32_t start;
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx))
+    {
+        /* the previous transfer may be over: hand the pending queue over */
+        display_async_publish(ctx, hal);
+    }
+#endif
+
+#ifdef DISPLAY_HAS_LAYERS
+    /* composite what the layers changed, writes below land on top */
+    if (ctx->layers.dirty[0] < ctx->layers.dirty[2]) display_layers_compose(ctx);
+#endif
+#ifdef DISPLAY_HAS_RING
+    /* apply the writes of other threads before looking for changes */
+    display_ring_drain(ctx);
+#endif
+#ifdef DISPLAY_HAS_FIELDS
+    /* re-render the fields whose value changed */
+    display_fields_update(ctx);
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+    /* a glyph redefined in a slot already shown needs a frame as well */
+    if (ctx->cgram.pending != 0U) display_touch(ctx);
+#endif
+
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_dirty(ctx);
+#endif
+
+    /* fast path: nothing has been written since the last refresh */
+    if ((ctx->status.frame == false) && (ctx->status.generation == ctx->status.refreshed))
+    {
+        DEASPLAY_STAT_ADD(ctx, refreshes_skipped, 1U);
+        return true;
+    }
+#ifdef DISPLAY_HAS_ASYNC
+    /* a step needs room for its state notifications and a run: with both
+     * queues taken, it waits for the transfer in progress */
+    if (DEASPLAY_ASYNC(ctx) && ((ctx->async.size - ctx->async.used) < ((4U * DEASPLAY_ASYNC_HEADER) + 1U))) return false;
+#endif
+
+    if (ctx->status.frame == false)
+    {
+        ctx->status.refreshed = ctx->status.generation;
+        ctx->status.frame = true;
+        ctx->status.in_line = false;
+        ctx->status.resume_line = 0U;
+        DEASPLAY_STAT_ADD(ctx, refreshes, 1U);
+        display_state(ctx, hal, DEASPLAY_STATE_PERIODIC_START);
+    }
+    else
+    {
+        /* a paused frame goes on: the driver may batch again up to the
+         * next pause or the end */
+        display_state(ctx, hal, DEASPLAY_STATE_PERIODIC_RESUME);
+    }
+#ifdef DISPLAY_HAS_STATS
+    start = (hw_timestamp != NULL) ? hw_timestamp() : 0U;
+#endif
+
+#ifdef DISPLAY_HAS_CGRAM
+    /* custom characters are in place before the cells showing them, and
+     * within the frame, where the driver may be batching */
+    if (ctx->cgram.pending != 0U) (void)display_cgram_upload(ctx, hal, work);
+#endif
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx)) display_async_budget(ctx, work);
+#endif
+
+    done = display_step_lines(ctx, hal, work);
+#ifdef HAS_BITMAP
+    if (done && (hal->get_buffer != NULL))
+    {
+        done = display_step_pages(ctx, hal, work);
+    }
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+    /* the frame is not over before its custom characters are uploaded */
+    if (ctx->cgram.pending != 0U) done = false;
+#endif
+    if (done)
+    {
+        ctx->status.frame = false;
+        display_state(ctx, hal, DEASPLAY_STATE_PERIODIC_END);
+    }
+    else
+    {
+        display_state(ctx, hal, DEASPLAY_STATE_PERIODIC_PAUSE);
+    }
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx)) display_async_publish(ctx, hal);
+#endif
+#ifdef DISPLAY_HAS_STATS
+    display_stats_time(ctx, start);
+#endif
+
+    return done;
+}
+
+DEASPLAY_INLINE void display_periodic_run(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+    t_display_work work = { SIZE_MAX, SIZE_MAX, 0U, false, false };
+
+    /* a refresh interrupted by display_periodic_step() is completed first */
+    if (ctx->status.frame)
+    {
+        (void)display_step_impl(ctx, hal, &work);
+        if (display_is_dirty_ctx(ctx) == false) return;
+    }
+    (void)display_step_impl(ctx, hal, &work);
+}
+
+DEASPLAY_INLINE void display_periodic_impl(t_deasplay *ctx, const t_deasplay_hal *hal)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        display_trace_begin(ctx, DISPLAY_TRACE_STEP, NULL);
+        display_periodic_run(ctx, hal);
+        display_trace_event(ctx, DISPLAY_TRACE_END);
+        return;
+    }
+#endif
+    display_periodic_run(ctx, hal);
+}
+
+DEASPLAY_INLINE bool display_periodic_step_impl(t_deasplay *ctx, const t_deasplay_hal *hal, const t_display_budget *budget)
+{
+    t_display_work work = { SIZE_MAX, SIZE_MAX, 0U, false, false };
+
+    if (budget->cells != 0U) work.cells = budget->cells;
+    if (budget->bytes != 0U) work.bytes = budget->bytes;
+    if ((budget->time != 0U) && (hw_timestamp != NULL))
+    {
+        work.deadline = hw_timestamp() + budget->time;
+        work.timed = true;
+    }
+
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        bool done;
+
+        display_trace_begin(ctx, DISPLAY_TRACE_STEP, budget);
+        done = display_step_impl(ctx, hal, &work);
+        display_trace_event(ctx, DISPLAY_TRACE_END);
+        return done;
+    }
+#endif
+    return display_step_impl(ctx, hal, &work);
+}
+
+void display_periodic_ctx(t_deasplay *ctx)
+{
+    display_periodic_impl(ctx, ctx->hal);
+}
+
+void display_periodic(void)
+{
+    display_periodic_impl(&display_default, DISPLAY_DEFAULT_HAL);
+}
+
+bool display_periodic_step_ctx(t_deasplay *ctx, const t_display_budget *budget)
+{
+    return display_periodic_step_impl(ctx, ctx->hal, budget);
+}
+
+bool display_periodic_step(const t_display_budget *budget)
+{
+    return display_periodic_step_impl(&display_default, DISPLAY_DEFAULT_HAL, budget);
+}
+
+DEASPLAY_INLINE void display_set_cursor_impl(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr)
+{
+    /* stay inside the buffer whatever the input */
+    if (line >= DISPLAY_CTX_LINES(ctx)) line = DISPLAY_CTX_LINES(ctx) - 1U;
+    if (chr >= DISPLAY_CTX_CHARS(ctx)) chr = DISPLAY_CTX_CHARS(ctx) - 1U;
+
+    ctx->status.index = ((deasplay_index_t)line * (deasplay_index_t)DISPLAY_CTX_CHARS(ctx)) + (deasplay_index_t)chr;
+    ctx->status.line = line;
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        uint32_t args[2] = { line, chr };
+
+        display_trace_api(ctx, DISPLAY_TRACE_API_CURSOR, args, 2U, NULL, 0U);
+    }
+#endif
+}
+
+void display_set_cursor_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr)
+{
+    display_set_cursor_impl(ctx, line, chr);
+}
+
+void display_set_cursor(deasplay_coord_t line, deasplay_coord_t chr)
+{
+    display_set_cursor_impl(&display_default, line, chr);
+}
+
+DEASPLAY_INLINE void display_advance_cursor_impl(t_deasplay *ctx, deasplay_index_t num)
+{
+    deasplay_index_t index_max = DISPLAY_CTX_ELEMENTS(ctx) - 1U;
+
+    if ((index_max - ctx->status.index) > num)
+    {
+        ctx->status.index += num;
+    }
+    else
+    {
+        ctx->status.index = index_max;
+    }
+
+    /* keep track of the line the cursor is on */
+    while (ctx->status.index >= ((ctx->status.line + 1U) * DISPLAY_CTX_CHARS(ctx)))
+    {
+        ctx->status.line++;
+    }
+}
+
+void display_advance_cursor_ctx(t_deasplay *ctx, deasplay_index_t num)
+{
+    display_advance_cursor_impl(ctx, num);
+}
+
+void display_advance_cursor(deasplay_index_t num)
+{
+    display_advance_cursor_impl(&display_default, num);
+}
+
+void display_enable_cursor_ctx(t_deasplay *ctx, bool visible)
+{
+    ctx->hal->cursor_visibility(visible);
+}
+
+void display_enable_cursor(bool visible)
+{
+    DISPLAY_DEFAULT_HAL->cursor_visibility(visible);
+}
+
+/**
+ * Put a character at the cursor and move the cursor on.
+ * @param ctx   the display
+ * @param chr   the character
+ */
+DEASPLAY_INLINE void display_put_char(t_deasplay *ctx, uint8_t chr)
+{
+    /* add char to buffer */
+    if (ctx->buffer[ctx->status.index] != chr)
+    {
+        ctx->buffer[ctx->status.index] = chr;
+        display_mark_line(ctx, ctx->status.line);
+    }
+    /* advance the cursor */
+    display_advance_cursor_impl(ctx, 1U);
+}
+
+DEASPLAY_INLINE void display_write_char_impl(t_deasplay *ctx, uint8_t chr)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        uint32_t args[1] = { chr };
+
+        display_trace_api(ctx, DISPLAY_TRACE_API_CHAR, args, 1U, NULL, 0U);
+    }
+#endif
+    display_put_char(ctx, chr);
+}
+
+void display_write_char_ctx(t_deasplay *ctx, uint8_t chr)
+{
+    display_write_char_impl(ctx, chr);
+}
+
+void display_write_char(uint8_t chr)
+{
+    display_write_char_impl(&display_default, chr);
+}
+
+DEASPLAY_INLINE void display_write_string_impl(t_deasplay *ctx, char *str)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL)
+    {
+        size_t len = strlen(str);
+        uint32_t args[1] = { (uint32_t)len };
+
+        display_trace_api(ctx, DISPLAY_TRACE_API_STRING, args, 1U, (const uint8_t*)str, len);
+    }
+#endif
+    while (*str != '\0')
+    {
+        /* add char to buffer */
+        display_put_char(ctx, (uint8_t)*str);
+        str++;
+    }
+}
+
+void display_write_string_ctx(t_deasplay *ctx, char *str)
+{
+    display_write_string_impl(ctx, str);
+}
+
+void display_write_string(char *str)
+{
+    display_write_string_impl(&display_default, str);
+}
+
+#ifdef DISPLAY_HAS_UTF8
+void display_write_utf8_ctx(t_deasplay *ctx, const char *str)
+{
+    t_codepage page;
+    uint8_t chr;
+
+    if (ctx->hal->codepage == NULL)
+    {
+        display_write_string_ctx(ctx, (char*)str);
+        return;
+    }
+
+    /* the descriptor is read once, then every character is three table loads */
+    codepage_load(&page, ctx->hal->codepage);
+    while (*str != '\0')
+    {
+        str = codepage_next(&page, str, &chr);
+        display_write_char_ctx(ctx, chr);
+    }
+}
+
+void display_write_utf8(const char *str)
+{
+    display_write_utf8_ctx(&display_default, str);
+}
+#endif
+
+#ifdef DISPLAY_HAS_PRINTF
+static void display_write_vstringf(t_deasplay *ctx, char *fmt, va_list va)
+{
+    vsnprintf(snprintf_buf, sizeof(snprintf_buf), fmt, va);
+    display_write_string_ctx(ctx, snprintf_buf);
+}
+
+void display_write_stringf_ctx(t_deasplay *ctx, char *fmt, ...)
+{
+    va_list va;
+    va_start(va,fmt);
+    display_write_vstringf(ctx, fmt, va);
+    va_end(va);
+}
+#endif
+
+void display_write_stringf(char *fmt, ...)
+{
+#ifdef DISPLAY_HAS_PRINTF
+    va_list va;
+    va_start(va,fmt);
+    display_write_vstringf(&display_default, fmt, va);
+    va_end(va);
+#else
+    (void)fmt;
+#endif
+}
+
+/* Number formatting: the digits are produced from the last one, two at a
+ * time, straight into the buffer. Divisions by constants are replaced with
+ * multiplications by their reciprocal, exact over the whole range: 16-bit
+ * values keep to 32-bit products, which matters on 8-bit targets. Larger
+ * values take a 64-bit product, except on AVR where shifts and adds are
+ * much cheaper than the library multiplication. */
+
+/* "00" to "99" */
+static const char display_digit_pairs[200] DEASPLAY_ROM =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char display_hex_digits[16] DEASPLAY_ROM = "0123456789ABCDEF";
+
+static uint32_t display_div10(uint32_t v)
+{
+#ifdef __AVR
+    uint32_t q;
+    uint32_t r;
+#endif
+
+    if (v <= 0xFFFFU) return (v * 52429U) >> 19;
+#ifdef __AVR
+    /* v * 0.8 by shifts and adds, divided by 8, then corrected by the
+     * remainder (Hacker's Delight, divu10) */
+    q = (v >> 1) + (v >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    r = v - (((q << 2) + q) << 1);
+    return q + ((r > 9U) ? 1U : 0U);
+#else
+    return (uint32_t)(((uint64_t)v * 0xCCCCCCCDU) >> 35);
+#endif
+}
+
+static uint32_t display_div100(uint32_t v)
+{
+    /* v / 4 / 25 */
+    if (v <= 0xFFFFU) return ((v >> 2) * 5243U) >> 17;
+#ifdef __AVR
+    return display_div10(display_div10(v));
+#else
+    return (uint32_t)(((uint64_t)v * 0x51EB851FU) >> 37);
+#endif
+}
+
+/**
+ * Count the decimal digits of a value.
+ * @param v     the value
+ * @return the number of digits (1 for 0)
+ */
+static uint8_t display_count_digits(uint32_t v)
+{
+    uint8_t n = 1U;
+    uint32_t p = 10U;
+
+    while (v >= p)
+    {
+        n++;
+        if (n == 10U) break;
+        p *= 10U;
+    }
+
+    return n;
+}
+
+/**
+ * Put a character of a number, going from its last character backwards.
+ * Past the end of the buffer only the last character of the number is
+ * kept, in the last cell.
+ * @param ctx   the display
+ * @param pos   position after the character, moved onto it
+ * @param end   position of the last character of the number
+ * @param last  the last cell of the buffer
+ * @param c     the character
+ * @return true if the cell changed
+ */
+DEASPLAY_INLINE bool display_put_digit(t_deasplay *ctx, deasplay_index_t *pos, deasplay_index_t end, deasplay_index_t last, char c)
+{
+    uint8_t *cell;
+
+    (*pos)--;
+    if ((*pos >= last) && (*pos != end)) return false;
+
+    cell = &ctx->buffer[(*pos < last) ? *pos : last];
+    if (*cell == (uint8_t)c) return false;
+    *cell = (uint8_t)c;
+
+    return true;
+}
+
+/**
+ * Write a formatted number at the cursor.
+ * @param ctx       the display
+ * @param mag       magnitude of the number
+ * @param negative  the number is negative
+ * @param hex       hexadecimal instead of decimal
+ * @param fmt       the format (NULL: as many digits as needed)
+ */
+static void display_write_formatted(t_deasplay *ctx, uint32_t mag, bool negative, bool hex, const t_display_format *fmt)
+{
+    static const t_display_format plain = { 0U, 0U, ' ', DISPLAY_ALIGN_RIGHT };
+    uint8_t decimals;
+    uint8_t digits;
+    uint8_t count;
+    uint8_t fill;
+    uint8_t len;
+    uint8_t r;
+    uint32_t q;
+    char pad;
+    deasplay_index_t start;
+    deasplay_index_t last;
+    deasplay_index_t end;
+    deasplay_index_t pos;
+    deasplay_index_t line;
+    bool changed = false;
+
+    if (fmt == NULL) fmt = &plain;
+    pad = (fmt->pad != '\0') ? fmt->pad : ' ';
+    decimals = hex ? 0U : fmt->decimals;
+
+    /* field layout: [fill] [sign] [digits, with a point before the decimals] [fill] */
+    if (hex)
+    {
+        digits = 1U;
+        for (q = mag >> 4; q != 0U; q >>= 4) digits++;
+    }
+    else
+    {
+        digits = display_count_digits(mag);
+    }
+    if ((decimals != 0U) && (digits <= decimals)) digits = decimals + 1U;
+
+    len = digits + ((decimals != 0U) ? 1U : 0U) + (negative ? 1U : 0U);
+    fill = (fmt->width > len) ? (uint8_t)(fmt->width - len) : 0U;
+    if ((fmt->align == DISPLAY_ALIGN_RIGHT) && (pad == '0'))
+    {
+        /* zero padding goes between the sign and the digits */
+        digits += fill;
+        fill = 0U;
+    }
+
+    if (fmt->align == DISPLAY_ALIGN_RIGHT)
+    {
+        for (count = 0; count < fill; count++) display_put_char(ctx, (uint8_t)pad);
+    }
+    if (negative) display_put_char(ctx, '-');
 
-#include "deasplay.h"
+    /* the digits, from the last one; past the end of the buffer only the
+     * last character stays, as the cursor does not go any further */
+    len = digits + ((decimals != 0U) ? 1U : 0U);
+    start = ctx->status.index;
+    last = DISPLAY_CTX_ELEMENTS(ctx) - 1U;
+    pos = start + len;
+    end = start + len - 1U;
 
-#ifdef HAS_BITMAP
+    count = 0U;
+    while (count < digits)
+    {
+        if ((count == decimals) && (decimals != 0U)) changed |= display_put_digit(ctx, &pos, end, last, '.');
 
-/* font size depends on character */
-#define font_x  (8U)
-#define font_y  (8U)
+        if (hex)
+        {
+            changed |= display_put_digit(ctx, &pos, end, last, DEASPLAY_ROM_BYTE(&display_hex_digits[mag & 0x0FU]));
+            mag >>= 4;
+            count++;
+        }
+        else if (((uint8_t)(digits - count) >= 2U) && ((count + 1U) != decimals))
+        {
+            q = display_div100(mag);
+            r = (uint8_t)(mag - (q * 100U));
+            changed |= display_put_digit(ctx, &pos, end, last, DEASPLAY_ROM_BYTE(&display_digit_pairs[(2U * r) + 1U]));
+            changed |= display_put_digit(ctx, &pos, end, last, DEASPLAY_ROM_BYTE(&display_digit_pairs[2U * r]));
+            mag = q;
+            count += 2U;
+        }
+        else
+        {
+            q = display_div10(mag);
+            changed |= display_put_digit(ctx, &pos, end, last, (char)('0' + (uint8_t)(mag - (q * 10U))));
+            mag = q;
+            count++;
+        }
+    }
 
-#else
+    if (changed)
+    {
+        /* flag every line the digits landed on */
+        if (end < last) last = end;
+        for (line = ctx->status.line; (line * DISPLAY_CTX_CHARS(ctx)) <= last; line++)
+        {
+            display_mark_line(ctx, line);
+        }
+    }
+    display_advance_cursor_ctx(ctx, len);
+
+    if (fmt->align == DISPLAY_ALIGN_LEFT)
+    {
+        if (pad == '0') pad = ' ';
+        for (count = 0; count < fill; count++) display_put_char(ctx, (uint8_t)pad);
+    }
+}
 
-/* character dsplay, consider 1x1 font */
-#define font_x  (1U)
-#define font_y  (1U)
+void display_write_int_ctx(t_deasplay *ctx, int32_t value, const t_display_format *fmt)
+{
+    /* the magnitude of INT32_MIN only fits the unsigned type */
+    uint32_t mag = (value < 0) ? (0U - (uint32_t)value) : (uint32_t)value;
 
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_number(ctx, mag, (value < 0), false, fmt);
 #endif
+    display_write_formatted(ctx, mag, (value < 0), false, fmt);
+}
 
-#define DEASPLAY_BUFFER_ELEMENTS        ((DEASPLAY_LINES / font_y) * (DEASPLAY_CHARS / font_x))
-#define DEASPLAY_BUFFER_INDEX_MAX       (DEASPLAY_BUFFER_ELEMENTS - 1U)
-
-static t_display_status display_status;
-static t_display_elem   display_buffer[DEASPLAY_BUFFER_ELEMENTS];
+void display_write_int(int32_t value, const t_display_format *fmt)
+{
+    display_write_int_ctx(&display_default, value, fmt);
+}
 
-#ifdef DISPLAY_HAS_PRINTF
-static char snprintf_buf[DEASPLAY_BUFFER_ELEMENTS];
+void display_write_uint_ctx(t_deasplay *ctx, uint32_t value, const t_display_format *fmt)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_number(ctx, value, false, false, fmt);
 #endif
+    display_write_formatted(ctx, value, false, false, fmt);
+}
 
-#ifdef HAS_BITMAP
-#include "bitmap.h"
+void display_write_uint(uint32_t value, const t_display_format *fmt)
+{
+    display_write_uint_ctx(&display_default, value, fmt);
+}
+
+void display_write_hex_ctx(t_deasplay *ctx, uint32_t value, const t_display_format *fmt)
+{
+#ifdef DISPLAY_HAS_TRACE
+    if (ctx->trace != NULL) display_trace_number(ctx, value, false, true, fmt);
 #endif
+    display_write_formatted(ctx, value, false, true, fmt);
+}
 
-void display_init(void)
+void display_write_hex(uint32_t value, const t_display_format *fmt)
 {
-    deasplay_hal_init();
-    display_set_cursor(0, 0);
-    deasplay_hal_state_callback(DEASPLAY_STATE_INIT);
+    display_write_hex_ctx(&display_default, value, fmt);
 }
 
-void display_power(e_deasplay_power state)
+#ifdef DISPLAY_HAS_FIELDS
+/**
+ * Read the value of a field.
+ * @param field the field
+ * @return the value, converted to uint32_t
+ */
+static uint32_t display_field_value(const t_display_field *field)
 {
-    deasplay_hal_power(state);
+    bool sign = (field->kind == DISPLAY_FIELD_SIGNED);
+
+    if (field->get != NULL) return field->get();
+
+    switch (field->size)
+    {
+        case 1U:
+            return sign ? (uint32_t)(int32_t)*(const volatile int8_t*)field->source : *(const volatile uint8_t*)field->source;
+        case 2U:
+            return sign ? (uint32_t)(int32_t)*(const volatile int16_t*)field->source : *(const volatile uint16_t*)field->source;
+        default:
+            return *(const volatile uint32_t*)field->source;
+    }
 }
 
-void display_clear(void)
+/**
+ * Render the fields whose value differs from the one last rendered.
+ * The cursor of the application is left untouched.
+ * @param ctx   the display
+ */
+static void display_fields_update(t_deasplay *ctx)
 {
-    deasplay_index_t i;
+    t_display_field *field;
+    deasplay_index_t index = ctx->status.index;
+    deasplay_index_t line = ctx->status.line;
+    deasplay_index_t len;
+    uint32_t value;
+    int32_t sv;
 
-    for (i = 0; i < DEASPLAY_BUFFER_ELEMENTS; i++)
+    for (field = ctx->fields; field != NULL; field = field->next)
     {
-        display_buffer[i].character = (uint8_t)' ';          /* space in the current buffer */
-        display_buffer[i].character_prev = (uint8_t)'\0';    /* zero the previous buffer to force a complete redraw */
+        value = display_field_value(field);
+        if (field->valid && (value == field->cache)) continue;
+
+        display_set_cursor_ctx(ctx, field->line, field->chr);
+        len = ctx->status.index;
+        if (field->kind == DISPLAY_FIELD_SIGNED)
+        {
+            sv = (int32_t)value;
+            display_write_formatted(ctx, (sv < 0) ? (0U - value) : value, (sv < 0), false, &field->format);
+        }
+        else
+        {
+            display_write_formatted(ctx, value, false, (field->kind == DISPLAY_FIELD_HEX), &field->format);
+        }
+        len = ctx->status.index - len;
+
+        /* blank what a longer previous value left behind */
+        while (len < field->len)
+        {
+            display_put_char(ctx, ' ');
+            len++;
+        }
+
+        field->len = (uint8_t)len;
+        field->cache = value;
+        field->valid = true;
     }
 
+    ctx->status.index = index;
+    ctx->status.line = line;
 }
 
-void display_clean(void)
+void display_field_add_ctx(t_deasplay *ctx, t_display_field *field)
 {
-    deasplay_index_t i;
+    field->valid = false;
+    field->len = 0U;
+    field->next = ctx->fields;
+    ctx->fields = field;
+}
+
+void display_field_add(t_display_field *field)
+{
+    display_field_add_ctx(&display_default, field);
+}
+
+void display_field_remove_ctx(t_deasplay *ctx, t_display_field *field)
+{
+    t_display_field **link;
 
-    for (i = 0; i < DEASPLAY_BUFFER_ELEMENTS; i++)
+    for (link = &ctx->fields; *link != NULL; link = &(*link)->next)
     {
-        display_buffer[i].character = (uint8_t)' ';          /* space in the current buffer */
+        if (*link == field)
+        {
+            *link = field->next;
+            break;
+        }
     }
 }
 
-void display_periodic(void)
+void display_field_remove(t_display_field *field)
 {
-    deasplay_index_t i;
-    deasplay_index_t line = 0U;
-    deasplay_index_t chr = 0U;
-    uint8_t* b;
+    display_field_remove_ctx(&display_default, field);
+}
+#endif
+
+void display_write_number_ctx(t_deasplay *ctx, uint16_t number, bool leading_zeros)
+{
+    t_display_format fmt = { 0U, 0U, '0', DISPLAY_ALIGN_RIGHT };
+
+    /* leading zeros: all the five digits a 16-bit number may have */
+    if (leading_zeros == true) fmt.width = 5U;
+    display_write_uint_ctx(ctx, number, &fmt);
+}
+
+void display_write_number(uint16_t number, bool leading_zeros)
+{
+    display_write_number_ctx(&display_default, number, leading_zeros);
+}
 
-    deasplay_hal_state_callback(DEASPLAY_STATE_PERIODIC_START);
-    for (i = 0; i < DEASPLAY_BUFFER_ELEMENTS; i++)
+DEASPLAY_INLINE bool display_set_extended_impl(t_deasplay *ctx, const t_deasplay_hal *hal, uint8_t id, uint8_t *data, uint8_t len)
+{
+#ifdef DISPLAY_HAS_ASYNC
+    if (DEASPLAY_ASYNC(ctx))
     {
-        if (display_buffer[i].character != display_buffer[i].character_prev)
-        {
-            display_buffer[i].character_prev = display_buffer[i].character;
-            deasplay_hal_set_cursor(line, chr);
+        if (display_async_extended(ctx, hal, id, data, len) == false) return false;
+    }
+    else
+#endif
+    {
+        hal->set_extended(id, data, len);
+    }
+    /* the address counter has been moved away from the display data */
+    ctx->status.hw_valid = false;
+
+    return true;
+}
+
+bool display_set_extended_ctx(t_deasplay *ctx, uint8_t id, uint8_t *data, uint8_t len)
+{
+    return display_set_extended_impl(ctx, ctx->hal, id, data, len);
+}
+
+bool display_set_extended(uint8_t id, uint8_t *data, uint8_t len)
+{
+    return display_set_extended_impl(&display_default, DISPLAY_DEFAULT_HAL, id, data, len);
+}
+
+uint8_t* display_get_buffer_ctx(t_deasplay *ctx)
+{
+    return (ctx->hal->get_buffer != NULL) ? ctx->hal->get_buffer() : NULL;
+}
+
+uint8_t* display_get_buffer(void)
+{
 #ifdef HAS_BITMAP
+    return bitmap_buffer;
+#else
+    return NULL;
+#endif
+}
 
-            /* pass the character to the bitmap layer */
-            b = display_get_buffer();
+void display_write_buffer_ctx(t_deasplay *ctx, deasplay_coord_t x_rect, deasplay_coord_t y_rect)
+{
+    if (ctx->hal->write_buffer != NULL)
+    {
+        ctx->hal->write_buffer(x_rect, y_rect);
+    }
+    else
+    {
+        /* character displays draw bitmaps with display_write_bitmap(),
+         * through the customized character set (DISPLAY_HAS_CGRAM) */
+    }
+}
+
+void display_write_buffer(deasplay_coord_t x_rect, deasplay_coord_t y_rect)
+{
+#ifdef HAS_BITMAP
+    display_hal_write_buffer(x_rect, y_rect);
+#else
+    (void)x_rect;
+    (void)y_rect;
+    /* character displays draw bitmaps with display_write_bitmap(),
+     * through the customized character set (DISPLAY_HAS_CGRAM) */
+#endif
+}
 
-            uint16_t pos = chr * (font_x); /* font spacing */
-            pos += line * DEASPLAY_CHARS;
+void display_mark_dirty_ctx(t_deasplay *ctx, deasplay_coord_t x, deasplay_coord_t y, deasplay_coord_t w, deasplay_coord_t h)
+{
+#ifdef HAS_BITMAP
+    uint32_t last;
+    deasplay_coord_t page;
+    bool newly_dirty = false;
 
-            /* fetch the character */
-            bitmap_character(display_buffer[i].character, &b[pos], 8U, FONT_5x8);
+    if ((ctx->hal->get_buffer == NULL) || (w == 0U) || (h == 0U) || (x >= DISPLAY_CTX_WIDTH(ctx))) return;
+
+    /* clip against the panel */
+    if (w > (DISPLAY_CTX_WIDTH(ctx) - x)) w = DISPLAY_CTX_WIDTH(ctx) - x;
+    last = ((uint32_t)y + h - 1U) / 8U;
+    if (last >= DISPLAY_CTX_LINES(ctx)) last = DISPLAY_CTX_LINES(ctx) - 1U;
+
+    for (page = y / 8U; page <= last; page++)
+    {
+        if (display_mark_span(ctx, page, x, w)) newly_dirty = true;
+    }
+
+    /* wake up display_periodic() */
+    if (newly_dirty) display_touch(ctx);
 #else
-            /* pass the command directly to the hardware driver */
-            (void)b;
-            deasplay_hal_write_char(display_buffer[i].character);
+    (void)ctx;
+    (void)x;
+    (void)y;
+    (void)w;
+    (void)h;
 #endif
-        }
-        chr++;
+}
+
+void display_mark_dirty(deasplay_coord_t x, deasplay_coord_t y, deasplay_coord_t w, deasplay_coord_t h)
+{
+    display_mark_dirty_ctx(&display_default, x, y, w, h);
+}
+
+#ifdef DISPLAY_HAS_STATS
+void display_get_stats_ctx(t_deasplay *ctx, t_display_stats *stats)
+{
+    *stats = ctx->stats;
+    stats->time_avg = (stats->refreshes != 0U) ? (stats->time_total / stats->refreshes) : 0U;
+}
+
+void display_get_stats(t_display_stats *stats)
+{
+    display_get_stats_ctx(&display_default, stats);
+}
+
+void display_reset_stats_ctx(t_deasplay *ctx)
+{
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
+
+void display_reset_stats(void)
+{
+    display_reset_stats_ctx(&display_default);
+}
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+void display_set_async_ctx(t_deasplay *ctx, uint8_t *queue0, uint8_t *queue1, size_t size)
+{
+    ctx->async.queue[0] = queue0;
+    ctx->async.queue[1] = queue1;
+    ctx->async.size = size;
+    ctx->async.used = 0U;
+    ctx->async.fill = 0U;
+    __atomic_store_n(&ctx->async.busy, false, __ATOMIC_RELEASE);
+}
+
+void display_set_async(uint8_t *queue0, uint8_t *queue1, size_t size)
+{
+    display_set_async_ctx(&display_default, queue0, queue1, size);
+}
+
+void display_async_complete_ctx(t_deasplay *ctx)
+{
+    /* may run in interrupt context: nothing else is touched */
+    __atomic_store_n(&ctx->async.busy, false, __ATOMIC_RELEASE);
+}
+
+void display_async_complete(void)
+{
+    display_async_complete_ctx(&display_default);
+}
+
+/**
+ * Read an operation of a transfer queue.
+ * @param pos   the operation
+ * @param op    its header
+ * @return its data; the next operation starts op->len bytes further
+ */
+uint8_t* display_async_decode(uint8_t *pos, t_deasplay_async_op *op)
+{
+    memcpy(op, pos, sizeof(t_deasplay_async_op));
+    return &pos[sizeof(t_deasplay_async_op)];
+}
+
+/**
+ * Execute a transfer queue through the driver entry points,
+ * e.g. from the worker thread of a hosted driver.
+ * @param hal   the driver
+ * @param queue the queue
+ * @param len   its length in bytes
+ */
+void display_async_replay(const t_deasplay_hal *hal, uint8_t *queue, size_t len)
+{
+    t_deasplay_async_op op;
+    uint8_t *pos = queue;
+    uint8_t *end = &queue[len];
+    uint8_t *data;
+    deasplay_coord_t i;
 
-        if (chr >= (DEASPLAY_CHARS/(font_x)))
+    while (pos < end)
+    {
+        data = display_async_decode(pos, &op);
+        switch (op.op)
         {
-            chr = 0;
-            line++;
+            case DEASPLAY_ASYNC_CURSOR:
+                hal->set_cursor(op.a, op.b);
+                break;
+            case DEASPLAY_ASYNC_RUN:
+                if (hal->write_run != NULL)
+                {
+                    hal->write_run(op.a, op.b, data, op.len);
+                }
+                else
+                {
+                    for (i = 0; i < op.len; i++)
+                    {
+                        hal->write_char(data[i]);
+                    }
+                }
+                break;
+            case DEASPLAY_ASYNC_SPAN:
+                hal->write_span(op.a, op.b, data, op.len);
+                break;
+            case DEASPLAY_ASYNC_EXTENDED:
+                hal->set_extended((uint8_t)op.a, data, (uint8_t)op.len);
+                break;
+            case DEASPLAY_ASYNC_STATE:
+                if (hal->state_callback != NULL) hal->state_callback((e_deasplay_state)op.a);
+                break;
+            default:
+                break;
         }
+        pos = &data[op.len];
     }
-    deasplay_hal_state_callback(DEASPLAY_STATE_PERIODIC_END);
+}
+#endif
+
+#ifdef DISPLAY_HAS_RING
+bool display_ring_write_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, const uint8_t *data, deasplay_index_t len)
+{
+    return display_ring_put(ctx, line, chr, data, len);
+}
+
+bool display_ring_write(deasplay_coord_t line, deasplay_coord_t chr, const uint8_t *data, deasplay_index_t len)
+{
+    return display_ring_write_ctx(&display_default, line, chr, data, len);
+}
 
+bool display_ring_write_string_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, const char *str)
+{
+    return display_ring_write_ctx(ctx, line, chr, (const uint8_t*)str, (deasplay_index_t)strlen(str));
 }
 
-void display_set_cursor(uint8_t line, uint8_t chr)
+bool display_ring_write_string(deasplay_coord_t line, deasplay_coord_t chr, const char *str)
 {
-    display_status.index = ((deasplay_index_t)line * (deasplay_index_t)((DEASPLAY_CHARS / font_x))) + (deasplay_index_t)chr;
+    return display_ring_write_string_ctx(&display_default, line, chr, str);
 }
+#endif
 
-void display_advance_cursor(uint8_t num)
+#ifdef DISPLAY_HAS_CGRAM
+/**
+ * Forget the custom characters: none is in use.
+ * @param ctx   the display
+ */
+static void display_cgram_reset(t_deasplay *ctx)
 {
-    if ((DEASPLAY_BUFFER_INDEX_MAX - display_status.index) > (deasplay_index_t)num)
+    uint8_t i;
+
+    for (i = 0; i < DEASPLAY_CGRAM_SLOTS; i++)
     {
-        display_status.index += num;
+        ctx->cgram.order[i] = i;
     }
-    else
+    ctx->cgram.used = 0U;
+    ctx->cgram.pending = 0U;
+}
+
+/**
+ * Send the slots whose glyph changed to the driver.
+ * @param ctx   the display
+ * @param hal   its driver
+ * @param work  what the refresh is allowed to do (charged, never refused)
+ * @return false if the transfer queues are taken (DISPLAY_HAS_ASYNC): the
+ *         slots left are uploaded by the next refresh call
+ */
+static bool display_cgram_upload(t_deasplay *ctx, const t_deasplay_hal *hal, t_display_work *work)
+{
+    uint8_t slot;
+
+    for (slot = 0; slot < DEASPLAY_CGRAM_SLOTS; slot++)
     {
-        display_status.index = DEASPLAY_BUFFER_INDEX_MAX;
+        if ((ctx->cgram.pending & (1U << slot)) != 0U)
+        {
+            if (display_set_extended_impl(ctx, hal, slot, ctx->cgram.rows[slot], DEASPLAY_CGRAM_ROWS) == false)
+            {
+                work->spent = true;
+                return false;
+            }
+            ctx->cgram.pending &= (uint8_t)~(1U << slot);
+            display_work_take(work, DEASPLAY_CGRAM_ROWS);
+            DEASPLAY_STAT_ADD(ctx, glyph_uploads, 1U);
+        }
     }
+
+    return true;
 }
 
-void display_enable_cursor(bool visible)
+/**
+ * Hash of a glyph, to tell most glyphs apart without comparing them.
+ */
+static uint8_t display_cgram_hash(const uint8_t *rows)
 {
-    deasplay_hal_cursor_visibility(visible);
+    uint8_t hash = 0U;
+    uint8_t r;
+
+    for (r = 0; r < DEASPLAY_CGRAM_ROWS; r++)
+    {
+        hash = (uint8_t)((uint8_t)((hash << 1) | (hash >> 7)) ^ rows[r]);
+    }
+
+    return hash;
 }
 
-void display_write_char(uint8_t chr)
+/**
+ * Make a slot the most recently used.
+ * @param ctx   the display
+ * @param i     position of the slot in the order
+ */
+static void display_cgram_touch(t_deasplay *ctx, uint8_t i)
 {
-    /* add char to buffer */
-    display_buffer[display_status.index].character = chr;
-    /* advance the cursor */
-    display_advance_cursor(1U);
+    uint8_t slot = ctx->cgram.order[i];
+
+    memmove(&ctx->cgram.order[1], &ctx->cgram.order[0], i);
+    ctx->cgram.order[0] = slot;
 }
 
-void display_write_string(char *str)
+bool display_glyph_code_ctx(t_deasplay *ctx, const uint8_t *rows, uint8_t *code)
 {
-    while (*str != '\0')
+    t_deasplay_cgram *cgram = &ctx->cgram;
+    uint8_t hash = display_cgram_hash(rows);
+    uint8_t on_screen = 0U;
+    uint8_t slot;
+    uint8_t i;
+    uint8_t c;
+    deasplay_index_t k;
+
+    /* an identical glyph shares its slot */
+    for (i = 0; i < DEASPLAY_CGRAM_SLOTS; i++)
     {
-        /* add char to buffer */
-        display_write_char(*str);
-        str++;
+        slot = cgram->order[i];
+        if (((cgram->used & (1U << slot)) != 0U) && (cgram->hash[slot] == hash) &&
+            (memcmp(cgram->rows[slot], rows, DEASPLAY_CGRAM_ROWS) == 0))
+        {
+            display_cgram_touch(ctx, i);
+            *code = (uint8_t)(DEASPLAY_CGRAM_BASE + slot);
+            return true;
+        }
+    }
+
+    /* slots shown by the buffer cannot change */
+    for (k = 0; k < DISPLAY_CTX_ELEMENTS(ctx); k++)
+    {
+        c = ctx->buffer[k];
+        if ((c >= DEASPLAY_CGRAM_BASE) && (c < (DEASPLAY_CGRAM_BASE + DEASPLAY_CGRAM_SLOTS)))
+        {
+            on_screen |= (uint8_t)(1U << (c - DEASPLAY_CGRAM_BASE));
+        }
+    }
+
+    /* take the least recently used of the others */
+    for (i = DEASPLAY_CGRAM_SLOTS; i > 0U; i--)
+    {
+        slot = cgram->order[i - 1U];
+        if ((on_screen & (1U << slot)) == 0U)
+        {
+            memcpy(cgram->rows[slot], rows, DEASPLAY_CGRAM_ROWS);
+            cgram->hash[slot] = hash;
+            cgram->used |= (uint8_t)(1U << slot);
+            cgram->pending |= (uint8_t)(1U << slot);
+            display_cgram_touch(ctx, (uint8_t)(i - 1U));
+            *code = (uint8_t)(DEASPLAY_CGRAM_BASE + slot);
+            return true;
+        }
     }
+
+    return false;
 }
 
-void display_write_stringf(char *fmt, ...)
+bool display_glyph_code(const uint8_t *rows, uint8_t *code)
 {
-#ifdef DISPLAY_HAS_PRINTF
-    va_list va;
-    va_start(va,fmt);
-    vsnprintf(snprintf_buf, sizeof(snprintf_buf), fmt, va);
-    va_end(va);
-    display_write_string(snprintf_buf);
-#else
-    (void)fmt;
-#endif
+    return display_glyph_code_ctx(&display_default, rows, code);
 }
 
-void display_write_number(uint16_t number, bool leading_zeros)
+bool display_write_glyph_ctx(t_deasplay *ctx, const uint8_t *rows)
 {
-    bool not_zero = false;
-    uint8_t tmp;
-    uint16_t i = 10000U;
+    uint8_t code;
 
-    do
-    {
-        tmp = (number / i) % 10U;
-        if ((leading_zeros == true) || (tmp != 0U) || (i == 1U)) not_zero = true;
-        if (not_zero == true) display_write_char('0' + tmp);
-        i /= 10U;
-    } while(i != 0U);
+    if (display_glyph_code_ctx(ctx, rows, &code) == false) return false;
+    display_write_char_ctx(ctx, code);
 
+    return true;
 }
 
-void display_set_extended(uint8_t id, uint8_t *data, uint8_t len)
+bool display_write_glyph(const uint8_t *rows)
 {
-    deasplay_hal_set_extended(id, data, len);
+    return display_write_glyph_ctx(&display_default, rows);
 }
 
-uint8_t* display_get_buffer(void)
+bool display_write_bitmap_ctx(t_deasplay *ctx, const uint8_t *bitmap, uint8_t w, uint8_t h)
 {
-#ifdef HAS_BITMAP
-    return bitmap_buffer;
-#else
-    return NULL;
-#endif
+    uint8_t rows[DEASPLAY_CGRAM_ROWS];
+    deasplay_coord_t line = ctx->status.line;
+    deasplay_coord_t chr = (deasplay_coord_t)(ctx->status.index - (line * DISPLAY_CTX_CHARS(ctx)));
+    uint16_t cells_x = (uint16_t)((w + DEASPLAY_CGRAM_COLS - 1U) / DEASPLAY_CGRAM_COLS);
+    uint16_t cells_y = (uint16_t)((h + DEASPLAY_CGRAM_ROWS - 1U) / DEASPLAY_CGRAM_ROWS);
+    uint16_t cx;
+    uint16_t cy;
+    uint8_t r;
+    uint8_t x;
+    uint16_t px;
+    uint16_t py;
+    bool ok = true;
+
+    for (cy = 0; (cy < cells_y) && ((line + cy) < DISPLAY_CTX_LINES(ctx)); cy++)
+    {
+        display_set_cursor_ctx(ctx, (deasplay_coord_t)(line + cy), chr);
+        for (cx = 0; (cx < cells_x) && ((chr + cx) < DISPLAY_CTX_CHARS(ctx)); cx++)
+        {
+            /* turn the columns of the cell into rows */
+            for (r = 0; r < DEASPLAY_CGRAM_ROWS; r++)
+            {
+                rows[r] = 0U;
+                py = (uint16_t)((cy * DEASPLAY_CGRAM_ROWS) + r);
+                for (x = 0; x < DEASPLAY_CGRAM_COLS; x++)
+                {
+                    px = (uint16_t)((cx * DEASPLAY_CGRAM_COLS) + x);
+                    /* in the flash memory on AVR, as for bitmap_blit() */
+                    if ((px < w) && (py < h) && ((DEASPLAY_ROM_BYTE(&bitmap[((size_t)(py / 8U) * w) + px]) & (1U << (py % 8U))) != 0U))
+                    {
+                        rows[r] |= (uint8_t)(1U << (DEASPLAY_CGRAM_COLS - 1U - x));
+                    }
+                }
+            }
+            if (display_write_glyph_ctx(ctx, rows) == false)
+            {
+                /* out of slots */
+                display_write_char_ctx(ctx, (uint8_t)' ');
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
 }
 
-void display_write_buffer(uint8_t x_rect, uint8_t y_rect)
+bool display_write_bitmap(const uint8_t *bitmap, uint8_t w, uint8_t h)
 {
-#ifdef HAS_BITMAP
-    display_hal_write_buffer(x_rect, y_rect);
-#else
-    /* a possible future feature is to allow a buffer to be written
-     * to a character display by hacking the customized character set */
-#endif
+    return display_write_bitmap_ctx(&display_default, bitmap, w, h);
 }
+#endif
@@ -38,8 +38,106 @@ extern "C"
 
 #include "deasplay_config.h"
 #include "deasplay_hal.h"
+#ifdef DISPLAY_HAS_UTF8
+#include "codepage.h"
+#endif
+
+#ifdef HAS_BITMAP
+
+/* font size depends on character */
+#define DEASPLAY_FONT_X                 (8U)
+#define DEASPLAY_FONT_Y                 (8U)
+
+#else
+
+/* character dsplay, consider 1x1 font */
+#define DEASPLAY_FONT_X                 (1U)
+#define DEASPLAY_FONT_Y                 (1U)
+
+#endif
+
+#if defined(DISPLAY_HAS_BITMAP_SHADOW) && !defined(HAS_BITMAP)
+#error "DISPLAY_HAS_BITMAP_SHADOW requires HAS_BITMAP"
+#endif
+
+#ifdef DISPLAY_HAS_CGRAM
+/* Custom characters: slots of the controller, code of the first slot and
+ * size of a glyph in pixels. HD44780 repeats its 8 slots at codes 8-15,
+ * which keeps code 0 out of the strings. */
+#ifndef DEASPLAY_CGRAM_SLOTS
+#define DEASPLAY_CGRAM_SLOTS            (8U)
+#endif
+#ifndef DEASPLAY_CGRAM_BASE
+#define DEASPLAY_CGRAM_BASE             (8U)
+#endif
+#ifndef DEASPLAY_CGRAM_COLS
+#define DEASPLAY_CGRAM_COLS             (5U)
+#endif
+#ifndef DEASPLAY_CGRAM_ROWS
+#define DEASPLAY_CGRAM_ROWS             (8U)
+#endif
+#if (DEASPLAY_CGRAM_SLOTS > 8U) || (DEASPLAY_CGRAM_COLS > 8U) || ((DEASPLAY_CGRAM_BASE + DEASPLAY_CGRAM_SLOTS) > 256U)
+#error "DEASPLAY_CGRAM_SLOTS and DEASPLAY_CGRAM_COLS must not exceed 8"
+#endif
+#ifdef HAS_BITMAP
+#error "DISPLAY_HAS_CGRAM applies to character displays"
+#endif
+#endif
+
+#ifdef DISPLAY_HAS_RING
+/* Write ring: number of slots (a power of two) and bytes per slot */
+#ifndef DEASPLAY_RING_SIZE
+#define DEASPLAY_RING_SIZE              (8U)
+#endif
+#ifndef DEASPLAY_RING_DATA
+#define DEASPLAY_RING_DATA              (16U)
+#endif
+#if ((DEASPLAY_RING_SIZE & (DEASPLAY_RING_SIZE - 1U)) != 0U) || (DEASPLAY_RING_DATA > 0xFFU)
+#error "DEASPLAY_RING_SIZE must be a power of two and DEASPLAY_RING_DATA fit a byte"
+#endif
+#endif
 
+#define DEASPLAY_TEXT_LINES             (DEASPLAY_LINES / DEASPLAY_FONT_Y)
+#define DEASPLAY_TEXT_CHARS             (DEASPLAY_CHARS / DEASPLAY_FONT_X)
+#define DEASPLAY_BUFFER_ELEMENTS        (DEASPLAY_TEXT_LINES * DEASPLAY_TEXT_CHARS)
+
+/* Index of a cell in the buffer: unless deasplay_config.h forces one
+ * with DEASPLAY_INDEX_TYPE, the smallest type that fits the geometry is used
+ * so that small (8-bit) targets keep 8-bit arithmetic. */
+#if defined(DEASPLAY_INDEX_TYPE)
+typedef DEASPLAY_INDEX_TYPE deasplay_index_t;
+#elif (DEASPLAY_BUFFER_ELEMENTS <= 0xFFU)
 typedef uint8_t deasplay_index_t;
+#elif (DEASPLAY_BUFFER_ELEMENTS <= 0xFFFFU)
+typedef uint16_t deasplay_index_t;
+#else
+typedef uint32_t deasplay_index_t;
+#endif
+
+/* Coordinate on the display (line, character or pixel),
+ * DEASPLAY_COORD_TYPE in deasplay_config.h forces a type */
+#if defined(DEASPLAY_COORD_TYPE)
+typedef DEASPLAY_COORD_TYPE deasplay_coord_t;
+#elif (DEASPLAY_LINES <= 0xFFU) && (DEASPLAY_CHARS <= 0xFFU)
+typedef uint8_t deasplay_coord_t;
+#else
+typedef uint16_t deasplay_coord_t;
+#endif
+
+/* Word used to compare several cells at once. There is no point
+ * in doing so on 8-bit machines. */
+#if defined(__AVR)
+typedef uint8_t  deasplay_word_t;
+#elif (UINTPTR_MAX > 0xFFFFFFFFU)
+typedef uint64_t deasplay_word_t;
+#else
+typedef uint32_t deasplay_word_t;
+#endif
+
+/** Number of words needed to hold 'cells' cells */
+#define DEASPLAY_WORDS(cells)           (((cells) + sizeof(deasplay_word_t) - 1U) / sizeof(deasplay_word_t))
+/** Number of bytes needed to hold one bit per line */
+#define DEASPLAY_LINE_BYTES(lines)      (((lines) + 7U) / 8U)
 
 #define DEASPLAY_VERSION        0x0200U   /**< Version 2.0 */
 
@@ -54,14 +152,348 @@ typedef enum
 typedef struct
 {
     deasplay_index_t index;     /**< Selected line and character */
+    deasplay_index_t line;      /**< Line of the selected character */
+    deasplay_index_t hw_index;  /**< Position the controller writes to next (auto-increment) */
+    bool hw_valid;              /**< hw_index reflects the controller state */
+    uint16_t generation;        /**< Moved on when the buffer gets dirty after a refresh */
+    uint16_t refreshed;         /**< Generation of the last refresh */
+    bool frame;                 /**< A refresh is in progress (see display_periodic_step()) */
+    bool in_line;               /**< The refresh stopped within resume_line */
+    deasplay_index_t resume_line;   /**< Line the refresh resumes from (bitmap pages follow the lines) */
+    deasplay_index_t resume_index;  /**< Cell the refresh resumes from */
 } t_display_status;
 
-/**< The structure holds the state of a single display element (i.e. a character) */
+/**< Work allowed to one display_periodic_step() call, zero meaning no limit */
+typedef struct
+{
+    uint16_t cells;             /**< Cells compared with the shadow buffer */
+    uint16_t bytes;             /**< Characters or bitmap bytes sent to the driver */
+    uint32_t time;              /**< Duration in hw_timestamp ticks (see DISPLAY_SET_TIMESTAMP) */
+} t_display_budget;
+
+/**< Alignment of a number in its field */
+typedef enum _e_display_align
+{
+    DISPLAY_ALIGN_RIGHT,        /**< Padding before the number */
+    DISPLAY_ALIGN_LEFT          /**< Padding after the number */
+} e_display_align;
+
+/**< How display_write_int(), display_write_uint() and display_write_hex() lay a number out */
+typedef struct
+{
+    uint8_t width;              /**< Minimum number of characters (0: no padding) */
+    uint8_t decimals;           /**< Fixed point: digits after the decimal point (decimal only) */
+    char pad;                   /**< Padding character ('\0': space); right aligned '0' goes after the sign */
+    e_display_align align;      /**< Alignment in the field */
+} t_display_format;
+
+#ifdef DISPLAY_HAS_FIELDS
+/**< How the value of a field is shown */
+typedef enum _e_display_field_kind
+{
+    DISPLAY_FIELD_UNSIGNED,     /**< Unsigned decimal */
+    DISPLAY_FIELD_SIGNED,       /**< Signed decimal */
+    DISPLAY_FIELD_HEX           /**< Hexadecimal */
+} e_display_field_kind;
+
+/**< Reads the value of a field, converted to uint32_t */
+typedef uint32_t (*t_display_field_get)(void);
+
+/**< A number bound to a position of the display (DISPLAY_HAS_FIELDS).
+ * The application fills in the first members and registers it with
+ * display_field_add(); the refresh renders it when the value changes. */
+typedef struct _t_display_field
+{
+    deasplay_coord_t line;      /**< Line of the field */
+    deasplay_coord_t chr;       /**< Column of the field */
+    t_display_format format;    /**< Layout of the number */
+    e_display_field_kind kind;  /**< How the value is shown */
+    const volatile void *source;    /**< The value (when get is NULL) */
+    uint8_t size;               /**< Size of the value in bytes: 1, 2 or 4 */
+    t_display_field_get get;    /**< Optional (NULL): function returning the value */
+    struct _t_display_field *next;  /**< Next field of the display (library) */
+    uint32_t cache;             /**< Value last rendered (library) */
+    uint8_t len;                /**< Characters last rendered (library) */
+    bool valid;                 /**< The buffer shows cache (library) */
+} t_display_field;
+#endif
+
+/**< Performance counters (DISPLAY_HAS_STATS) */
+typedef struct
+{
+    uint32_t refreshes;         /**< Refreshes started */
+    uint32_t refreshes_skipped; /**< Refresh calls with nothing to refresh */
+    uint32_t cells_scanned;     /**< Cells compared with the shadow buffer */
+    uint32_t cells_dirty;       /**< Cells found changed */
+    uint32_t cursor_commands;   /**< Cursor commands sent to the driver */
+    uint32_t bytes_written;     /**< Characters or bitmap bytes sent to the driver */
+    uint32_t glyph_uploads;     /**< Custom characters sent to the driver (DISPLAY_HAS_CGRAM) */
+    uint32_t time_min;          /**< Shortest refresh call (hw_timestamp ticks) */
+    uint32_t time_max;          /**< Longest refresh call (hw_timestamp ticks) */
+    uint32_t time_total;        /**< Sum of all refresh call times (hw_timestamp ticks) */
+    uint32_t time_avg;          /**< Average time per refresh started, computed by display_get_stats() */
+} t_display_stats;
+
+#ifdef DISPLAY_HAS_LAYERS
+/**< Layers, from the bottom up */
+typedef enum _e_display_layer
+{
+    DISPLAY_LAYER_BASE,         /**< Virtual canvas, seen through the viewport */
+    DISPLAY_LAYER_OVERLAY,      /**< Menus and pop-ups */
+    DISPLAY_LAYER_TOAST,        /**< Short notifications */
+    DISPLAY_LAYERS
+} e_display_layer;
+
+/**< Cell of an overlay or toast letting the layers below show through */
+#define DISPLAY_LAYER_CLEAR             ('\0')
+
+/**< Characters of a layer (DISPLAY_HAS_LAYERS), owned by the application.
+ * The base layer may be larger than the display: line and chr are then the
+ * canvas cell at the top left corner of the display (the viewport). Other
+ * layers are placed on the display at line and chr. */
+typedef struct _t_display_layer
+{
+    uint8_t *cells;             /**< lines * chars characters, line after line */
+    deasplay_coord_t lines;     /**< Number of lines */
+    deasplay_coord_t chars;     /**< Number of characters per line */
+    deasplay_coord_t line;      /**< Position (see above) */
+    deasplay_coord_t chr;       /**< Position (see above) */
+    bool visible;               /**< The layer is composited */
+} t_display_layer;
+
+/**< The layers of a display and the cells to be composited again */
+typedef struct
+{
+    t_display_layer *layer[DISPLAY_LAYERS];     /**< Attached layers (NULL: none) */
+    deasplay_coord_t dirty[4];  /**< First line, first character, end line, end character */
+} t_deasplay_layers;
+#endif
+
+#ifdef DISPLAY_HAS_RING
+/**< A positioned write waiting in the ring */
+typedef struct
+{
+    unsigned int seq;           /**< Turn of the slot (see display_ring_write()) */
+    deasplay_coord_t line;      /**< Line of the first character */
+    deasplay_coord_t chr;       /**< Column of the first character */
+    uint8_t len;                /**< Number of characters */
+    uint8_t data[DEASPLAY_RING_DATA];   /**< The characters */
+} t_deasplay_ring_slot;
+
+/**< Multi-producer, single-consumer ring of positioned writes (DISPLAY_HAS_RING) */
+typedef struct
+{
+    t_deasplay_ring_slot slot[DEASPLAY_RING_SIZE];  /**< The writes */
+    unsigned int head;          /**< Next slot claimed by a producer */
+    unsigned int tail;          /**< Next slot drained by the refresh */
+} t_deasplay_ring;
+#endif
+
+#ifdef DISPLAY_HAS_CGRAM
+/**< Custom character slots of a character display (DISPLAY_HAS_CGRAM) */
+typedef struct
+{
+    uint8_t rows[DEASPLAY_CGRAM_SLOTS][DEASPLAY_CGRAM_ROWS];  /**< Glyph of every slot, one byte per row */
+    uint8_t hash[DEASPLAY_CGRAM_SLOTS];     /**< Content hash of every slot */
+    uint8_t order[DEASPLAY_CGRAM_SLOTS];    /**< Slots, most recently used first */
+    uint8_t used;               /**< Slots holding a glyph (bit mask) */
+    uint8_t pending;            /**< Slots to be uploaded by the next refresh (bit mask) */
+} t_deasplay_cgram;
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+/**< Operations of a transfer queue (DISPLAY_HAS_ASYNC) */
+typedef enum _e_deasplay_async_op
+{
+    DEASPLAY_ASYNC_CURSOR,      /**< Place the cursor: a = line, b = character */
+    DEASPLAY_ASYNC_RUN,         /**< Write len characters at the cursor, placed on a = line, b = character */
+    DEASPLAY_ASYNC_SPAN,        /**< Write len bytes of the bitmap page a from column b */
+    DEASPLAY_ASYNC_EXTENDED,    /**< Customized character a (see display_set_extended()), len data bytes */
+    DEASPLAY_ASYNC_STATE        /**< State notification a (e_deasplay_state) of the refresh */
+} e_deasplay_async_op;
+
+/**< Header of an operation in a transfer queue, followed by its len data bytes */
+typedef struct
+{
+    uint8_t op;                 /**< The operation (e_deasplay_async_op) */
+    deasplay_coord_t a;         /**< Line or page */
+    deasplay_coord_t b;         /**< Character or column */
+    deasplay_coord_t len;       /**< Number of data bytes */
+} t_deasplay_async_op;
+
+/**< Double-buffered transfer queues: one is filled by the refresh while
+ * the driver transfers the other one */
 typedef struct
 {
-    uint8_t character;          /**< Active character */
-    uint8_t character_prev;     /**< Last active character */
-} t_display_elem;
+    uint8_t *queue[2];          /**< The two queues (NULL: synchronous refresh) */
+    size_t size;                /**< Capacity of each queue in bytes */
+    size_t used;                /**< Bytes in the queue being filled */
+    uint8_t fill;               /**< Index of the queue being filled */
+    bool busy;                  /**< The other queue is being transferred */
+} t_deasplay_async;
+#endif
+
+/**< The display driver entry points. The default display uses the
+ * deasplay_hal_* functions the driver provides at link time; any further
+ * display is given its own table. */
+typedef struct
+{
+    void (*init)(void);                                         /**< Initialize the hardware */
+    void (*power)(e_deasplay_power state);                      /**< Power (or backlight) control */
+    void (*set_cursor)(deasplay_coord_t line, deasplay_coord_t chr); /**< Place the hardware cursor */
+    void (*write_char)(uint8_t chr);                            /**< Write a character at the cursor */
+    void (*write_run)(deasplay_coord_t line, deasplay_coord_t chr, uint8_t *data, deasplay_index_t len);  /**< Optional (NULL): write several characters */
+    void (*cursor_visibility)(bool visible);                    /**< Show or hide the cursor */
+    void (*set_extended)(uint8_t id, uint8_t *data, uint8_t len);  /**< Customized characters */
+    void (*state_callback)(e_deasplay_state state);             /**< Optional (NULL): state notifications */
+    uint8_t* (*get_buffer)(void);                               /**< Bitmap displays only (NULL otherwise): the bitmap buffer */
+    void (*write_buffer)(deasplay_coord_t x_rect, deasplay_coord_t y_rect);  /**< Bitmap displays only: push the bitmap buffer */
+    void (*write_span)(deasplay_coord_t page, deasplay_coord_t x, uint8_t *data, deasplay_coord_t len);  /**< Optional (NULL), bitmap displays: push part of a page */
+    bool (*scroll)(deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy);  /**< Optional (NULL): shift a window of the panel, false if unable */
+    uint8_t span_overhead;                                      /**< Cost of starting a write_span, in data bytes */
+#ifdef DISPLAY_HAS_UTF8
+    const t_codepage *codepage;                                 /**< Character set of display_write_utf8() (NULL: bytes as they are) */
+#endif
+#ifdef DISPLAY_HAS_ASYNC
+    void (*submit)(uint8_t *queue, size_t len);                 /**< Asynchronous displays: start transferring a queue */
+#endif
+} t_deasplay_hal;
+
+#ifdef DISPLAY_HAS_TRACE
+/**< Records of a trace (DISPLAY_HAS_TRACE). A record is the event byte
+ * followed by its arguments, 16-bit little endian values (flags and the
+ * version: one byte, cell indices and lengths of whole buffers: 32-bit),
+ * then its data bytes if any. */
+typedef enum _e_display_trace_event
+{
+    DISPLAY_TRACE_HEADER,       /**< Version, lines, chars, width, font_x, bitmap (0/1), bitmap shadow (0/1) */
+    DISPLAY_TRACE_KEYFRAME,     /**< Refresh state, dirty lines, buffer and shadow [spans, bitmap, bitmap shadow] */
+    DISPLAY_TRACE_STEP,         /**< A refresh call: budgeted (0: display_periodic()), budget cells, budget bytes */
+    DISPLAY_TRACE_FLUSH,        /**< A display_flush() call */
+    DISPLAY_TRACE_END,          /**< End of the refresh or flush call */
+    DISPLAY_TRACE_DIRTY,        /**< What a refresh pass starts from: pending (0/1), dirty lines [spans] */
+    DISPLAY_TRACE_LINE,         /**< A line as the refresh reads it: line, chr, len, characters */
+    DISPLAY_TRACE_CLEAR,        /**< A display_clear() call */
+    DISPLAY_TRACE_HAL_INIT,     /**< Driver calls, with their arguments... */
+    DISPLAY_TRACE_HAL_POWER,    /**< state */
+    DISPLAY_TRACE_HAL_CURSOR,   /**< line, chr */
+    DISPLAY_TRACE_HAL_CHAR,     /**< character */
+    DISPLAY_TRACE_HAL_RUN,      /**< line, chr, len, characters */
+    DISPLAY_TRACE_HAL_VISIBILITY,   /**< visible (0/1) */
+    DISPLAY_TRACE_HAL_EXTENDED, /**< id, len, data */
+    DISPLAY_TRACE_HAL_BUFFER,   /**< x, y, bytes of the bitmap (32-bit), the bitmap */
+    DISPLAY_TRACE_HAL_SPAN,     /**< page, x, len, bytes */
+    DISPLAY_TRACE_HAL_SCROLL,   /**< line, chr, lines, chars, dx, dy, done (0/1) */
+    DISPLAY_TRACE_HAL_STATE,    /**< e_deasplay_state */
+    DISPLAY_TRACE_HAL_SUBMIT,   /**< bytes (32-bit), the queue */
+    DISPLAY_TRACE_API_CURSOR,   /**< Writes to the buffer (t_display_trace api): display_set_cursor(), line, chr */
+    DISPLAY_TRACE_API_CHAR,     /**< display_write_char(): character */
+    DISPLAY_TRACE_API_STRING,   /**< display_write_string(): len, characters */
+    DISPLAY_TRACE_API_NUMBER,   /**< The number writes: value (32-bit), negative (1) | hex (2), width, decimals, pad, align */
+    DISPLAY_TRACE_API_SCROLL,   /**< display_scroll(): line, chr, lines, chars, dx, dy */
+    DISPLAY_TRACE_CLEAN,        /**< A display_clean() call */
+    DISPLAY_TRACE_EVENTS
+} e_display_trace_event;
+
+#define DISPLAY_TRACE_VERSION           (2U)
+
+/**< Receives the records of a streamed trace (e.g. fwrite() to a file) */
+typedef void (*t_display_trace_write)(const uint8_t *data, size_t len, void *arg);
+
+/**< Where a trace goes: a log in RAM, or a stream when write is set.
+ * The application fills in the first members. */
+typedef struct _t_display_trace
+{
+    uint8_t *data;              /**< RAM log */
+    size_t size;                /**< Size of the RAM log */
+    t_display_trace_write write;    /**< Stream (NULL: RAM log) */
+    void *arg;                  /**< Argument of write */
+    bool api;                   /**< Record the calls writing the buffer as well (DISPLAY_TRACE_API_*) */
+    size_t len;                 /**< Bytes in the RAM log (library) */
+    uint32_t restarts;          /**< Times the RAM log started over (library) */
+    bool full;                  /**< The RAM log starts over with the next refresh (library) */
+    const t_deasplay_hal *hal;  /**< Driver of the traced display (library) */
+} t_display_trace;
+#endif
+
+/**< A display: geometry, buffers, cursor and driver.
+ * Define one with DEASPLAY_CONTEXT_BUFFERS() and DEASPLAY_CONTEXT_INIT(). */
+typedef struct
+{
+    const t_deasplay_hal *hal;  /**< Driver */
+    deasplay_coord_t lines;     /**< Number of text lines */
+    deasplay_coord_t chars;     /**< Number of characters per line */
+    deasplay_coord_t font_x;    /**< Width of a character in pixels (1 on character displays) */
+    deasplay_coord_t width;     /**< Bytes per bitmap page (bitmap displays) */
+    deasplay_index_t elements;  /**< lines * chars */
+    uint8_t *buffer;            /**< Active characters, word aligned */
+    uint8_t *shadow;            /**< Characters as last sent to the display, word aligned */
+    uint8_t *dirty;             /**< One bit per line with pending changes */
+#ifdef HAS_BITMAP
+    deasplay_coord_t *spans;    /**< Bitmap displays: changed columns [x0, x1) of every page */
+#endif
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+    uint8_t *bitmap_shadow;     /**< Bitmap displays: the bitmap as last sent (NULL: none) */
+#endif
+    t_display_status status;    /**< Cursor and refresh state */
+#ifdef DISPLAY_HAS_ASYNC
+    t_deasplay_async async;     /**< Transfer queues (see display_set_async()) */
+#endif
+#ifdef DISPLAY_HAS_RING
+    t_deasplay_ring ring;       /**< Writes from other threads or interrupts */
+#endif
+#ifdef DISPLAY_HAS_FIELDS
+    t_display_field *fields;    /**< Bound fields (see display_field_add()) */
+#endif
+#ifdef DISPLAY_HAS_LAYERS
+    t_deasplay_layers layers;   /**< Composited layers (see display_layer_set()) */
+#endif
+#ifdef DISPLAY_HAS_CGRAM
+    t_deasplay_cgram cgram;     /**< Custom characters (see display_write_glyph()) */
+#endif
+#ifdef DISPLAY_HAS_STATS
+    t_display_stats stats;      /**< Performance counters */
+#endif
+#ifdef DISPLAY_HAS_TRACE
+    t_display_trace *trace;     /**< Trace being recorded (see display_trace_start()) */
+#endif
+} t_deasplay;
+
+#ifdef HAS_BITMAP
+#define DEASPLAY_CONTEXT_BITMAP_BUFFERS(name, lines) \
+    static deasplay_coord_t name##_spans[2U * (lines)];
+#define DEASPLAY_CONTEXT_BITMAP_INIT(name) \
+    .spans = name##_spans,
+#else
+#define DEASPLAY_CONTEXT_BITMAP_BUFFERS(name, lines)
+#define DEASPLAY_CONTEXT_BITMAP_INIT(name)
+#endif
+
+/** Define the (static) buffers of a display context */
+#define DEASPLAY_CONTEXT_BUFFERS(name, lines, chars) \
+    typedef char name##_index_check[((deasplay_index_t)((lines) * (chars)) == ((lines) * (chars))) ? 1 : -1]; \
+    DEASPLAY_CONTEXT_BITMAP_BUFFERS(name, lines) \
+    static deasplay_word_t name##_buffer[DEASPLAY_WORDS((lines) * (chars))]; \
+    static deasplay_word_t name##_shadow[DEASPLAY_WORDS((lines) * (chars))]; \
+    static uint8_t name##_dirty[DEASPLAY_LINE_BYTES(lines)]
+
+/** Initializer of a display context whose buffers have been
+ * defined with DEASPLAY_CONTEXT_BUFFERS().
+ * font_x is 1 for character displays, the character width in pixels
+ * for bitmap displays whose bitmap pages are 'width' bytes long. */
+#define DEASPLAY_CONTEXT_INIT(name, hal_table, text_lines, text_chars, font_w, page_width) \
+{ \
+    .hal = (hal_table), \
+    .lines = (text_lines), \
+    .chars = (text_chars), \
+    .font_x = (font_w), \
+    .width = (page_width), \
+    .elements = (text_lines) * (text_chars), \
+    .buffer = (uint8_t*)name##_buffer, \
+    .shadow = (uint8_t*)name##_shadow, \
+    .dirty = name##_dirty, \
+    DEASPLAY_CONTEXT_BITMAP_INIT(name) \
+}
 
 /* Display APIs */
 void display_init(void);
@@ -69,24 +501,219 @@ void display_power(e_deasplay_power state);
 void display_clear(void);
 void display_clean(void);
 void display_periodic(void);
-void display_set_cursor(uint8_t line, uint8_t chr);
+bool display_periodic_step(const t_display_budget *budget);
+bool display_is_dirty(void);
+void display_set_cursor(deasplay_coord_t line, deasplay_coord_t chr);
 void display_enable_cursor(bool visible);
-void display_advance_cursor(uint8_t num);
+void display_advance_cursor(deasplay_index_t num);
 void display_write_char(uint8_t chr);
 void display_write_string(char *str);
+#ifdef DISPLAY_HAS_UTF8
+void display_write_utf8(const char *str);
+#endif
 void display_write_number(uint16_t number, bool leading_zeros);
+void display_write_int(int32_t value, const t_display_format *fmt);
+void display_write_uint(uint32_t value, const t_display_format *fmt);
+void display_write_hex(uint32_t value, const t_display_format *fmt);
 
 /* Character interface */
-void display_set_extended(uint8_t id, uint8_t *data, uint8_t len);
+bool display_set_extended(uint8_t id, uint8_t *data, uint8_t len);
 
 /* Bitmapped display API */
 uint8_t* display_get_buffer(void);
-void display_write_buffer(uint8_t x_rect, uint8_t y_rect);
+void display_write_buffer(deasplay_coord_t x_rect, deasplay_coord_t y_rect);
+void display_mark_dirty(deasplay_coord_t x, deasplay_coord_t y, deasplay_coord_t w, deasplay_coord_t h);
 
 #ifdef DISPLAY_HAS_PRINTF
 void display_write_stringf(char *fmt, ...);
 #endif
 
+/* Multiple displays: the same APIs, on a given display context */
+t_deasplay* display_get_context(void);
+void display_init_ctx(t_deasplay *ctx);
+void display_power_ctx(t_deasplay *ctx, e_deasplay_power state);
+void display_clear_ctx(t_deasplay *ctx);
+void display_clean_ctx(t_deasplay *ctx);
+void display_periodic_ctx(t_deasplay *ctx);
+bool display_periodic_step_ctx(t_deasplay *ctx, const t_display_budget *budget);
+bool display_is_dirty_ctx(t_deasplay *ctx);
+void display_set_cursor_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr);
+void display_enable_cursor_ctx(t_deasplay *ctx, bool visible);
+void display_advance_cursor_ctx(t_deasplay *ctx, deasplay_index_t num);
+void display_write_char_ctx(t_deasplay *ctx, uint8_t chr);
+void display_write_string_ctx(t_deasplay *ctx, char *str);
+#ifdef DISPLAY_HAS_UTF8
+void display_write_utf8_ctx(t_deasplay *ctx, const char *str);
+#endif
+void display_write_number_ctx(t_deasplay *ctx, uint16_t number, bool leading_zeros);
+void display_write_int_ctx(t_deasplay *ctx, int32_t value, const t_display_format *fmt);
+void display_write_uint_ctx(t_deasplay *ctx, uint32_t value, const t_display_format *fmt);
+void display_write_hex_ctx(t_deasplay *ctx, uint32_t value, const t_display_format *fmt);
+bool display_set_extended_ctx(t_deasplay *ctx, uint8_t id, uint8_t *data, uint8_t len);
+uint8_t* display_get_buffer_ctx(t_deasplay *ctx);
+void display_write_buffer_ctx(t_deasplay *ctx, deasplay_coord_t x_rect, deasplay_coord_t y_rect);
+void display_mark_dirty_ctx(t_deasplay *ctx, deasplay_coord_t x, deasplay_coord_t y, deasplay_coord_t w, deasplay_coord_t h);
+
+#ifdef DISPLAY_HAS_STATS
+/* Performance counters */
+void display_get_stats(t_display_stats *stats);
+void display_reset_stats(void);
+void display_get_stats_ctx(t_deasplay *ctx, t_display_stats *stats);
+void display_reset_stats_ctx(t_deasplay *ctx);
+#endif
+
+#ifdef DISPLAY_HAS_FIELDS
+/* Bound fields: the refresh formats a field again only when its value
+ * changed. display_clear() and display_clean() re-render all of them;
+ * after drawing over a field, call display_fields_invalidate(). */
+void display_field_add(t_display_field *field);
+void display_field_remove(t_display_field *field);
+void display_fields_invalidate(void);
+void display_field_add_ctx(t_deasplay *ctx, t_display_field *field);
+void display_field_remove_ctx(t_deasplay *ctx, t_display_field *field);
+void display_fields_invalidate_ctx(t_deasplay *ctx);
+#endif
+
+#ifdef DISPLAY_HAS_LAYERS
+/* Layers: the refresh composites the visible layers into the buffer, top
+ * layer first, before looking for changes, but only the cells touched by
+ * the calls below since the previous refresh. After changing the cells of
+ * a layer directly, call display_layer_invalidate(). Moving the base layer
+ * scrolls the display when it can (see display_scroll()). Characters
+ * written with display_write_char() and friends stay until the layers are
+ * composited over them again; bound fields are rendered again on top. */
+void display_layer_set(e_display_layer id, t_display_layer *layer);
+void display_layer_show(e_display_layer id, bool visible);
+void display_layer_move(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr);
+void display_layer_write(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, const char *str);
+void display_layer_invalidate(e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars);
+void display_layer_set_ctx(t_deasplay *ctx, e_display_layer id, t_display_layer *layer);
+void display_layer_show_ctx(t_deasplay *ctx, e_display_layer id, bool visible);
+void display_layer_move_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr);
+void display_layer_write_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, const char *str);
+void display_layer_invalidate_ctx(t_deasplay *ctx, e_display_layer id, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars);
+#endif
+
+#ifdef DISPLAY_HAS_TRACE
+/* Tracing: from display_trace_start() on, the refresh calls, the lines as
+ * the refresh reads them and every driver call with its data are recorded,
+ * starting with a key frame of the display state, so that a host tool
+ * (bench/replay.c) can run the refreshes again and compare the output.
+ * A RAM log that fills up starts over, with a new key frame, at the next
+ * refresh: it always holds the latest frames. One display at a time.
+ * With api set, the calls writing the buffer are recorded too (cursor,
+ * characters, strings, numbers, scrolling), so that a replay can run them
+ * again through the API instead of restoring the lines, every key frame
+ * being followed by the cursor position. display_clear() and
+ * display_clean() are always recorded. Other writes (marquees, layers,
+ * bound fields, the write ring, direct access to the buffer) show only in
+ * the lines the refresh reads. */
+void display_trace_start(t_display_trace *trace);
+void display_trace_stop(void);
+void display_trace_start_ctx(t_deasplay *ctx, t_display_trace *trace);
+void display_trace_stop_ctx(t_deasplay *ctx);
+#endif
+
+/**< A line of text scrolling through a window (see display_marquee_start()).
+ * The application fills in the first members. */
+typedef struct _t_display_marquee
+{
+    deasplay_coord_t line;      /**< Line of the window */
+    deasplay_coord_t chr;       /**< First column of the window */
+    deasplay_coord_t chars;     /**< Width of the window */
+    const char *text;           /**< The text, NUL terminated */
+    uint8_t gap;                /**< Blanks between the end of the text and its start again */
+    uint16_t period;            /**< Length of the text plus the gap (library) */
+    uint16_t pos;               /**< Text position at the left edge of the window (library) */
+} t_display_marquee;
+
+/* Scrolling: display_scroll() shifts the characters of a window of the
+ * buffer by dx columns (positive: right) and dy lines (positive: down),
+ * filling the cells uncovered with spaces. When the driver can shift the
+ * same window of the panel (scroll entry of t_deasplay_hal), what has
+ * been sent to the display is shifted as well and the next refresh only
+ * sends the uncovered cells. A marquee scrolls a text longer than its
+ * window by one character per display_marquee_step(). */
+void display_scroll(deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy);
+void display_marquee_start(t_display_marquee *marquee);
+void display_marquee_step(t_display_marquee *marquee);
+void display_scroll_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, deasplay_coord_t lines, deasplay_coord_t chars, int8_t dx, int8_t dy);
+void display_marquee_start_ctx(t_deasplay *ctx, t_display_marquee *marquee);
+void display_marquee_step_ctx(t_deasplay *ctx, t_display_marquee *marquee);
+
+#ifdef DISPLAY_HAS_CGRAM
+/* Custom characters on character displays. A glyph is DEASPLAY_CGRAM_ROWS
+ * bytes, one per row from the top, the leftmost pixel being bit
+ * DEASPLAY_CGRAM_COLS - 1 (the HD44780 layout). Identical glyphs share a
+ * slot; a new glyph takes the least recently used slot no cell of the
+ * buffer shows, and the refresh uploads a slot only when its glyph
+ * changed. display_glyph_code() and the writes return false when all
+ * the slots are on screen. display_write_bitmap() writes a bitmap in the
+ * bitmap_blit() format at the cursor, DEASPLAY_CGRAM_COLS x
+ * DEASPLAY_CGRAM_ROWS pixels per character; as for bitmap_blit(), the
+ * bitmap is read from the flash memory (PROGMEM) on AVR. The glyph rows
+ * of the other calls are in RAM. */
+bool display_glyph_code(const uint8_t *rows, uint8_t *code);
+bool display_write_glyph(const uint8_t *rows);
+bool display_write_bitmap(const uint8_t *bitmap, uint8_t w, uint8_t h);
+bool display_glyph_code_ctx(t_deasplay *ctx, const uint8_t *rows, uint8_t *code);
+bool display_write_glyph_ctx(t_deasplay *ctx, const uint8_t *rows);
+bool display_write_bitmap_ctx(t_deasplay *ctx, const uint8_t *bitmap, uint8_t w, uint8_t h);
+#endif
+
+#ifdef DISPLAY_HAS_RING
+/* Writes from several threads or interrupt handlers: they are queued
+ * without locks and applied to the buffer by the next refresh, in order.
+ * A write takes a slot per DEASPLAY_RING_DATA characters, all queued or
+ * none (false: the ring is full, the write can be retried as it is, and a
+ * write of more than DEASPLAY_RING_SIZE slots never fits); the refresh
+ * applies it whole, never split across frames.
+ * The cursor of the display is not used nor moved. display_init() empties
+ * the ring: no write may be in progress while it runs, so the producers
+ * are started after it (or their interrupts enabled after it). */
+bool display_ring_write(deasplay_coord_t line, deasplay_coord_t chr, const uint8_t *data, deasplay_index_t len);
+bool display_ring_write_string(deasplay_coord_t line, deasplay_coord_t chr, const char *str);
+bool display_ring_write_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, const uint8_t *data, deasplay_index_t len);
+bool display_ring_write_string_ctx(t_deasplay *ctx, deasplay_coord_t line, deasplay_coord_t chr, const char *str);
+#endif
+
+#ifdef DISPLAY_HAS_ASYNC
+/* Asynchronous refresh: once two queues are given, display_periodic() and
+ * display_periodic_step() render the changes into a queue and hand it to
+ * the driver, which transfers it in the background. A queue is handed over
+ * only once the previous one has been transferred; when it fills up the
+ * refresh resumes on the next call. The state notifications of the
+ * refresh (START, PAUSE, RESUME, END) are queued with the operations, so
+ * that the driver gets them in order from display_async_replay() and can
+ * batch its bus transactions (busbatch.h) as when refreshing directly.
+ * Each queue must hold at least four operation headers and one data
+ * byte; display_set_extended() is queued
+ * as well, and returns false rather than waiting when both queues are taken
+ * (to be called again after display_async_complete()). */
+void display_set_async(uint8_t *queue0, uint8_t *queue1, size_t size);
+void display_set_async_ctx(t_deasplay *ctx, uint8_t *queue0, uint8_t *queue1, size_t size);
+void display_async_complete(void);
+void display_async_complete_ctx(t_deasplay *ctx);
+uint8_t* display_async_decode(uint8_t *pos, t_deasplay_async_op *op);
+void display_async_replay(const t_deasplay_hal *hal, uint8_t *queue, size_t len);
+#endif
+
+#ifdef DISPLAY_HAS_BITMAP_SHADOW
+/* Bitmap shadow: anything drawn into the bitmap buffer is found by
+ * comparing it with a copy of what has been sent to the display.
+ * display_flush() pushes the differences at once; display_periodic()
+ * compares the pages only when it has a frame to refresh, so drawing
+ * directly into the buffer is followed by display_flush() (or by
+ * display_mark_dirty() to leave it to the next refresh). */
+void display_flush(void);
+void display_flush_ctx(t_deasplay *ctx);
+void display_set_bitmap_shadow_ctx(t_deasplay *ctx, uint8_t *shadow);
+#endif
+
+#ifdef DISPLAY_HAS_PRINTF
+void display_write_stringf_ctx(t_deasplay *ctx, char *fmt, ...);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
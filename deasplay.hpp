@@ -0,0 +1,403 @@
+/*
+ * deasplay.hpp
+ *
+ *  Header-only C++ front-end: the buffered character interface with its
+ *  geometry, index types and cell metrics fixed at compile time, and the
+ *  driver bound as a policy class whose static functions the compiler
+ *  can inline. Displays of different sizes and drivers coexist in the
+ *  same program, without virtual calls nor deasplay_config.h.
+ *
+ *  Example, the 1x10 LC75710 VFD next to a 2x16 HD44780:
+ *
+ *      struct Vfd : deasplay::HalDefaults<Vfd>
+ *      {
+ *          static void init(void);
+ *          static void set_cursor(uint8_t line, uint8_t chr);
+ *          static void write_char(uint8_t chr);
+ *          static void write_run(uint8_t line, uint8_t chr, const uint8_t *data, uint8_t len);
+ *      };
+ *      struct Lcd : deasplay::HalDefaults<Lcd> { ... };
+ *
+ *      deasplay::Display<1, 10, deasplay::CharacterCell, Vfd> vfd;
+ *      deasplay::Display<2, 16, deasplay::CharacterCell, Lcd> lcd;
+ *
+ *  C++11 or later; it does not depend on the standard C++ library.
+ */
+
+#ifndef DEASPLAY_HPP_
+#define DEASPLAY_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+extern "C"
+{
+#include "deasplay_hal.h"
+}
+
+/* Displays with up to this many lines get their refresh loop unrolled */
+#ifndef DEASPLAY_HPP_UNROLL_LINES
+#define DEASPLAY_HPP_UNROLL_LINES       (4U)
+#endif
+
+namespace deasplay
+{
+
+/**< Then if Cond holds, Else otherwise */
+template <bool Cond, typename Then, typename Else>
+struct select
+{
+    typedef Then type;
+};
+
+template <typename Then, typename Else>
+struct select<false, Then, Else>
+{
+    typedef Else type;
+};
+
+/**< The smallest unsigned type holding Max */
+template <uint32_t Max>
+struct uint_for
+{
+    typedef typename select<(Max <= 0xFFU), uint8_t,
+            typename select<(Max <= 0xFFFFU), uint16_t, uint32_t>::type>::type type;
+};
+
+/**< Division by 10, exact over the whole range, by a multiplication with
+ * the reciprocal as in the C formatter: 16-bit values keep to a 32-bit
+ * product; larger values take a 64-bit one, or shifts and adds on AVR */
+inline uint32_t div10(uint32_t v)
+{
+    if (v <= 0xFFFFU) return (v * 52429U) >> 19;
+#ifdef __AVR
+    uint32_t q = (v >> 1) + (v >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    return q + (((v - (((q << 2) + q) << 1)) > 9U) ? 1U : 0U);
+#else
+    return (uint32_t)(((uint64_t)v * 0xCCCCCCCDU) >> 35);
+#endif
+}
+
+/**< Division by 100, likewise; a remainder r below 100 gives its tens
+ * as (r * 205) >> 11 */
+inline uint32_t div100(uint32_t v)
+{
+    /* v / 4 / 25 */
+    if (v <= 0xFFFFU) return ((v >> 2) * 5243U) >> 17;
+#ifdef __AVR
+    return div10(div10(v));
+#else
+    return (uint32_t)(((uint64_t)v * 0x51EB851FU) >> 37);
+#endif
+}
+
+/**< Size of a character cell in pixels */
+template <uint8_t Width, uint8_t Height>
+struct Font
+{
+    static constexpr uint8_t width = Width;     /**< Pixels per character, horizontally */
+    static constexpr uint8_t height = Height;   /**< Pixels per character, vertically */
+};
+
+/**< Character displays: a cell is a character */
+typedef Font<1U, 1U> CharacterCell;
+/**< The 5x8 font of bitmap.h with its spacing */
+typedef Font<8U, 8U> Font5x8Cell;
+
+/**< Default implementations of the optional driver functions. A driver
+ * derives from HalDefaults<itself> and defines at least
+ * static void init(void), static void set_cursor(line, chr) and
+ * static void write_char(uint8_t); defining any of the functions below
+ * hides the default one. */
+template <typename Hal>
+struct HalDefaults
+{
+    static void power(e_deasplay_HAL_power state)
+    {
+        (void)state;
+    }
+
+    static void cursor_visibility(bool visible)
+    {
+        (void)visible;
+    }
+
+    /** Write consecutive characters, the cursor being on line/chr */
+    template <typename Coord>
+    static void write_run(Coord line, Coord chr, const uint8_t *data, Coord len)
+    {
+        Coord i;
+
+        (void)line;
+        (void)chr;
+        for (i = 0; i < len; i++)
+        {
+            Hal::write_char(data[i]);
+        }
+    }
+
+    static void state_callback(e_deasplay_state state)
+    {
+        (void)state;
+    }
+};
+
+/**< A display of Lines by Chars characters of Font cells, driven by Hal */
+template <unsigned Lines, unsigned Chars, typename FontT, typename Hal>
+class Display
+{
+    static_assert((Lines > 0U) && (Chars > 0U), "a display has at least one character");
+
+public:
+    static constexpr unsigned lines = Lines;                /**< Number of text lines */
+    static constexpr unsigned chars = Chars;                /**< Number of characters per line */
+    static constexpr uint32_t elements = (uint32_t)Lines * Chars;   /**< Number of cells */
+    static constexpr uint32_t width = (uint32_t)Chars * FontT::width;   /**< Width in pixels */
+    static constexpr uint32_t height = (uint32_t)Lines * FontT::height; /**< Height in pixels */
+
+    typedef FontT font;
+    typedef typename uint_for<elements>::type index_t;                       /**< Cell index */
+    typedef typename uint_for<((Lines > Chars) ? Lines : Chars)>::type coord_t; /**< Line or character */
+
+    /** Index of a cell */
+    static constexpr index_t index(coord_t line, coord_t chr)
+    {
+        return (index_t)((line * Chars) + chr);
+    }
+
+    /** Horizontal position of a character, in pixels */
+    static constexpr uint32_t pixel_x(coord_t chr)
+    {
+        return (uint32_t)chr * FontT::width;
+    }
+
+    /** Vertical position of a line, in pixels */
+    static constexpr uint32_t pixel_y(coord_t line)
+    {
+        return (uint32_t)line * FontT::height;
+    }
+
+    /** Initialize the driver and clear the display */
+    void init(void)
+    {
+        Hal::init();
+        hw_valid_ = false;
+        cursor_ = 0U;
+        clear();
+        Hal::state_callback(DEASPLAY_STATE_INIT);
+    }
+
+    void power(e_deasplay_HAL_power state)
+    {
+        Hal::power(state);
+    }
+
+    void enable_cursor(bool visible)
+    {
+        Hal::cursor_visibility(visible);
+    }
+
+    /** Blank the display and send every cell again */
+    void clear(void)
+    {
+        memset(buffer_, ' ', sizeof(buffer_));
+        memset(shadow_, '\0', sizeof(shadow_));   /* force a complete redraw */
+        memset(dirty_, 0xFF, sizeof(dirty_));
+    }
+
+    /** Blank the display, sending only what is not blank yet */
+    void clean(void)
+    {
+        memset(buffer_, ' ', sizeof(buffer_));
+        memset(dirty_, 0xFF, sizeof(dirty_));
+    }
+
+    void set_cursor(coord_t line, coord_t chr)
+    {
+        if ((line < Lines) && (chr < Chars)) cursor_ = index(line, chr);
+    }
+
+    void advance_cursor(index_t num)
+    {
+        cursor_ = ((elements - cursor_) > num) ? (index_t)(cursor_ + num) : (index_t)elements;
+    }
+
+    void write_char(uint8_t chr)
+    {
+        if (cursor_ >= elements) return;
+        if (buffer_[cursor_] != chr)
+        {
+            buffer_[cursor_] = chr;
+            mark_line((coord_t)(cursor_ / Chars));
+        }
+        cursor_++;
+    }
+
+    void write_string(const char *str)
+    {
+        while (*str != '\0')
+        {
+            write_char((uint8_t)*str++);
+        }
+    }
+
+    /** Write a number, right aligned on at least 'width' characters */
+    void write_uint(uint32_t value, uint8_t width = 0U, char pad = ' ')
+    {
+        char digits[10];
+        uint8_t len = 0U;
+        uint32_t q;
+        uint8_t r;
+        uint8_t tens;
+
+        /* two digits per division, by reciprocals (see div100()) */
+        while (value >= 100U)
+        {
+            q = div100(value);
+            r = (uint8_t)(value - (q * 100U));
+            tens = (uint8_t)((r * 205U) >> 11);
+            digits[len++] = (char)('0' + (r - (tens * 10U)));
+            digits[len++] = (char)('0' + tens);
+            value = q;
+        }
+        if (value >= 10U)
+        {
+            tens = (uint8_t)((value * 205U) >> 11);
+            digits[len++] = (char)('0' + (value - (tens * 10U)));
+            value = tens;
+        }
+        digits[len++] = (char)('0' + value);
+        while (width > len)
+        {
+            write_char((uint8_t)pad);
+            width--;
+        }
+        while (len > 0U)
+        {
+            write_char((uint8_t)digits[--len]);
+        }
+    }
+
+    /** The characters, line after line; call mark_dirty() after changing them */
+    uint8_t *buffer(void)
+    {
+        return buffer_;
+    }
+
+    void mark_dirty(coord_t line)
+    {
+        if (line < Lines) mark_line(line);
+    }
+
+    bool is_dirty(void) const
+    {
+        unsigned i;
+
+        for (i = 0; i < sizeof(dirty_); i++)
+        {
+            if (dirty_[i] != 0U) return true;
+        }
+        return false;
+    }
+
+    /** Send the changed characters to the display */
+    void periodic(void)
+    {
+        if (is_dirty() == false) return;
+        Hal::state_callback(DEASPLAY_STATE_PERIODIC_START);
+        Refresh::run(*this);
+        Hal::state_callback(DEASPLAY_STATE_PERIODIC_END);
+    }
+
+private:
+    uint8_t buffer_[elements];              /**< Active characters */
+    uint8_t shadow_[elements];              /**< Characters as last sent */
+    uint8_t dirty_[(Lines + 7U) / 8U];      /**< One bit per line with pending changes */
+    index_t cursor_ = 0U;                   /**< Selected cell */
+    index_t hw_index_ = 0U;                 /**< Cell the controller writes to next */
+    bool hw_valid_ = false;                 /**< hw_index_ reflects the controller */
+
+    void mark_line(coord_t line)
+    {
+        dirty_[line >> 3] = (uint8_t)(dirty_[line >> 3] | (1U << (line & 7U)));
+    }
+
+    /** Send the changed runs of a line */
+    void refresh_line(coord_t line)
+    {
+        const index_t base = index(line, 0U);
+        coord_t chr = 0U;
+        coord_t start;
+
+        if ((dirty_[line >> 3] & (1U << (line & 7U))) == 0U) return;
+        dirty_[line >> 3] = (uint8_t)(dirty_[line >> 3] & ~(1U << (line & 7U)));
+
+        while (chr < Chars)
+        {
+            if (buffer_[base + chr] == shadow_[base + chr])
+            {
+                chr++;
+                continue;
+            }
+            start = chr;
+            while ((chr < Chars) && (buffer_[base + chr] != shadow_[base + chr]))
+            {
+                shadow_[base + chr] = buffer_[base + chr];
+                chr++;
+            }
+            if ((hw_valid_ == false) || (hw_index_ != (index_t)(base + start)))
+            {
+                Hal::set_cursor(line, start);
+            }
+            Hal::write_run(line, start, &buffer_[base + start], (coord_t)(chr - start));
+            hw_index_ = (index_t)(base + chr);
+            /* controllers do not agree on where the cursor goes past the end of a line */
+            hw_valid_ = (chr < Chars);
+        }
+    }
+
+    /**< Refresh loop, unrolled: every line is refreshed with a constant index */
+    template <unsigned Line, bool End = (Line >= Lines)>
+    struct Unrolled
+    {
+        static void run(Display &display)
+        {
+            display.refresh_line((coord_t)Line);
+            Unrolled<Line + 1U>::run(display);
+        }
+    };
+
+    template <unsigned Line>
+    struct Unrolled<Line, true>
+    {
+        static void run(Display &display)
+        {
+            (void)display;
+        }
+    };
+
+    /**< Refresh loop, for displays with many lines */
+    struct Looped
+    {
+        static void run(Display &display)
+        {
+            coord_t line;
+
+            for (line = 0U; line < Lines; line++)
+            {
+                display.refresh_line(line);
+            }
+        }
+    };
+
+    typedef typename select<(Lines <= DEASPLAY_HPP_UNROLL_LINES), Unrolled<0U>, Looped>::type Refresh;
+};
+
+} /* namespace deasplay */
+
+#endif /* DEASPLAY_HPP_ */
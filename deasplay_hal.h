@@ -39,14 +39,25 @@ typedef enum
 typedef enum
 {
     DEASPLAY_STATE_INIT,
-    DEASPLAY_STATE_PERIODIC_START,
-    DEASPLAY_STATE_PERIODIC_END,
+    DEASPLAY_STATE_PERIODIC_START,  /**< A frame starts: once per frame, however many steps it takes */
+    DEASPLAY_STATE_PERIODIC_END,    /**< The frame is over */
+    DEASPLAY_STATE_PERIODIC_PAUSE,  /**< display_periodic_step() ran out of budget, the frame goes on at the next step */
+    DEASPLAY_STATE_PERIODIC_RESUME, /**< The next step goes on with a paused frame */
 } e_deasplay_state;
 
 typedef void (*t_deasplay_delay_us)(uint32_t us);
 
 extern t_deasplay_delay_us hw_delay;
 
+/**< A free running timestamp, in any unit (e.g. microseconds or timer ticks).
+ * Optional: it bounds display_periodic_step() in time and times the refreshes
+ * when DISPLAY_HAS_STATS is enabled. */
+typedef uint32_t (*t_deasplay_timestamp)(void);
+
+extern t_deasplay_timestamp hw_timestamp;
+
+#define DISPLAY_SET_TIMESTAMP(x)        (hw_timestamp = (x))
+
 /**< The bitmap buffer. Every device can define its own
  * for performance reason (including e.g. an initial command)
  * The requirement is that this pointer must point to real
@@ -63,11 +74,70 @@ extern t_interface *ctrl_interface;
 #define DISPLAY_SET_CTRL_INTERFACE(x)   (ctrl_interface = (x))
 #define DISPLAY_SET_DELAYUS(x)          (hw_delay = (x))
 
+/* A driver sending one small transfer per HAL call can merge the ones of a
+ * refresh into few bus transactions with busbatch.h: its HAL functions queue
+ * command and data bytes, its state callback calls busbatch_state() and its
+ * transfer function writes a whole transaction to hw_interface. */
+
 #endif
 
 /* define optional HAL calls */
+
+/* deasplay_hal_write_run(line, chr, data, len) is optional as well:
+ * a driver able to transfer several consecutive characters in one go
+ * defines it in its header (e.g. #define deasplay_hal_write_run(l, c, d, n) lc75710_write(l, c, d, n)).
+ * The cursor has already been positioned on line/chr when it is called.
+ * When it is not defined, runs are written by calling deasplay_hal_write_char()
+ * for every character. */
+
+/* display_hal_write_span(page, x, data, len) is the optional counterpart
+ * for bitmap displays: it pushes 'len' bytes of the bitmap page 'page'
+ * starting from column 'x'. When a driver defines it, display_periodic()
+ * pushes only the columns that changed since the previous refresh and the
+ * application no longer needs to call display_write_buffer(). */
+
+/* deasplay_hal_scroll(line, chr, lines, chars, dx, dy) is optional too:
+ * it shifts what the panel shows in a window of 'lines' text lines and
+ * 'chars' characters by dx columns and dy lines, and returns true, or
+ * returns false when the panel cannot shift that window (e.g. the HD44780
+ * shift command moves whole lines only, so its driver accepts windows
+ * covering the whole display and keeps track of the DDRAM offset). After a
+ * successful shift display_periodic() only sends the uncovered cells. */
+
+/* Cost of starting a new display_hal_write_span() (addressing commands,
+ * bus overhead) expressed in data bytes: when diffing against the bitmap
+ * shadow, changed runs separated by no more unchanged bytes than this
+ * are sent as a single span. A batching driver (busbatch.h) pays the
+ * addressing commands only. */
+#ifndef DISPLAY_HAL_SPAN_OVERHEAD
+#define DISPLAY_HAL_SPAN_OVERHEAD       (4U)
+#endif
+
+/* Character set of the display (DISPLAY_HAS_UTF8): display_write_utf8()
+ * translates code points with this codepage (see codepage.h), whose table
+ * must be linked in. A driver defines it in its header when its controller
+ * shows another character set, e.g. #define DISPLAY_HAL_CODEPAGE codepage_hd44780_a02. */
+#ifdef DISPLAY_HAS_UTF8
+#ifndef DISPLAY_HAL_CODEPAGE
+#if !defined(HAS_BITMAP)
+#define DISPLAY_HAL_CODEPAGE            codepage_hd44780_a00
+#elif defined(BITMAP_FONT5x8_ASCII)
+#define DISPLAY_HAL_CODEPAGE            codepage_ascii
+#else
+#define DISPLAY_HAL_CODEPAGE            codepage_font5x8
+#endif
+#endif
+#endif
+
 #ifndef deasplay_hal_state_callback
-#define deasplay_hal_state_callback(__VA_ARGS__)
+#define deasplay_hal_state_callback(...)
 #endif
 
+/* With DISPLAY_HAS_ASYNC the driver provides, next to the functions above,
+ * void deasplay_hal_submit(uint8_t *queue, size_t len): it starts the
+ * transfer of a queue of operations (see display_async_decode() and
+ * display_async_replay()) and returns without waiting. Once the queue has
+ * been transferred, from an interrupt, a DMA callback or a worker thread,
+ * it calls display_async_complete(). */
+
 #endif /* DEASPLAY_HAL_H_ */
@@ -0,0 +1,55 @@
+/*
+ * font_12x24_digits.c
+ *
+ *  Fixed 12x24 font generated by tools/fontgen.py from SourceCodePro-Bold.ttf,
+ *  14 glyphs, rle encoded, 366 bytes of glyph data.
+ *  Source Code Pro, Copyright 2010, 2012 Adobe Systems Incorporated, SIL Open Font License 1.1.
+ *  Digits, ':', '-', '.' and space, stretched over the cell for big readouts.
+ *  Do not edit, generate it again instead.
+ */
+
+#include "bitmap.h"
+
+static const uint8_t bitmap_font_12x24_digits_data[] BITMAP_STORAGE_FLAGS =
+{
+    0xA3,0x00, // 32
+    0x8D,0x00,0x87,0x1C,0x8D,0x00, // 45 -
+    0x90,0x00,0x81,0x80,0x88,0x00,0x03,0x3F,0x7F,0x7F,0x3F,0x83,0x00, // 46 .
+    0x81,0x00,0x07,0xF0,0xFC,0x3E,0x1E,0x1E,0x3E,0xFC,0xF0,0x82,0x00,0x06,0x7E,0xFF,0xFF,0x00,0x3C,0x3E,0x00,0x82,0xFF,0x82,0x00,0x09,0x0F,0x3F,0x7E,0x78,0x78,0x7C,0x3F,0x0F,0x00,0x00, // 48 0
+    0x82,0x00,0x04,0x38,0x3C,0xFC,0xFE,0xFE,0x88,0x00,0x82,0xFF,0x85,0x00,0x82,0x78,0x82,0x7F,0x81,0x78,0x01,0x38,0x00, // 49 1
+    0x03,0x00,0x10,0x38,0x3C,0x82,0x1E,0x02,0xFC,0xF8,0xE0,0x85,0x00,0x05,0x80,0xE0,0xF8,0x7F,0x1F,0x07,0x82,0x00,0x05,0x30,0x7C,0x7E,0x7F,0x7F,0x79,0x82,0x7C,0x01,0x38,0x00, // 50 2
+    0x81,0x00,0x81,0x3C,0x82,0x1E,0x02,0xFE,0xFC,0xF0,0x85,0x00,0x05,0x1C,0x3C,0x3E,0x7F,0xF7,0xE3,0x82,0x00,0x02,0x18,0x3E,0x3C,0x82,0x78,0x04,0x7C,0x3F,0x1F,0x00,0x00, // 51 3
+    0x83,0x00,0x04,0xE0,0xF8,0x7E,0xFE,0xFE,0x83,0x00,0x0B,0xE0,0xFC,0xFF,0xCF,0xC1,0xC0,0xFF,0xFF,0xE0,0xC0,0x00,0x00,0x85,0x03,0x81,0x7F,0x81,0x03,0x00,0x00, // 52 4
+    0x81,0x00,0x02,0xFC,0xFE,0xFE,0x84,0x3E,0x83,0x00,0x07,0x0F,0x1F,0x1F,0x0E,0x1E,0x3E,0xFC,0xF8,0x82,0x00,0x02,0x08,0x3E,0x3C,0x82,0x78,0x04,0x7E,0x3F,0x0F,0x00,0x00, // 53 5
+    0x81,0x00,0x07,0xE0,0xF8,0xFC,0x3E,0x1E,0x1E,0x3E,0x3C,0x82,0x00,0x09,0x38,0xFF,0xFF,0x38,0x1C,0x1E,0x1E,0xFC,0xF8,0xE0,0x82,0x00,0x02,0x07,0x1F,0x3E,0x82,0x78,0x03,0x3F,0x1F,0x03,0x00, // 54 6
+    0x81,0x00,0x84,0x3E,0x81,0xFE,0x01,0x7E,0x1C,0x85,0x00,0x03,0xF8,0xFF,0x3F,0x01,0x86,0x00,0x82,0x7F,0x84,0x00, // 55 7
+    0x81,0x00,0x07,0xF0,0xFC,0xBE,0x1E,0x0E,0x1E,0xFC,0xF8,0x83,0x00,0x08,0xE3,0xF7,0x3F,0x3E,0x3C,0x7E,0xFF,0xE3,0x80,0x82,0x00,0x09,0x1F,0x3F,0x78,0x78,0x70,0x78,0x3F,0x1F,0x07,0x00, // 56 8
+    0x03,0x00,0xC0,0xF8,0xFC,0x82,0x1E,0x02,0x7C,0xF8,0xF0,0x82,0x00,0x09,0x03,0x1F,0x3F,0x78,0x78,0x38,0x1C,0xFF,0xFF,0x3E,0x82,0x00,0x09,0x38,0x3C,0x78,0x78,0x7C,0x3F,0x1F,0x07,0x00,0x00, // 57 9
+    0x83,0x00,0x81,0xE0,0x01,0xF0,0xE0,0x87,0x00,0x03,0x07,0x8F,0x8F,0x07,0x87,0x00,0x03,0x3F,0x7F,0x7F,0x3F,0x83,0x00 // 58 :
+};
+
+static const uint16_t bitmap_font_12x24_digits_offsets[] BITMAP_STORAGE_FLAGS =
+{
+    0, 2, 8, 21, 57, 80, 114, 147,
+    178, 211, 248, 270, 306, 343
+};
+
+static const t_bitmap_font_range bitmap_font_12x24_digits_ranges[] BITMAP_STORAGE_FLAGS =
+{
+    { 32U, 32U, 0U },
+    { 45U, 46U, 1U },
+    { 48U, 58U, 3U }
+};
+
+const t_bitmap_font bitmap_font_12x24_digits BITMAP_STORAGE_FLAGS =
+{
+    .width = 12U,
+    .height = 24U,
+    .encoding = BITMAP_FONT_RLE,
+    .ranges = 3U,
+    .fallback = 32U,
+    .range = bitmap_font_12x24_digits_ranges,
+    .widths = NULL,
+    .offsets = bitmap_font_12x24_digits_offsets,
+    .data = bitmap_font_12x24_digits_data
+};
@@ -0,0 +1,127 @@
+/*
+ * font_8x16.c
+ *
+ *  Fixed 8x16 font generated by tools/fontgen.py from SourceCodePro-Bold.ttf,
+ *  95 glyphs, raw encoded, 1520 bytes of glyph data.
+ *  Source Code Pro, Copyright 2010, 2012 Adobe Systems Incorporated, SIL Open Font License 1.1.
+ *  Do not edit, generate it again instead.
+ */
+
+#include "bitmap.h"
+
+static const uint8_t bitmap_font_8x16_data[] BITMAP_STORAGE_FLAGS =
+{
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 32
+    0x00,0x00,0x00,0xFE,0xFE,0x00,0x00,0x00,0x00,0x00,0x00,0x0E,0x0E,0x00,0x00,0x00, // 33 !
+    0x00,0x3E,0x7E,0x00,0x00,0x7E,0x1E,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 34 "
+    0x00,0x30,0xF8,0x3C,0xB0,0xFC,0x30,0x00,0x00,0x01,0x0F,0x01,0x0F,0x01,0x01,0x00, // 35 #
+    0x00,0x38,0x7C,0xEF,0xCF,0xDC,0x80,0x00,0x00,0x06,0x06,0x3C,0x1E,0x07,0x03,0x00, // 36 $
+    0x18,0x7C,0x44,0x3C,0x80,0xB0,0x8C,0x00,0x04,0x06,0x03,0x00,0x0F,0x08,0x0F,0x00, // 37 %
+    0x00,0xF8,0xFC,0xE6,0x3C,0x00,0xC0,0x00,0x03,0x0F,0x0C,0x0D,0x0F,0x07,0x0F,0x00, // 38 &
+    0x00,0x00,0x00,0x7E,0x7E,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 39 '
+    0x00,0x00,0xC0,0xF8,0x0E,0x02,0x00,0x00,0x00,0x00,0x01,0x1F,0x38,0x20,0x00,0x00, // 40 (
+    0x00,0x00,0x02,0x1E,0xF8,0x00,0x00,0x00,0x00,0x00,0x60,0x3C,0x0F,0x00,0x00,0x00, // 41 )
+    0x00,0x60,0x40,0xF8,0xE0,0x60,0x20,0x00,0x00,0x00,0x03,0x01,0x01,0x03,0x00,0x00, // 42 *
+    0x00,0xC0,0xC0,0xF8,0xF8,0xC0,0xC0,0x00,0x00,0x00,0x00,0x03,0x03,0x00,0x00,0x00, // 43 +
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x6E,0x3E,0x0C,0x00,0x00, // 44 ,
+    0x00,0xC0,0xC0,0xC0,0xC0,0xC0,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 45 -
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x0E,0x0E,0x00,0x00,0x00, // 46 .
+    0x00,0x00,0x00,0xC0,0xF8,0x1E,0x02,0x00,0x00,0x60,0x3C,0x0F,0x00,0x00,0x00,0x00, // 47 /
+    0x00,0xF8,0x3C,0xCC,0xCC,0xFC,0xF0,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x03,0x00, // 48 0
+    0x00,0x08,0x0C,0xFC,0xFC,0x00,0x00,0x00,0x00,0x0C,0x0C,0x0F,0x0F,0x0C,0x0C,0x00, // 49 1
+    0x00,0x0C,0x0C,0x0C,0xCC,0xFC,0x10,0x00,0x00,0x0C,0x0E,0x0F,0x0D,0x0C,0x0C,0x00, // 50 2
+    0x00,0x0C,0x4C,0xCC,0xEC,0xFC,0x10,0x00,0x00,0x0C,0x0C,0x0C,0x0C,0x0F,0x07,0x00, // 51 3
+    0x00,0xC0,0xF0,0x38,0xFC,0xFC,0x00,0x00,0x01,0x03,0x03,0x03,0x0F,0x0F,0x03,0x00, // 52 4
+    0x00,0x7C,0x7C,0x4C,0xCC,0xCC,0x84,0x00,0x00,0x0C,0x0C,0x0C,0x0C,0x0F,0x03,0x00, // 53 5
+    0x00,0xF0,0xFC,0xCC,0x4C,0xCC,0x8C,0x00,0x00,0x03,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 54 6
+    0x00,0x0C,0x0C,0x8C,0xEC,0x3C,0x0C,0x00,0x00,0x00,0x00,0x0F,0x07,0x00,0x00,0x00, // 55 7
+    0x00,0x38,0xFC,0xC4,0xC4,0xFC,0x18,0x00,0x00,0x07,0x0F,0x08,0x0C,0x0F,0x07,0x00, // 56 8
+    0x00,0x78,0xDC,0x84,0xCC,0xFC,0xF0,0x00,0x00,0x0C,0x0C,0x0C,0x0C,0x07,0x03,0x00, // 57 9
+    0x00,0x00,0x30,0x78,0x78,0x00,0x00,0x00,0x00,0x00,0x04,0x0E,0x0E,0x00,0x00,0x00, // 58 :
+    0x00,0x00,0x30,0x78,0x78,0x00,0x00,0x00,0x00,0x00,0x00,0x6E,0x3E,0x0C,0x00,0x00, // 59 ;
+    0x00,0x00,0xE0,0xB0,0x38,0x18,0x08,0x00,0x00,0x00,0x00,0x01,0x03,0x06,0x04,0x00, // 60 <
+    0x00,0x30,0x30,0x30,0x30,0x30,0x30,0x00,0x00,0x01,0x01,0x01,0x01,0x01,0x01,0x00, // 61 =
+    0x00,0x0C,0x18,0x30,0xF0,0xE0,0x00,0x00,0x00,0x06,0x07,0x03,0x01,0x00,0x00,0x00, // 62 >
+    0x00,0x04,0x06,0xC6,0xFE,0x3C,0x00,0x00,0x00,0x00,0x04,0x0E,0x0E,0x00,0x00,0x00, // 63 ?
+    0xC0,0xF8,0x0C,0x84,0xC4,0x4C,0xF8,0x00,0x03,0x1F,0x30,0x23,0x26,0x22,0x03,0x00, // 64 @
+    0x00,0x80,0xF8,0x1C,0xBC,0xF8,0x80,0x00,0x0C,0x0F,0x03,0x03,0x03,0x07,0x0F,0x08, // 65 A
+    0x00,0xFC,0xFC,0x44,0xEC,0xFC,0x98,0x00,0x00,0x0F,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 66 B
+    0x00,0xF8,0xFC,0x0C,0x06,0x0E,0x0C,0x00,0x00,0x03,0x07,0x0C,0x0C,0x0C,0x0C,0x00, // 67 C
+    0x00,0xFC,0xFC,0x0C,0x0C,0xFC,0xF8,0x00,0x00,0x0F,0x0F,0x0C,0x0E,0x07,0x03,0x00, // 68 D
+    0x00,0xFC,0xFC,0xCC,0xCC,0xCC,0x04,0x00,0x00,0x0F,0x0F,0x0C,0x0C,0x0C,0x0C,0x00, // 69 E
+    0x00,0xFC,0xFC,0xCC,0xCC,0xCC,0x0C,0x00,0x00,0x0F,0x0F,0x00,0x00,0x00,0x00,0x00, // 70 F
+    0x00,0xF8,0xFC,0x0C,0xC6,0xCC,0xC4,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 71 G
+    0x00,0xFC,0xFC,0xC0,0xC0,0xFC,0xFC,0x00,0x00,0x0F,0x0F,0x00,0x00,0x0F,0x0F,0x00, // 72 H
+    0x00,0x0C,0x0C,0xFC,0xFC,0x0C,0x0C,0x00,0x00,0x0C,0x0C,0x0F,0x0F,0x0C,0x0C,0x00, // 73 I
+    0x00,0x04,0x0C,0x0C,0x0C,0xFC,0xFC,0x00,0x00,0x04,0x0C,0x0C,0x0C,0x0F,0x03,0x00, // 74 J
+    0x00,0xFC,0xFC,0xE0,0xF8,0x9C,0x04,0x00,0x00,0x0F,0x0F,0x00,0x01,0x0F,0x0E,0x08, // 75 K
+    0x00,0xFC,0xFC,0x00,0x00,0x00,0x00,0x00,0x00,0x0F,0x0F,0x0C,0x0C,0x0C,0x0C,0x00, // 76 L
+    0x00,0xFC,0x7C,0xE0,0xF0,0xFC,0xFC,0x00,0x00,0x0F,0x00,0x01,0x00,0x0F,0x0F,0x00, // 77 M
+    0x00,0xFC,0xFC,0xF0,0xC0,0xFC,0xFC,0x00,0x00,0x0F,0x0F,0x00,0x07,0x0F,0x0F,0x00, // 78 N
+    0x00,0xF8,0x3C,0x0E,0x0E,0xFC,0xF8,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x03,0x00, // 79 O
+    0x00,0xFC,0xFC,0x84,0x84,0xFC,0x7C,0x00,0x00,0x0F,0x0F,0x00,0x00,0x00,0x00,0x00, // 80 P
+    0xC0,0xF8,0x3C,0x0E,0x0E,0xFC,0xF8,0x00,0x00,0x07,0x0F,0x1C,0x3C,0x6F,0x63,0x00, // 81 Q
+    0x00,0xFC,0xFC,0xC4,0xCC,0xFC,0x78,0x00,0x00,0x0F,0x0F,0x00,0x03,0x0F,0x0C,0x00, // 82 R
+    0x00,0x38,0x7C,0xEE,0xC6,0xCC,0x84,0x00,0x00,0x04,0x0C,0x0C,0x0C,0x0F,0x07,0x00, // 83 S
+    0x04,0x0C,0x0C,0xFC,0xFC,0x0C,0x0C,0x00,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00,0x00, // 84 T
+    0x00,0xFC,0xFC,0x00,0x00,0xFC,0xFC,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 85 U
+    0x04,0x7C,0xF8,0x00,0x80,0xFC,0x3C,0x00,0x00,0x00,0x07,0x0F,0x0F,0x03,0x00,0x00, // 86 V
+    0x3C,0xFC,0x80,0xF0,0xF0,0x80,0xFC,0x0C,0x00,0x0F,0x0F,0x03,0x07,0x0F,0x0F,0x00, // 87 W
+    0x00,0x0C,0xBC,0xF0,0xF0,0x3C,0x0C,0x00,0x08,0x0E,0x07,0x01,0x03,0x0F,0x0C,0x00, // 88 X
+    0x00,0x1C,0x7C,0xE0,0xE0,0x7C,0x0C,0x00,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00,0x00, // 89 Y
+    0x00,0x0C,0x8C,0xCC,0xFC,0x3C,0x0C,0x00,0x00,0x0E,0x0F,0x0D,0x0C,0x0C,0x0C,0x00, // 90 Z
+    0x00,0x00,0x00,0xFE,0x02,0x02,0x00,0x00,0x00,0x00,0x00,0x3F,0x20,0x20,0x00,0x00, // 91 [
+    0x00,0x02,0x3E,0xF0,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x0F,0x7C,0x20,0x00, // 92
+    0x00,0x02,0x02,0x02,0xFE,0x00,0x00,0x00,0x00,0x20,0x20,0x20,0x3F,0x00,0x00,0x00, // 93 ]
+    0x00,0x40,0x78,0x1E,0x3E,0xF0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 94 ^
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x60,0x60,0x60,0x60,0x60,0x60,0x00, // 95 _
+    0x00,0x00,0x01,0x07,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, // 96 `
+    0x00,0x20,0xB0,0xB0,0xB0,0xF0,0xE0,0x00,0x00,0x0F,0x0F,0x0D,0x0C,0x0F,0x0F,0x00, // 97 a
+    0x00,0xFE,0xFE,0x30,0x30,0xF0,0xE0,0x00,0x00,0x0F,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 98 b
+    0x00,0xC0,0xE0,0x30,0x30,0x30,0x20,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0C,0x0C,0x00, // 99 c
+    0x00,0xE0,0xF0,0x30,0x30,0xFE,0xFE,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x0F,0x00, // 100 d
+    0x00,0xE0,0xF0,0xB0,0xB0,0xF0,0xE0,0x00,0x00,0x07,0x0F,0x0D,0x0D,0x0D,0x01,0x00, // 101 e
+    0x00,0x30,0x30,0xFC,0xFE,0x36,0x36,0x02,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00,0x00, // 102 f
+    0x00,0xE0,0xF0,0x30,0xB0,0xF0,0x30,0x00,0x00,0x7E,0x7F,0x49,0x49,0x79,0x38,0x00, // 103 g
+    0x00,0xFE,0xFE,0x30,0x30,0xF0,0xE0,0x00,0x00,0x0F,0x0F,0x00,0x00,0x0F,0x0F,0x00, // 104 h
+    0x00,0x30,0x30,0x32,0xF7,0xF2,0x00,0x00,0x00,0x00,0x00,0x00,0x0F,0x0F,0x00,0x00, // 105 i
+    0x00,0x30,0x30,0x32,0xF7,0xF2,0x00,0x00,0x00,0x60,0x60,0x70,0x3F,0x0F,0x00,0x00, // 106 j
+    0x00,0xFE,0xFE,0x80,0xE0,0x70,0x10,0x00,0x00,0x0F,0x0F,0x01,0x03,0x0F,0x0C,0x00, // 107 k
+    0x00,0x06,0x06,0xFE,0xFE,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x00, // 108 l
+    0xF0,0xF0,0x30,0xF0,0xE0,0x30,0xF0,0x00,0x0F,0x0F,0x00,0x0F,0x0F,0x00,0x0F,0x00, // 109 m
+    0x00,0xF0,0xF0,0x30,0x30,0xF0,0xE0,0x00,0x00,0x0F,0x0F,0x00,0x00,0x0F,0x0F,0x00, // 110 n
+    0x00,0xE0,0xF0,0x30,0x30,0xF0,0xE0,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x0F,0x07,0x00, // 111 o
+    0x00,0xF0,0xF0,0x30,0x30,0xF0,0xE0,0x00,0x00,0x7F,0x7F,0x0C,0x0C,0x0F,0x07,0x00, // 112 p
+    0x00,0xE0,0xF0,0x30,0x30,0xF0,0xF0,0x00,0x00,0x07,0x0F,0x0C,0x0C,0x7F,0x7F,0x00, // 113 q
+    0x00,0x00,0xF0,0xE0,0x30,0x30,0x30,0x00,0x00,0x00,0x0F,0x00,0x00,0x00,0x00,0x00, // 114 r
+    0x00,0x60,0xF0,0xB0,0xB0,0x30,0x20,0x00,0x00,0x0C,0x0C,0x0D,0x0D,0x0F,0x07,0x00, // 115 s
+    0x00,0x30,0xF8,0xFC,0x30,0x30,0x30,0x00,0x00,0x00,0x03,0x0F,0x0C,0x0C,0x0C,0x00, // 116 t
+    0x00,0xF0,0xF0,0x00,0x00,0xF0,0xF0,0x00,0x00,0x0F,0x0F,0x0C,0x04,0x0F,0x0F,0x00, // 117 u
+    0x00,0xF0,0xE0,0x00,0x00,0xF0,0x70,0x00,0x00,0x00,0x07,0x0F,0x0F,0x03,0x00,0x00, // 118 v
+    0x70,0xF0,0x00,0xE0,0xE0,0x00,0xF0,0x30,0x00,0x0F,0x0F,0x03,0x0F,0x0F,0x0F,0x00, // 119 w
+    0x00,0x30,0x70,0xC0,0xC0,0x70,0x10,0x00,0x00,0x0C,0x0F,0x03,0x07,0x0E,0x08,0x00, // 120 x
+    0x00,0x70,0xE0,0x00,0x00,0xF0,0x70,0x00,0x00,0x60,0x63,0x7F,0x1F,0x03,0x00,0x00, // 121 y
+    0x00,0x30,0x30,0xB0,0xF0,0x70,0x30,0x00,0x00,0x0C,0x0F,0x0F,0x0D,0x0C,0x0C,0x00, // 122 z
+    0x00,0x80,0x80,0xFE,0x7E,0x02,0x00,0x00,0x00,0x00,0x01,0x3F,0x3F,0x20,0x00,0x00, // 123 {
+    0x00,0x00,0x00,0xFF,0xFF,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0x00,0x00,0x00, // 124 |
+    0x00,0x02,0x02,0x7E,0xFC,0x80,0x00,0x00,0x00,0x20,0x20,0x3F,0x1F,0x00,0x00,0x00, // 125 }
+    0x00,0xC0,0x60,0x40,0xC0,0xC0,0x60,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 // 126 ~
+};
+
+static const t_bitmap_font_range bitmap_font_8x16_ranges[] BITMAP_STORAGE_FLAGS =
+{
+    { 32U, 126U, 0U }
+};
+
+const t_bitmap_font bitmap_font_8x16 BITMAP_STORAGE_FLAGS =
+{
+    .width = 8U,
+    .height = 16U,
+    .encoding = BITMAP_FONT_RAW,
+    .ranges = 1U,
+    .fallback = 63U,
+    .range = bitmap_font_8x16_ranges,
+    .widths = NULL,
+    .offsets = NULL,
+    .data = bitmap_font_8x16_data
+};
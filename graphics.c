@@ -0,0 +1,309 @@
+/*
+ * graphics.c
+ *
+ *  Pixel graphics on the bitmap buffer of a display.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "graphics.h"
+
+/**
+ * Apply a mask to consecutive bytes of a page.
+ * Full masks turn into memset(), the others are applied a word at a time.
+ * @param p     first byte
+ * @param n     number of bytes
+ * @param mask  rows to be changed
+ * @param color the operation
+ */
+static void graphics_apply(uint8_t *p, size_t n, uint8_t mask, e_graphics_color color)
+{
+    deasplay_word_t wmask;
+    deasplay_word_t w;
+
+    if ((mask == 0xFFU) && (color != GRAPHICS_XOR))
+    {
+        memset(p, (color == GRAPHICS_SET) ? 0xFF : 0x00, n);
+        return;
+    }
+
+    /* replicate the mask on every byte of a word */
+    wmask = (deasplay_word_t)(((deasplay_word_t)~(deasplay_word_t)0U / 0xFFU) * mask);
+
+    while (n >= sizeof(deasplay_word_t))
+    {
+        memcpy(&w, p, sizeof(w));
+        if (color == GRAPHICS_SET) w |= wmask;
+        else if (color == GRAPHICS_CLEAR) w &= (deasplay_word_t)~wmask;
+        else w ^= wmask;
+        memcpy(p, &w, sizeof(w));
+        p += sizeof(w);
+        n -= sizeof(w);
+    }
+
+    while (n > 0U)
+    {
+        if (color == GRAPHICS_SET) *p |= mask;
+        else if (color == GRAPHICS_CLEAR) *p &= (uint8_t)~mask;
+        else *p ^= mask;
+        p++;
+        n--;
+    }
+}
+
+/**
+ * Clip a segment [*pos, *pos + *len) against [0, max).
+ * @return false if nothing is left
+ */
+static bool graphics_clip(int16_t *pos, int16_t *len, int16_t max)
+{
+    int32_t start = *pos;
+    int32_t end = (int32_t)*pos + *len;
+
+    if (*len <= 0) return false;
+    if (start < 0) start = 0;
+    if (end > max) end = max;
+    if (start >= end) return false;
+
+    *pos = (int16_t)start;
+    *len = (int16_t)(end - start);
+    return true;
+}
+
+void graphics_fill_rect(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, int16_t h, e_graphics_color color)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+    uint16_t page;
+    uint16_t last;
+    uint8_t mask;
+
+    if (b == NULL) return;
+    if (graphics_clip(&x, &w, (int16_t)ctx->width) == false) return;
+    if (graphics_clip(&y, &h, (int16_t)(ctx->lines * 8U)) == false) return;
+
+    last = (uint16_t)((y + h - 1) / 8);
+    for (page = (uint16_t)(y / 8); page <= last; page++)
+    {
+        /* rows of this page inside the rectangle */
+        mask = 0xFFU;
+        if (page == (uint16_t)(y / 8)) mask &= (uint8_t)(0xFFU << (y % 8));
+        if (page == last) mask &= (uint8_t)(0xFFU >> (7 - ((y + h - 1) % 8)));
+
+        graphics_apply(&b[((size_t)page * ctx->width) + (size_t)x], (size_t)w, mask, color);
+    }
+
+    display_mark_dirty_ctx(ctx, (deasplay_coord_t)x, (deasplay_coord_t)y, (deasplay_coord_t)w, (deasplay_coord_t)h);
+}
+
+void graphics_hline(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, e_graphics_color color)
+{
+    graphics_fill_rect(ctx, x, y, w, 1, color);
+}
+
+void graphics_vline(t_deasplay *ctx, int16_t x, int16_t y, int16_t h, e_graphics_color color)
+{
+    graphics_fill_rect(ctx, x, y, 1, h, color);
+}
+
+void graphics_rect(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, int16_t h, e_graphics_color color)
+{
+    if ((w <= 0) || (h <= 0)) return;
+
+    graphics_hline(ctx, x, y, w, color);
+    if (h > 1) graphics_hline(ctx, x, (int16_t)(y + h - 1), w, color);
+    if (h > 2)
+    {
+        /* do not touch the corners twice, it matters for GRAPHICS_XOR */
+        graphics_vline(ctx, x, (int16_t)(y + 1), (int16_t)(h - 2), color);
+        if (w > 1) graphics_vline(ctx, (int16_t)(x + w - 1), (int16_t)(y + 1), (int16_t)(h - 2), color);
+    }
+}
+
+/**
+ * Change a single pixel, without clipping nor dirty tracking.
+ */
+static inline void graphics_put(t_deasplay *ctx, uint8_t *b, int16_t x, int16_t y, e_graphics_color color)
+{
+    uint8_t *p = &b[((size_t)(y / 8) * ctx->width) + (size_t)x];
+    uint8_t mask = (uint8_t)(1U << (y % 8));
+
+    if (color == GRAPHICS_SET) *p |= mask;
+    else if (color == GRAPHICS_CLEAR) *p &= (uint8_t)~mask;
+    else *p ^= mask;
+}
+
+void graphics_pixel(t_deasplay *ctx, int16_t x, int16_t y, e_graphics_color color)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+
+    if ((b == NULL) || (x < 0) || (y < 0) ||
+        (x >= (int16_t)ctx->width) || (y >= (int16_t)(ctx->lines * 8U))) return;
+
+    graphics_put(ctx, b, x, y, color);
+    display_mark_dirty_ctx(ctx, (deasplay_coord_t)x, (deasplay_coord_t)y, 1U, 1U);
+}
+
+void graphics_line(t_deasplay *ctx, int16_t x0, int16_t y0, int16_t x1, int16_t y1, e_graphics_color color)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+    int32_t width = (int32_t)ctx->width;
+    int32_t height = (int32_t)ctx->lines * 8;
+    /* the ends may be further apart than an int16_t reaches */
+    int32_t dx = ((int32_t)x1 > x0) ? ((int32_t)x1 - x0) : ((int32_t)x0 - x1);
+    int32_t dy = ((int32_t)y1 > y0) ? ((int32_t)y1 - y0) : ((int32_t)y0 - y1);
+    bool steep = (dy > dx);
+    /* the line seen along its major axis, one pixel per step */
+    int32_t len = steep ? dy : dx;
+    int32_t minor_len = steep ? dx : dy;
+    int32_t pos = steep ? y0 : x0;
+    int32_t minor_pos = steep ? x0 : y0;
+    int32_t step = (steep ? (y0 < y1) : (x0 < x1)) ? 1 : -1;
+    int32_t minor_step = (steep ? (x0 < x1) : (y0 < y1)) ? 1 : -1;
+    int32_t size = steep ? height : width;
+    int32_t minor_size = steep ? width : height;
+    int32_t first;
+    int32_t last;
+    int32_t k;
+    int32_t m;
+    int32_t d;
+    int32_t x;
+    int32_t y;
+    int32_t lo;
+    int32_t hi;
+    int64_t n;
+    int32_t box[4] = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+
+    if (b == NULL) return;
+
+    /* straight lines are spans */
+    if (minor_len == 0)
+    {
+        lo = (step > 0) ? pos : (pos - len);
+        hi = lo + len;
+        if (lo < -1) lo = -1;
+        if (hi > size) hi = size;
+        if (steep) graphics_fill_rect(ctx, x0, (int16_t)lo, 1, (int16_t)(hi - lo + 1), color);
+        else graphics_fill_rect(ctx, (int16_t)lo, y0, (int16_t)(hi - lo + 1), 1, color);
+        return;
+    }
+
+    /* only the steps on the panel are taken */
+    if (step > 0)
+    {
+        first = (pos < 0) ? -pos : 0;
+        last = ((size - 1 - pos) < len) ? (size - 1 - pos) : len;
+    }
+    else
+    {
+        first = (pos > (size - 1)) ? (pos - (size - 1)) : 0;
+        last = (pos < len) ? pos : len;
+    }
+    if (first > last) return;
+
+    /* Bresenham, started at the first step: the minor offset after k steps
+     * is floor((2 k minor_len + len) / (2 len)), d the remainder */
+    n = (2 * (int64_t)first * minor_len) + len;
+    m = (int32_t)(n / (2 * (int64_t)len));
+    d = (int32_t)(n - ((int64_t)m * 2 * len));
+    for (k = first; k <= last; k++)
+    {
+        y = minor_pos + (minor_step * m);
+        if ((y >= 0) && (y < minor_size))
+        {
+            x = pos + (step * k);
+            if (steep)
+            {
+                graphics_put(ctx, b, (int16_t)y, (int16_t)x, color);
+                if (y < box[0]) box[0] = y;
+                if (x < box[1]) box[1] = x;
+                if (y > box[2]) box[2] = y;
+                if (x > box[3]) box[3] = x;
+            }
+            else
+            {
+                graphics_put(ctx, b, (int16_t)x, (int16_t)y, color);
+                if (x < box[0]) box[0] = x;
+                if (y < box[1]) box[1] = y;
+                if (x > box[2]) box[2] = x;
+                if (y > box[3]) box[3] = y;
+            }
+        }
+        else if ((minor_step > 0) ? (y >= minor_size) : (y < 0))
+        {
+            /* gone past the panel */
+            break;
+        }
+        d += 2 * minor_len;
+        if (d >= (2 * len))
+        {
+            d -= 2 * len;
+            m++;
+        }
+    }
+
+    if (box[0] <= box[2])
+    {
+        display_mark_dirty_ctx(ctx, (deasplay_coord_t)box[0], (deasplay_coord_t)box[1],
+                               (deasplay_coord_t)(box[2] - box[0] + 1), (deasplay_coord_t)(box[3] - box[1] + 1));
+    }
+}
+
+/**
+ * Report the area covered by a blit, clipped.
+ */
+static void graphics_blit_mark(t_deasplay *ctx, uint16_t w, uint16_t h, int16_t x, int16_t y)
+{
+    int16_t cw = (w > 0x7FFFU) ? 0x7FFF : (int16_t)w;
+    int16_t ch = (h > 0x7FFFU) ? 0x7FFF : (int16_t)h;
+
+    if (graphics_clip(&x, &cw, (int16_t)ctx->width) && graphics_clip(&y, &ch, (int16_t)(ctx->lines * 8U)))
+    {
+        display_mark_dirty_ctx(ctx, (deasplay_coord_t)x, (deasplay_coord_t)y, (deasplay_coord_t)cw, (deasplay_coord_t)ch);
+    }
+}
+
+void graphics_blit(t_deasplay *ctx, const uint8_t *src, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+
+    if (b == NULL) return;
+    bitmap_blit(b, ctx->width, (uint16_t)(ctx->lines * 8U), src, w, h, x, y, rop);
+    graphics_blit_mark(ctx, w, h, x, y);
+}
+
+void graphics_blit_ram(t_deasplay *ctx, const uint8_t *src, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+
+    if (b == NULL) return;
+    bitmap_blit_ram(b, ctx->width, (uint16_t)(ctx->lines * 8U), src, w, h, x, y, rop);
+    graphics_blit_mark(ctx, w, h, x, y);
+}
+
+int16_t graphics_text(t_deasplay *ctx, const t_bitmap_font *font, int16_t x, int16_t y, const char *str, e_bitmap_rop rop)
+{
+    return graphics_text_scaled(ctx, font, x, y, str, 1U, rop);
+}
+
+int16_t graphics_text_scaled(t_deasplay *ctx, const t_bitmap_font *font, int16_t x, int16_t y, const char *str,
+                             uint8_t scale, e_bitmap_rop rop)
+{
+    uint8_t *b = display_get_buffer_ctx(ctx);
+    int16_t start = x;
+
+    if (b == NULL) return x;
+    if (scale == 0U) scale = 1U;
+    while (*str != '\0')
+    {
+        x = (int16_t)(x + bitmap_font_draw_scaled(b, ctx->width, (uint16_t)(ctx->lines * 8U), font, (uint8_t)*str, x, y, scale, rop));
+        str++;
+    }
+    if (x > start)
+    {
+        graphics_blit_mark(ctx, (uint16_t)(x - start), (uint16_t)(bitmap_font_height(font) * scale), start, y);
+    }
+
+    return x;
+}
@@ -0,0 +1,45 @@
+/*
+ * graphics.h
+ *
+ *  Pixel graphics on the bitmap buffer of a display.
+ *  The bitmap is organized in pages of 8 pixel rows, one byte per column
+ *  (bit 0 is the top row), which is the native layout of SSD1306, PCD8544
+ *  and similar controllers.
+ */
+
+#ifndef DEASPLAY_GRAPHICS_H_
+#define DEASPLAY_GRAPHICS_H_
+
+#include <stdint.h>
+
+#include "deasplay.h"
+#include "bitmap.h"
+
+typedef enum _e_graphics_color
+{
+    GRAPHICS_CLEAR,     /**< Turn pixels off */
+    GRAPHICS_SET,       /**< Turn pixels on */
+    GRAPHICS_XOR        /**< Invert pixels */
+} e_graphics_color;
+
+/* All primitives clip against the panel edges, hence coordinates may be
+ * negative or past the panel size. The touched area is reported through
+ * display_mark_dirty_ctx(). */
+void graphics_pixel(t_deasplay *ctx, int16_t x, int16_t y, e_graphics_color color);
+void graphics_hline(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, e_graphics_color color);
+void graphics_vline(t_deasplay *ctx, int16_t x, int16_t y, int16_t h, e_graphics_color color);
+void graphics_line(t_deasplay *ctx, int16_t x0, int16_t y0, int16_t x1, int16_t y1, e_graphics_color color);
+void graphics_rect(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, int16_t h, e_graphics_color color);
+void graphics_fill_rect(t_deasplay *ctx, int16_t x, int16_t y, int16_t w, int16_t h, e_graphics_color color);
+
+/* Sprites and icons, see bitmap_blit() for the source format */
+void graphics_blit(t_deasplay *ctx, const uint8_t *src, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop);
+void graphics_blit_ram(t_deasplay *ctx, const uint8_t *src, uint16_t w, uint16_t h, int16_t x, int16_t y, e_bitmap_rop rop);
+
+/* Text in any font (see bitmap_font()) at any pixel position, y being the
+ * top of the glyphs. Returns the x coordinate following the text. */
+int16_t graphics_text(t_deasplay *ctx, const t_bitmap_font *font, int16_t x, int16_t y, const char *str, e_bitmap_rop rop);
+int16_t graphics_text_scaled(t_deasplay *ctx, const t_bitmap_font *font, int16_t x, int16_t y, const char *str,
+                             uint8_t scale, e_bitmap_rop rop);
+
+#endif /* DEASPLAY_GRAPHICS_H_ */
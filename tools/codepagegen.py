@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""
+codepagegen.py
+
+ Generates the deasplay codepage tables (see t_codepage in codepage.h):
+ for every code point of the Basic Multilingual Plane, the character
+ code a controller shows it with. Code points the controller has no
+ glyph for are folded onto a look-alike when there is one (accents are
+ dropped, Cyrillic and Greek capitals shaped like Latin ones, typographic
+ quotes and dashes), the others show the fallback code.
+
+ The result is a three level table, 6, 5 and 5 bits of the code point,
+ whose identical blocks are shared: a lookup is three loads.
+
+ Usage: codepagegen.py [--fallback CODE] [--no-fold] [-o file.c] codepage
+        codepagegen.py --list
+
+ Example:
+   codepagegen.py -o codepages/codepage_hd44780_a00.c hd44780_a00
+"""
+
+import argparse
+import sys
+import unicodedata
+
+LEAF_BITS = 5
+MID_BITS = 5
+TOP_BITS = 6
+PLANE = 1 << (LEAF_BITS + MID_BITS + TOP_BITS)
+
+
+def ascii_range(first=0x20, last=0x7E, exclude=()):
+    return {code: chr(code) for code in range(first, last + 1) if code not in exclude}
+
+
+# ---------------------------------------------------------------------------
+# Character sets: native code -> the characters it shows (the first one is
+# the name of the glyph, the others are shown the same way).
+# ---------------------------------------------------------------------------
+
+def hd44780_a00():
+    """HD44780 ROM code A00 (Japanese standard font)."""
+    cs = ascii_range(exclude=(0x5C, 0x7E))
+    cs[0x5C] = "¥"                             # yen sign in place of the backslash
+    cs[0x7E] = "→"
+    cs[0x7F] = "←"
+    for i in range(0x3F):                      # half-width katakana
+        cs[0xA1 + i] = chr(0xFF61 + i)
+    cs[0xA5] += "\u00B7\u2022"                 # katakana middle dot
+    cs[0xDF] += "°"                            # semi-voiced mark, the degree sign on the panel
+    cs.update({
+        0xE0: "α", 0xE1: "ä", 0xE2: "βß", 0xE3: "ε",
+        0xE4: "\u03BC\u00B5", 0xE5: "σ", 0xE6: "ρ", 0xE8: "√",
+        0xEC: "¢", 0xEE: "ñ", 0xEF: "ö", 0xF2: "θ",
+        0xF3: "∞", 0xF4: "ΩΩ", 0xF5: "ü", 0xF6: "\u03A3\u2211",
+        0xF7: "π", 0xFA: "千", 0xFB: "万", 0xFC: "円",
+        0xFD: "÷", 0xFF: "█",
+    })
+    return cs
+
+
+def hd44780_a02():
+    """HD44780 ROM code A02 (European standard font)."""
+    cs = ascii_range()
+    cs.update({
+        0x10: "▶", 0x11: "◀", 0x12: "“", 0x13: "”",
+        0x16: "●", 0x17: "↵", 0x18: "↑", 0x19: "↓",
+        0x1A: "→", 0x1B: "←", 0x1C: "≤", 0x1D: "≥",
+        0x1E: "▲", 0x1F: "▼", 0x7F: "⌂",
+    })
+    cyrillic = "БДЖЗИЙЛПУЦЧШЩЪЫЭ"
+    for i, c in enumerate(cyrillic):
+        cs[0x80 + i] = c
+    symbols = "α♪ΓπΣσ♬τ\u0000ΘΩδ∞♥ε∩"
+    for i, c in enumerate(symbols):
+        if c != "\u0000":                      # 0x98 is a bell, out of the plane
+            cs[0x90 + i] = c
+    upper = ("\u0000¡¢£¤¥¦§ƒ©ª«ЮЯ®‘"
+             "°±²³₧µ¶·ω¹º»¼½¾¿")
+    for i, c in enumerate(upper):
+        if c != "\u0000":
+            cs[0xA0 + i] = c
+    for code in range(0xC0, 0x100):            # Latin-1 letters
+        cs[code] = chr(code)
+    return cs
+
+
+def lc75710():
+    """LC75710 VFD controller (printable ASCII).
+    The upper half of its character ROM depends on the mask option."""
+    return ascii_range()
+
+
+def font5x8():
+    """font5x8 of bitmap.c: ASCII, then Mac OS Roman from 128 on."""
+    cs = ascii_range()
+    cs[0x7F] = "←"
+    for code in range(0x80, 0x100):
+        if code in (0xA0, 0xCA, 0xF0):         # glyphs without a meaning
+            continue
+        cs[code] = bytes([code]).decode("mac_roman")
+    return cs
+
+
+def ascii():
+    """Printable ASCII, e.g. font5x8 with BITMAP_FONT5x8_ASCII."""
+    return ascii_range()
+
+
+CODEPAGES = {
+    "hd44780_a00": hd44780_a00,
+    "hd44780_a02": hd44780_a02,
+    "lc75710": lc75710,
+    "font5x8": font5x8,
+    "ascii": ascii,
+}
+
+# Look-alikes used when a character has no glyph of its own
+FOLDS = {
+    "\u00A0": " ", "\u2007": " ", "\u202F": " ",
+    "\u2018": "'", "\u2019": "'", "\u201A": "'", "\u2032": "'", "\u00B4": "'",
+    "\u201C": "\"", "\u201D": "\"", "\u201E": "\"", "\u2033": "\"", "\u00AB": "\"", "\u00BB": "\"",
+    "\u2010": "-", "\u2011": "-", "\u2012": "-", "\u2013": "-", "\u2014": "-", "\u2212": "-",
+    "\u2026": ".", "\u00B7": ".", "\u2022": ".", "\u00D7": "x", "\u00F7": ":",
+    "\u00DF": "\u03B2", "\u00B5": "u",
+    "\u00C6": "A", "\u00E6": "a", "\u0152": "O", "\u0153": "o", "\u00D8": "O", "\u00F8": "o",
+    "\u0110": "D", "\u0111": "d", "\u0141": "L", "\u0142": "l", "\u0131": "i",
+    # Cyrillic and Greek capitals drawn as Latin ones
+    "\u0410": "A", "\u0412": "B", "\u0415": "E", "\u041A": "K", "\u041C": "M", "\u041D": "H",
+    "\u041E": "O", "\u0420": "P", "\u0421": "C", "\u0422": "T", "\u0425": "X", "\u0401": "E",
+    "\u0391": "A", "\u0392": "B", "\u0395": "E", "\u0396": "Z", "\u0397": "H", "\u0399": "I",
+    "\u039A": "K", "\u039C": "M", "\u039D": "N", "\u039F": "O", "\u03A1": "P", "\u03A4": "T",
+    "\u03A5": "Y", "\u03A7": "X",
+}
+
+
+# Blocks whose accented letters and compatibility forms are folded:
+# Latin-1 and Latin Extended, Greek and Cyrillic, Latin Extended
+# Additional (Vietnamese), punctuation and full-width ASCII
+FOLD_BLOCKS = ((0x00A0, 0x024F), (0x0370, 0x04FF), (0x1E00, 0x1EFF), (0x2000, 0x206F), (0xFF01, 0xFF5E))
+
+
+def base_letter(c):
+    """The character without its accents, if that is a single character."""
+    if not any(first <= ord(c) <= last for first, last in FOLD_BLOCKS):
+        return None
+    decomposed = unicodedata.normalize("NFKD", c)
+    stripped = "".join(d for d in decomposed if not unicodedata.combining(d))
+    if len(stripped) == 1 and stripped != c:
+        return stripped
+    return None
+
+
+def resolve(glyphs, c, fold, depth=0):
+    """Native code showing c, None if there is none."""
+    if c in glyphs:
+        return glyphs[c]
+    if not fold or depth > 3:
+        return None
+    for other in (FOLDS.get(c), base_letter(c), c.upper() if c.upper() != c and len(c.upper()) == 1 else None):
+        if other is not None:
+            code = resolve(glyphs, other, fold, depth + 1)
+            if code is not None:
+                return code
+    return None
+
+
+def build(charset, fallback, fold=True):
+    glyphs = {}
+    for code in sorted(charset):
+        for c in charset[code]:
+            glyphs.setdefault(c, code)
+
+    values = []
+    mapped = 0
+    for cp in range(PLANE):
+        code = None
+        if not 0xD800 <= cp <= 0xDFFF and cp >= 0x20:
+            code = resolve(glyphs, chr(cp), fold)
+        if code is None:
+            code = fallback
+        else:
+            mapped += 1
+        values.append(code)
+
+    # leaves: blocks of consecutive code points, the first one all fallback
+    leaf_size = 1 << LEAF_BITS
+    leaves = [tuple([fallback] * leaf_size)]
+    leaf_index = {leaves[0]: 0}
+    blocks = []
+    for i in range(0, PLANE, leaf_size):
+        leaf = tuple(values[i:i + leaf_size])
+        if leaf not in leaf_index:
+            leaf_index[leaf] = len(leaves)
+            leaves.append(leaf)
+        blocks.append(leaf_index[leaf])
+
+    mid_size = 1 << MID_BITS
+    mids = [tuple([0] * mid_size)]
+    mid_index = {mids[0]: 0}
+    top = []
+    for i in range(0, len(blocks), mid_size):
+        mid = tuple(blocks[i:i + mid_size])
+        if mid not in mid_index:
+            mid_index[mid] = len(mids)
+            mids.append(mid)
+        top.append(mid_index[mid])
+
+    if len(leaves) > 256 or len(mids) > 256:
+        sys.exit("codepagegen: too many blocks")
+    return top, mids, leaves, mapped
+
+
+def rows(values, per_row=16):
+    return ["    " + ",".join("0x%02X" % v for v in values[i:i + per_row]) + ","
+            for i in range(0, len(values), per_row)]
+
+
+def emit(name, doc, fallback, top, mids, leaves, mapped):
+    size = len(top) + (len(mids) << MID_BITS) + (len(leaves) << LEAF_BITS)
+    out = []
+    out.append("/*")
+    out.append(" * codepage_%s.c" % name)
+    out.append(" *")
+    out.append(" *  Code points to character codes: %s" % doc.splitlines()[0])
+    for line in doc.splitlines()[1:]:
+        out.append(" *  %s" % line.strip())
+    out.append(" *  Generated by tools/codepagegen.py, %u code points shown, fallback 0x%02X," % (mapped, fallback))
+    out.append(" *  %u bytes of tables. Do not edit, generate it again instead." % size)
+    out.append(" */")
+    out.append("")
+    out.append("#include \"codepage.h\"")
+    out.append("")
+    out.append("static const uint8_t codepage_%s_top[] CODEPAGE_STORAGE_FLAGS =" % name)
+    out.append("{")
+    out.extend(rows(top))
+    out[-1] = out[-1].rstrip(",")
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t codepage_%s_mid[] CODEPAGE_STORAGE_FLAGS =" % name)
+    out.append("{")
+    for i, mid in enumerate(mids):
+        block = rows(mid)
+        block[0] += " // %u" % i
+        out.extend(block)
+    out[-1] = out[-1].rstrip(",")
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t codepage_%s_leaf[] CODEPAGE_STORAGE_FLAGS =" % name)
+    out.append("{")
+    for i, leaf in enumerate(leaves):
+        block = rows(leaf)
+        block[0] += " // %u" % i
+        out.extend(block)
+    out[-1] = out[-1].rstrip(",")
+    out.append("};")
+    out.append("")
+    out.append("const t_codepage codepage_%s CODEPAGE_STORAGE_FLAGS =" % name)
+    out.append("{")
+    out.append("    .top = codepage_%s_top," % name)
+    out.append("    .mid = codepage_%s_mid," % name)
+    out.append("    .leaf = codepage_%s_leaf," % name)
+    out.append("    .fallback = 0x%02XU" % fallback)
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate deasplay codepage tables")
+    parser.add_argument("codepage", nargs="?", help="character set: " + ", ".join(sorted(CODEPAGES)))
+    parser.add_argument("--fallback", type=lambda v: int(v, 0), default=ord("?"), help="code shown for the characters without a glyph (default: '?')")
+    parser.add_argument("--no-fold", action="store_true", help="show only the characters of the set, no look-alikes (smaller tables)")
+    parser.add_argument("--list", action="store_true", help="list the character sets")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    if args.list:
+        for name in sorted(CODEPAGES):
+            print("%-12s %s" % (name, CODEPAGES[name].__doc__.splitlines()[0]))
+        return
+    if args.codepage not in CODEPAGES:
+        sys.exit("codepagegen: unknown character set, see --list")
+
+    top, mids, leaves, mapped = build(CODEPAGES[args.codepage](), args.fallback, not args.no_fold)
+    text = emit(args.codepage, CODEPAGES[args.codepage].__doc__, args.fallback, top, mids, leaves, mapped)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
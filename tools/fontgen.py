@@ -0,0 +1,627 @@
+#!/usr/bin/env python3
+"""
+fontgen.py
+
+ Converts BDF bitmap fonts and TrueType outline fonts into deasplay font
+ tables (see t_bitmap_font in bitmap.h). TrueType glyphs are rasterized
+ by a small built-in renderer, hence no third party module is needed.
+
+ Usage: fontgen.py [options] source.bdf|source.ttf > font.c
+
+ Examples:
+   fontgen.py --name font_8x16 --width 8 --height 16 --size 13 cour.ttf
+   fontgen.py --name font_digits --width 12 --height 24 --fit \\
+              --codes "32,45-58" --encoding rle SourceCodePro-Regular.ttf
+   fontgen.py --name font_prop --height 13 --codes 32-126 helvR10.bdf
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+ENCODINGS = ("raw", "rle", "bits")
+
+
+# ---------------------------------------------------------------------------
+# Sources. Every source renders a code into (advance, pixels), pixels being
+# a set of (x, y) with x relative to the pen position and y relative to the
+# baseline (negative above).
+# ---------------------------------------------------------------------------
+
+class BdfFont:
+    def __init__(self, path):
+        self.glyphs = {}
+        self.ascent = 0
+        self.descent = 0
+        with open(path, "r", encoding="latin-1") as f:
+            lines = iter(f.read().splitlines())
+        code = None
+        advance = 0
+        bbx = (0, 0, 0, 0)
+        for line in lines:
+            words = line.split()
+            if not words:
+                continue
+            key = words[0]
+            if key == "FONT_ASCENT":
+                self.ascent = int(words[1])
+            elif key == "FONT_DESCENT":
+                self.descent = int(words[1])
+            elif key == "ENCODING":
+                code = int(words[1])
+            elif key == "DWIDTH":
+                advance = int(words[1])
+            elif key == "BBX":
+                bbx = tuple(int(w) for w in words[1:5])
+            elif key == "BITMAP":
+                w, h, xo, yo = bbx
+                pixels = set()
+                for r in range(h):
+                    row = int(next(lines).strip() or "0", 16)
+                    bits = ((w + 7) // 8) * 8
+                    for c in range(w):
+                        if row & (1 << (bits - 1 - c)):
+                            pixels.add((xo + c, -(yo + h) + r))
+                if code is not None and code >= 0:
+                    self.glyphs[code] = (advance, pixels)
+                code = None
+
+    def metrics(self, args):
+        return self.ascent, self.descent
+
+    def render(self, code, args):
+        return self.glyphs.get(code)
+
+
+class TrueTypeFont:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        self.tables = {}
+        count = struct.unpack(">H", self.data[4:6])[0]
+        for i in range(count):
+            tag, _, offset, length = struct.unpack(">4sIII", self.data[12 + 16 * i:28 + 16 * i])
+            self.tables[tag.decode("latin-1")] = (offset, length)
+        if "glyf" not in self.tables:
+            sys.exit("fontgen: %s has no TrueType outlines (glyf table)" % path)
+        head = self.table("head")
+        self.units = struct.unpack(">H", head[18:20])[0]
+        self.long_loca = struct.unpack(">h", head[50:52])[0] != 0
+        hhea = self.table("hhea")
+        self.ascender, self.descender = struct.unpack(">hh", hhea[4:8])
+        self.hmetrics = struct.unpack(">H", hhea[34:36])[0]
+        self.cmap = self.parse_cmap()
+        self.scale_x = None
+        self.scale_y = None
+        self.offset_x = 0.0
+
+    def table(self, tag):
+        offset, length = self.tables[tag]
+        return self.data[offset:offset + length]
+
+    def parse_cmap(self):
+        cmap = self.table("cmap")
+        count = struct.unpack(">H", cmap[2:4])[0]
+        best = None
+        for i in range(count):
+            platform, encoding, offset = struct.unpack(">HHI", cmap[4 + 8 * i:12 + 8 * i])
+            if struct.unpack(">H", cmap[offset:offset + 2])[0] == 4 and \
+               (platform == 0 or (platform == 3 and encoding in (0, 1))):
+                best = offset
+        if best is None:
+            sys.exit("fontgen: no Unicode BMP character map")
+        sub = cmap[best:]
+        segs = struct.unpack(">H", sub[6:8])[0] // 2
+        ends = struct.unpack(">%dH" % segs, sub[14:14 + 2 * segs])
+        base = 16 + 2 * segs
+        starts = struct.unpack(">%dH" % segs, sub[base:base + 2 * segs])
+        deltas = struct.unpack(">%dh" % segs, sub[base + 2 * segs:base + 4 * segs])
+        ranges_at = base + 4 * segs
+        ranges = struct.unpack(">%dH" % segs, sub[ranges_at:ranges_at + 2 * segs])
+        mapping = {}
+        for s in range(segs):
+            for c in range(starts[s], ends[s] + 1):
+                if c == 0xFFFF:
+                    continue
+                if ranges[s] == 0:
+                    g = (c + deltas[s]) & 0xFFFF
+                else:
+                    at = ranges_at + 2 * s + ranges[s] + 2 * (c - starts[s])
+                    g = struct.unpack(">H", sub[at:at + 2])[0]
+                    if g != 0:
+                        g = (g + deltas[s]) & 0xFFFF
+                if g != 0:
+                    mapping[c] = g
+        return mapping
+
+    def advance(self, glyph):
+        hmtx = self.table("hmtx")
+        i = min(glyph, self.hmetrics - 1)
+        return struct.unpack(">H", hmtx[4 * i:4 * i + 2])[0]
+
+    def glyph_data(self, glyph):
+        loca = self.table("loca")
+        if self.long_loca:
+            start, end = struct.unpack(">II", loca[4 * glyph:4 * glyph + 8])
+        else:
+            start, end = struct.unpack(">HH", loca[2 * glyph:2 * glyph + 4])
+            start, end = start * 2, end * 2
+        return self.table("glyf")[start:end]
+
+    def contours(self, glyph, depth=0):
+        """Outline of a glyph as a list of contours of (x, y, on_curve)."""
+        data = self.glyph_data(glyph)
+        if len(data) < 10 or depth > 8:
+            return []
+        ncontours = struct.unpack(">h", data[0:2])[0]
+        if ncontours < 0:
+            return self.compound(data, depth)
+        ends = struct.unpack(">%dH" % ncontours, data[10:10 + 2 * ncontours])
+        npoints = ends[-1] + 1 if ncontours else 0
+        at = 10 + 2 * ncontours
+        at += 2 + struct.unpack(">H", data[at:at + 2])[0]
+        flags = []
+        while len(flags) < npoints:
+            flag = data[at]
+            at += 1
+            flags.append(flag)
+            if flag & 8:
+                flags.extend([flag] * data[at])
+                at += 1
+        coords = []
+        for short, same in ((2, 16), (4, 32)):
+            value = 0
+            values = []
+            for flag in flags[:npoints]:
+                if flag & short:
+                    delta = data[at]
+                    at += 1
+                    value += delta if flag & same else -delta
+                elif not flag & same:
+                    value += struct.unpack(">h", data[at:at + 2])[0]
+                    at += 2
+                values.append(value)
+            coords.append(values)
+        result = []
+        first = 0
+        for end in ends:
+            result.append([(coords[0][i], coords[1][i], bool(flags[i] & 1)) for i in range(first, end + 1)])
+            first = end + 1
+        return result
+
+    def compound(self, data, depth):
+        result = []
+        at = 10
+        while True:
+            flags, glyph = struct.unpack(">HH", data[at:at + 4])
+            at += 4
+            if flags & 1:
+                dx, dy = struct.unpack(">hh", data[at:at + 4])
+                at += 4
+            else:
+                dx, dy = struct.unpack(">bb", data[at:at + 2])
+                at += 2
+            if not flags & 2:
+                dx = dy = 0     # point matching is not supported
+            a, b, c, d = 1.0, 0.0, 0.0, 1.0
+            if flags & 8:
+                a = d = struct.unpack(">h", data[at:at + 2])[0] / 16384.0
+                at += 2
+            elif flags & 0x40:
+                a, d = (v / 16384.0 for v in struct.unpack(">hh", data[at:at + 4]))
+                at += 4
+            elif flags & 0x80:
+                a, b, c, d = (v / 16384.0 for v in struct.unpack(">hhhh", data[at:at + 8]))
+                at += 8
+            for contour in self.contours(glyph, depth + 1):
+                result.append([(x * a + y * c + dx, x * b + y * d + dy, on) for x, y, on in contour])
+            if not flags & 0x20:
+                return result
+
+    @staticmethod
+    def flatten(contour, steps=8):
+        """Turn a quadratic contour into a closed polyline."""
+        points = []
+        n = len(contour)
+        # start from an on-curve point, or from the implied midpoint
+        start = next((i for i in range(n) if contour[i][2]), None)
+        if start is None:
+            p, q = contour[0], contour[1 % n]
+            origin = ((p[0] + q[0]) / 2.0, (p[1] + q[1]) / 2.0)
+            start = 0
+        else:
+            origin = contour[start][:2]
+            start += 1
+        points.append(origin)
+        control = None
+        for k in range(n):
+            x, y, on = contour[(start + k) % n]
+            if on:
+                if control is None:
+                    points.append((x, y))
+                else:
+                    TrueTypeFont.bezier(points, control, (x, y), steps)
+                    control = None
+            else:
+                if control is not None:
+                    middle = ((control[0] + x) / 2.0, (control[1] + y) / 2.0)
+                    TrueTypeFont.bezier(points, control, middle, steps)
+                control = (x, y)
+        if control is not None:
+            TrueTypeFont.bezier(points, control, origin, steps)
+        return points
+
+    @staticmethod
+    def bezier(points, control, end, steps):
+        x0, y0 = points[-1]
+        for s in range(1, steps + 1):
+            t = s / float(steps)
+            u = 1.0 - t
+            points.append((u * u * x0 + 2 * u * t * control[0] + t * t * end[0],
+                           u * u * y0 + 2 * u * t * control[1] + t * t * end[1]))
+
+    def setup(self, args, codes):
+        size = [float(v) for v in str(args.size or args.height).split(",")]
+        self.scale_x = size[0] / self.units
+        self.scale_y = size[-1] / self.units
+        self.offset_x = 0.0
+        self.baseline = None
+        if args.fit:
+            # stretch the ink box of the selected glyphs over the cell
+            boxes = []
+            for code in codes:
+                if code in self.cmap:
+                    pts = [p for c in self.contours(self.cmap[code]) for p in c]
+                    if pts:
+                        boxes.append((min(p[0] for p in pts), min(p[1] for p in pts),
+                                      max(p[0] for p in pts), max(p[1] for p in pts)))
+            if not boxes:
+                sys.exit("fontgen: nothing to fit")
+            x0 = min(b[0] for b in boxes)
+            y0 = min(b[1] for b in boxes)
+            x1 = max(b[2] for b in boxes)
+            y1 = max(b[3] for b in boxes)
+            margin = args.fit_margin
+            self.scale_x = (args.width - 2 * margin) / float(x1 - x0)
+            self.scale_y = (args.height - 2 * margin) / float(y1 - y0)
+            self.offset_x = margin - x0 * self.scale_x
+            self.baseline = margin + y1 * self.scale_y
+
+    def metrics(self, args):
+        if self.baseline is not None:
+            return int(round(self.baseline)), args.height - int(round(self.baseline))
+        return int(round(self.ascender * self.scale_y)), int(round(-self.descender * self.scale_y))
+
+    def render(self, code, args):
+        glyph = self.cmap.get(code)
+        if glyph is None:
+            return None
+        advance = self.advance(glyph) * self.scale_x
+        if args.fit:
+            advance = args.width
+        origin_y = self.baseline if self.baseline is not None else 0.0
+        edges = []
+        for contour in self.contours(glyph):
+            poly = [(x * self.scale_x + self.offset_x, origin_y - y * self.scale_y) for x, y in self.flatten(contour)]
+            for i in range(len(poly)):
+                edges.append((poly[i - 1], poly[i]))
+        pixels = set()
+        if edges:
+            pixels = self.rasterize(edges, args.threshold)
+            if self.baseline is not None:
+                # fitted glyphs are laid out from the cell top
+                top = int(round(self.baseline))
+                pixels = set((x, y - top) for x, y in pixels)
+        return int(round(advance)), pixels
+
+    @staticmethod
+    def rasterize(edges, threshold, sub=5):
+        """Area coverage by horizontal sub-scanlines and the non-zero rule."""
+        ys = [p[1] for e in edges for p in e]
+        row0 = int(min(ys)) - 1
+        row1 = int(max(ys)) + 1
+        coverage = {}
+        for row in range(row0, row1 + 1):
+            for s in range(sub):
+                y = row + (s + 0.5) / sub
+                crossings = []
+                for (xa, ya), (xb, yb) in edges:
+                    if (ya <= y < yb) or (yb <= y < ya):
+                        x = xa + (y - ya) * (xb - xa) / (yb - ya)
+                        crossings.append((x, 1 if yb > ya else -1))
+                crossings.sort()
+                winding = 0
+                for i, (x, w) in enumerate(crossings):
+                    if winding != 0:
+                        # cover [crossings[i - 1], x]
+                        left = crossings[i - 1][0]
+                        col = int(left) if left >= 0 else int(left) - 1
+                        while col < x:
+                            a = max(left, col)
+                            b = min(x, col + 1)
+                            if b > a:
+                                coverage[(col, row)] = coverage.get((col, row), 0.0) + (b - a) / sub
+                            col += 1
+                    winding += w
+        return set(k for k, v in coverage.items() if v >= threshold)
+
+
+# ---------------------------------------------------------------------------
+# Glyph encodings
+# ---------------------------------------------------------------------------
+
+def pages(height):
+    return (height + 7) // 8
+
+
+def encode_raw(columns, height):
+    """Pages of one byte per column, as the bitmap buffer."""
+    out = []
+    for p in range(pages(height)):
+        out.extend((c >> (8 * p)) & 0xFF for c in columns)
+    return out
+
+
+def encode_bits(columns, height):
+    """Columns of 'height' bits, packed back to back from the LSB."""
+    out = []
+    acc = 0
+    n = 0
+    for c in columns:
+        acc |= (c & ((1 << height) - 1)) << n
+        n += height
+        while n >= 8:
+            out.append(acc & 0xFF)
+            acc >>= 8
+            n -= 8
+    if n:
+        out.append(acc & 0xFF)
+    return out
+
+
+def encode_rle(columns, height):
+    """Raw bytes as packets: 0x00-0x7F copy n + 1 bytes, 0x80-0xFF repeat
+    the next byte (n & 0x7F) + 1 times."""
+    raw = encode_raw(columns, height)
+    out = []
+    literal = []
+    i = 0
+    while i < len(raw):
+        run = 1
+        while i + run < len(raw) and raw[i + run] == raw[i] and run < 128:
+            run += 1
+        if run >= 3 or (run == 2 and not literal):
+            if literal:
+                out.append(len(literal) - 1)
+                out.extend(literal)
+                literal = []
+            out.extend((0x80 | (run - 1), raw[i]))
+            i += run
+        else:
+            literal.append(raw[i])
+            i += 1
+            if len(literal) == 128:
+                out.append(127)
+                out.extend(literal)
+                literal = []
+    if literal:
+        out.append(len(literal) - 1)
+        out.extend(literal)
+    return out
+
+
+ENCODERS = {"raw": encode_raw, "rle": encode_rle, "bits": encode_bits}
+
+
+# ---------------------------------------------------------------------------
+# Table generation
+# ---------------------------------------------------------------------------
+
+def parse_codes(text):
+    codes = []
+    for part in text.split(","):
+        part = part.strip()
+        if not part:
+            continue
+        if "-" in part[1:]:
+            first, last = part.split("-", 1) if part[0] != "-" else ("-", part[2:])
+            first, last = int(first, 0), int(last, 0)
+        else:
+            first = last = int(part, 0)
+        codes.extend(range(first, last + 1))
+    codes = sorted(set(codes))
+    if not codes or codes[0] < 0 or codes[-1] > 255:
+        sys.exit("fontgen: codes must be in 0-255")
+    return codes
+
+
+def layout(source, args, codes):
+    """Render every code into a list of columns of the cell height."""
+    ascent, descent = source.metrics(args)
+    height = args.height or (ascent + descent)
+    baseline = args.baseline if args.baseline is not None else ascent
+    glyphs = {}
+    for code in codes:
+        rendered = source.render(code, args)
+        if rendered is None:
+            continue
+        advance, pixels = rendered
+        if args.width:
+            width = args.width
+            shift = 0 if args.fit else (width - advance) // 2
+        else:
+            width = max(advance, 1)
+            shift = 0
+        columns = [0] * width
+        for x, y in pixels:
+            x += shift
+            y += baseline
+            if 0 <= x < width and 0 <= y < height:
+                columns[x] |= 1 << y
+        glyphs[code] = columns
+    return height, glyphs
+
+
+def ranges_of(codes):
+    ranges = []
+    for code in codes:
+        if ranges and ranges[-1][1] == code - 1:
+            ranges[-1][1] = code
+        else:
+            ranges.append([code, code])
+    return ranges
+
+
+def c_bytes(values, indent="    ", per_line=16):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(indent + ",".join("0x%02X" % v for v in values[i:i + per_line]) + ",")
+    if lines:
+        lines[-1] = lines[-1][:-1]
+    return "\n".join(lines)
+
+
+def emit(args, height, glyphs):
+    name = args.name
+    codes = sorted(glyphs)
+    proportional = not args.width
+    width = args.width or max(len(c) for c in glyphs.values())
+    if pages(height) * width > 255:
+        sys.exit("fontgen: glyphs are limited to 255 bytes")
+
+    encoding = args.encoding
+    if encoding == "auto":
+        # the smallest data, counting the offsets it needs
+        def size(e):
+            offsets = 2 * len(codes) if (proportional or e == "rle") else 0
+            return offsets + sum(len(ENCODERS[e](glyphs[c], height)) for c in codes)
+        encoding = min(ENCODINGS, key=size)
+
+    data = []
+    offsets = []
+    comments = []
+    for code in codes:
+        offsets.append(len(data))
+        encoded = ENCODERS[encoding](glyphs[code], height)
+        comments.append((len(data), len(encoded), code))
+        data.extend(encoded)
+    if len(data) > 0xFFFF:
+        sys.exit("fontgen: more than 64 KiB of glyph data")
+
+    # fixed fonts stored raw or bit-packed are indexed without offsets
+    with_offsets = proportional or encoding == "rle"
+    ranges = ranges_of(codes)
+    fallback = args.fallback if args.fallback is not None else (ord("?") if ord("?") in glyphs else codes[0])
+
+    out = []
+    out.append("/*")
+    out.append(" * %s" % (os.path.basename(args.output) if args.output else name + ".c"))
+    out.append(" *")
+    out.append(" *  %s %ux%u font generated by tools/fontgen.py from %s," %
+               ("Proportional" if proportional else "Fixed", width, height, os.path.basename(args.source)))
+    out.append(" *  %u glyphs, %s encoded, %u bytes of glyph data." % (len(codes), encoding, len(data)))
+    for line in args.comment or []:
+        out.append(" *  %s" % line)
+    out.append(" *  Do not edit, generate it again instead.")
+    out.append(" */")
+    out.append("")
+    out.append('#include "bitmap.h"')
+    out.append("")
+    out.append("static const uint8_t %s_data[] BITMAP_STORAGE_FLAGS =" % name)
+    out.append("{")
+    for i, (start, length, code) in enumerate(comments):
+        label = chr(code) if 32 < code < 127 and chr(code) not in "\\" else ""
+        line = ",".join("0x%02X" % v for v in data[start:start + length])
+        tail = "," if i + 1 < len(comments) else ""
+        out.append(("    %s%s // %u %s" % (line, tail, code, label)).rstrip())
+    out.append("};")
+    out.append("")
+    if with_offsets:
+        out.append("static const uint16_t %s_offsets[] BITMAP_STORAGE_FLAGS =" % name)
+        out.append("{")
+        for i in range(0, len(offsets), 8):
+            out.append("    " + ", ".join("%u" % o for o in offsets[i:i + 8]) + ("," if i + 8 < len(offsets) else ""))
+        out.append("};")
+        out.append("")
+    if proportional:
+        out.append("static const uint8_t %s_widths[] BITMAP_STORAGE_FLAGS =" % name)
+        out.append("{")
+        out.append(c_bytes([len(glyphs[c]) for c in codes]))
+        out.append("};")
+        out.append("")
+    out.append("static const t_bitmap_font_range %s_ranges[] BITMAP_STORAGE_FLAGS =" % name)
+    out.append("{")
+    index = 0
+    for i, (first, last) in enumerate(ranges):
+        out.append("    { %uU, %uU, %uU }%s" % (first, last, index, "," if i + 1 < len(ranges) else ""))
+        index += last - first + 1
+    out.append("};")
+    out.append("")
+    out.append("const t_bitmap_font %s BITMAP_STORAGE_FLAGS =" % name)
+    out.append("{")
+    out.append("    .width = %uU," % width)
+    out.append("    .height = %uU," % height)
+    out.append("    .encoding = BITMAP_FONT_%s," % encoding.upper())
+    out.append("    .ranges = %uU," % len(ranges))
+    out.append("    .fallback = %uU," % fallback)
+    out.append("    .range = %s_ranges," % name)
+    out.append("    .widths = %s," % ("%s_widths" % name if proportional else "NULL"))
+    out.append("    .offsets = %s," % ("%s_offsets" % name if with_offsets else "NULL"))
+    out.append("    .data = %s_data" % name)
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def preview(height, glyphs):
+    for code in sorted(glyphs):
+        sys.stderr.write("%u:\n" % code)
+        for y in range(height):
+            sys.stderr.write("".join("#" if c & (1 << y) else "." for c in glyphs[code]) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate deasplay font tables from BDF or TrueType fonts")
+    parser.add_argument("source", help="BDF or TrueType (.ttf) font")
+    parser.add_argument("--name", required=True, help="C name of the font descriptor")
+    parser.add_argument("--codes", default="32-126", help="codes to include, e.g. \"32-126,176\" (default: printable ASCII)")
+    parser.add_argument("--width", type=int, default=0, help="fixed cell width (default: proportional)")
+    parser.add_argument("--height", type=int, default=0, help="cell height (default: font ascent + descent)")
+    parser.add_argument("--baseline", type=int, default=None, help="baseline row in the cell (default: font ascent)")
+    parser.add_argument("--size", default=None, help="TrueType: pixels per em, or \"x,y\" (default: the cell height)")
+    parser.add_argument("--fit", action="store_true", help="TrueType: stretch the selected glyphs over the whole fixed cell")
+    parser.add_argument("--fit-margin", type=int, default=1, help="TrueType: blank pixels around fitted glyphs (default: 1)")
+    parser.add_argument("--threshold", type=float, default=0.5, help="TrueType: pixel coverage turning a pixel on (default: 0.5)")
+    parser.add_argument("--encoding", choices=ENCODINGS + ("auto",), default="auto", help="glyph encoding (default: the smallest)")
+    parser.add_argument("--fallback", type=lambda v: int(v, 0), default=None, help="code drawn for missing codes (default: '?')")
+    parser.add_argument("--comment", action="append", help="line added to the header comment (e.g. the font license)")
+    parser.add_argument("--preview", action="store_true", help="draw the glyphs on stderr")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    codes = parse_codes(args.codes)
+    if args.fit and not (args.width and args.height):
+        sys.exit("fontgen: --fit needs --width and --height")
+    if args.source.lower().endswith(".bdf"):
+        if args.fit or args.size:
+            sys.exit("fontgen: --fit and --size apply to TrueType fonts only")
+        source = BdfFont(args.source)
+    else:
+        source = TrueTypeFont(args.source)
+        source.setup(args, codes)
+
+    height, glyphs = layout(source, args, codes)
+    if not glyphs:
+        sys.exit("fontgen: none of the codes is in the font")
+    if args.preview:
+        preview(height, glyphs)
+    text = emit(args, height, glyphs)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()